@@ -1,10 +1,56 @@
-from typing import Dict, List
+from typing import Callable, ClassVar, Dict, List, Optional, overload
+
+class AnytimeOptions:
+    def __init__(self) -> None: ...
+    @property
+    def cancellation(self) -> CancellationToken: ...
+    @cancellation.setter
+    def cancellation(self, val: CancellationToken) -> None: ...
+    @property
+    def modelsPerBatch(self) -> int: ...
+    @modelsPerBatch.setter
+    def modelsPerBatch(self, val: int) -> None: ...
+    @property
+    def progress(self) -> Callable[[FitProgress],None]: ...
+    @progress.setter
+    def progress(self, val: Callable[[FitProgress],None]) -> None: ...
+    @property
+    def timeLimit(self) -> float: ...
+    @timeLimit.setter
+    def timeLimit(self, val: float) -> None: ...
+
+class CancellationToken:
+    def __init__(self) -> None: ...
+    def cancel(self) -> None: ...
+    def isCancelled(self) -> bool: ...
 
 class DDM:
     def __init__(self, d: float, sigma: float, barrier: float = ..., nonDecisionTime: int = ..., bias: float = ..., decay: float = ...) -> None: ...
     def exportTrial(self, dt: DDMTrial, filename: str) -> None: ...
+    @overload
+    @classmethod
+    def fitModelAnytime(cls, trials: List[DDMTrial], rangeD: List[float], rangeSigma: List[float], computeMethod: str = ..., barrier: float = ..., nonDecisionTime: int = ..., bias: List[float] = ..., decay: List[float] = ..., timeStep: int = ..., approxStateStep: float = ..., trialsPerThread: int = ..., options: AnytimeOptions = ...) -> MLEinfoDDM: ...
+    @overload
+    @classmethod
+    def fitModelAnytime(cls, trials: TrialBatch, rangeD: List[float], rangeSigma: List[float], computeMethod: str = ..., barrier: float = ..., nonDecisionTime: int = ..., bias: List[float] = ..., decay: List[float] = ..., timeStep: int = ..., approxStateStep: float = ..., trialsPerThread: int = ..., options: AnytimeOptions = ...) -> MLEinfoDDM: ...
+    @overload
+    @classmethod
+    def fitModelMLE(cls, trials: List[DDMTrial], rangeD: List[float], rangeSigma: List[float], computeMethod: str = ..., normalizePosteriors: bool = ..., barrier: float = ..., nonDecisionTime: int = ..., bias: List[float] = ..., decay: List[float] = ..., timeStep: int = ..., approxStateStep: float = ..., trialsPerThread: int = ..., refinementLevels: int = ..., refinementNeighborhoods: int = ..., pruning: bool = ..., screening: ScreeningOptions = ...) -> MLEinfoDDM: ...
+    @overload
+    @classmethod
+    def fitModelMLE(cls, trials: TrialBatch, rangeD: List[float], rangeSigma: List[float], computeMethod: str = ..., normalizePosteriors: bool = ..., barrier: float = ..., nonDecisionTime: int = ..., bias: List[float] = ..., decay: List[float] = ..., timeStep: int = ..., approxStateStep: float = ..., trialsPerThread: int = ..., refinementLevels: int = ..., refinementNeighborhoods: int = ..., pruning: bool = ..., screening: ScreeningOptions = ...) -> MLEinfoDDM: ...
+    @overload
+    @classmethod
+    def fitModelOptimize(cls, trials: List[DDMTrial], rangeD: List[float], rangeSigma: List[float], computeMethod: str = ..., barrier: float = ..., nonDecisionTime: int = ..., bias: List[float] = ..., decay: List[float] = ..., timeStep: int = ..., approxStateStep: float = ..., trialsPerThread: int = ..., warmStart: Optional[DDM] = ..., options: OptimizerOptions = ...) -> MLEinfoDDM: ...
+    @overload
+    @classmethod
+    def fitModelOptimize(cls, trials: TrialBatch, rangeD: List[float], rangeSigma: List[float], computeMethod: str = ..., barrier: float = ..., nonDecisionTime: int = ..., bias: List[float] = ..., decay: List[float] = ..., timeStep: int = ..., approxStateStep: float = ..., trialsPerThread: int = ..., warmStart: Optional[DDM] = ..., options: OptimizerOptions = ...) -> MLEinfoDDM: ...
+    @overload
     @classmethod
-    def fitModelMLE(cls, trials: List[DDMTrial], rangeD: List[float], rangeSigma: List[float], normalizePosteriors: bool = ..., barrier: float = ..., nonDecisionTime: int = ..., bias: List[float] = ..., decay: List[float] = ...) -> MLEinfoDDM: ...
+    def fitModelStreaming(cls, trials: List[DDMTrial], rangeD: List[float], rangeSigma: List[float], computeMethod: str = ..., barrier: float = ..., nonDecisionTime: int = ..., bias: List[float] = ..., decay: List[float] = ..., timeStep: int = ..., approxStateStep: float = ..., trialsPerThread: int = ..., topK: int = ..., modelsPerBatch: int = ...) -> MLEinfoDDM: ...
+    @overload
+    @classmethod
+    def fitModelStreaming(cls, trials: TrialBatch, rangeD: List[float], rangeSigma: List[float], computeMethod: str = ..., barrier: float = ..., nonDecisionTime: int = ..., bias: List[float] = ..., decay: List[float] = ..., timeStep: int = ..., approxStateStep: float = ..., trialsPerThread: int = ..., topK: int = ..., modelsPerBatch: int = ...) -> MLEinfoDDM: ...
     def simulateTrial(self, valueLeft: int, valueRight: int, timeStep: int = ..., seed: int = ...) -> DDMTrial: ...
     @property
     def barrier(self) -> float: ...
@@ -38,6 +84,28 @@ class DDMTrial:
     @property
     def valueRight(self) -> int: ...
 
+class Fidelity:
+    Coarse: ClassVar[Fidelity] = ...
+    Fine: ClassVar[Fidelity] = ...
+    def __init__(self, value: int) -> None: ...
+    @property
+    def name(self) -> str: ...
+    @property
+    def value(self) -> int: ...
+
+class FitProgress:
+    def __init__(self, *args, **kwargs) -> None: ...
+    @property
+    def bestNLL(self) -> float: ...
+    @property
+    def elapsedSeconds(self) -> float: ...
+    @property
+    def etaSeconds(self) -> float: ...
+    @property
+    def modelsDone(self) -> int: ...
+    @property
+    def numModels(self) -> int: ...
+
 class FixationData:
     def __init__(self, probFixLeftFirst: float, latencies: List[int], transitions: List[int], fixations: Dict[int,List[float]]) -> None: ...
     @property
@@ -52,16 +120,92 @@ class FixationData:
 class MLEinfoDDM:
     def __init__(self, *args, **kwargs) -> None: ...
     @property
+    def complete(self) -> bool: ...
+    @property
+    def converged(self) -> bool: ...
+    @property
+    def fidelities(self) -> Dict[DDM,Fidelity]: ...
+    @property
+    def grid(self) -> ParameterGrid: ...
+    @property
     def likelihoods(self) -> Dict[DDM,float]: ...
     @property
+    def marginals(self) -> List[List[float]]: ...
+    @property
+    def numEvaluations(self) -> int: ...
+    @property
     def optimal(self) -> DDM: ...
+    @property
+    def topModels(self) -> Dict[DDM,ProbabilityData]: ...
 
 class MLEinfoaDDM:
     def __init__(self, *args, **kwargs) -> None: ...
     @property
+    def complete(self) -> bool: ...
+    @property
+    def converged(self) -> bool: ...
+    @property
+    def fidelities(self) -> Dict[aDDM,Fidelity]: ...
+    @property
+    def grid(self) -> ParameterGrid: ...
+    @property
     def likelihoods(self) -> Dict[aDDM,float]: ...
     @property
+    def marginals(self) -> List[List[float]]: ...
+    @property
+    def numEvaluations(self) -> int: ...
+    @property
     def optimal(self) -> aDDM: ...
+    @property
+    def topModels(self) -> Dict[aDDM,ProbabilityData]: ...
+
+class NLLGradient:
+    def __init__(self, *args, **kwargs) -> None: ...
+    @property
+    def NLL(self) -> float: ...
+    @property
+    def gradient(self) -> List[float]: ...
+
+class OptimizerOptions:
+    def __init__(self) -> None: ...
+    @property
+    def fTolerance(self) -> float: ...
+    @fTolerance.setter
+    def fTolerance(self, val: float) -> None: ...
+    @property
+    def gTolerance(self) -> float: ...
+    @gTolerance.setter
+    def gTolerance(self, val: float) -> None: ...
+    @property
+    def historySize(self) -> int: ...
+    @historySize.setter
+    def historySize(self, val: int) -> None: ...
+    @property
+    def initialStep(self) -> float: ...
+    @initialStep.setter
+    def initialStep(self, val: float) -> None: ...
+    @property
+    def maxEvaluations(self) -> int: ...
+    @maxEvaluations.setter
+    def maxEvaluations(self, val: int) -> None: ...
+    @property
+    def xTolerance(self) -> float: ...
+    @xTolerance.setter
+    def xTolerance(self, val: float) -> None: ...
+
+class ParameterGrid:
+    def __init__(self, names: List[str], axes: List[List[float]], storeValues: bool = ...) -> None: ...
+    def coordinates(self, index: int) -> List[int]: ...
+    def find(self, parameters: List[float]) -> int: ...
+    def index(self, coordinates: List[int]) -> int: ...
+    def parameters(self, index: int) -> List[float]: ...
+    def size(self) -> int: ...
+    @property
+    def axes(self) -> List[List[float]]: ...
+    @property
+    def names(self) -> List[str]: ...
+    @property
+    def values(self) -> List[float]: ...
 
 class ProbabilityData:
     def __init__(self, likelihood: float = ..., NLL: float = ...) -> None: ...
@@ -72,11 +216,147 @@ class ProbabilityData:
     @property
     def trialLikelihoods(self) -> List[float]: ...
 
+class PropagationOptions:
+    def __init__(self) -> None: ...
+    @property
+    def lockstep(self) -> bool: ...
+    @lockstep.setter
+    def lockstep(self, val: bool) -> None: ...
+    @property
+    def prefixSharing(self) -> bool: ...
+    @prefixSharing.setter
+    def prefixSharing(self, val: bool) -> None: ...
+    @property
+    def skipAhead(self) -> bool: ...
+    @skipAhead.setter
+    def skipAhead(self, val: bool) -> None: ...
+    @property
+    def skipAheadMinSteps(self) -> int: ...
+    @skipAheadMinSteps.setter
+    def skipAheadMinSteps(self, val: int) -> None: ...
+    @property
+    def supportEpsilon(self) -> float: ...
+    @supportEpsilon.setter
+    def supportEpsilon(self, val: float) -> None: ...
+    @property
+    def tailMass(self) -> float: ...
+    @tailMass.setter
+    def tailMass(self, val: float) -> None: ...
+
+class ScreeningOptions:
+    def __init__(self) -> None: ...
+    @property
+    def approxStateStep(self) -> float: ...
+    @approxStateStep.setter
+    def approxStateStep(self, val: float) -> None: ...
+    @property
+    def enabled(self) -> bool: ...
+    @enabled.setter
+    def enabled(self, val: bool) -> None: ...
+    @property
+    def margin(self) -> float: ...
+    @margin.setter
+    def margin(self, val: float) -> None: ...
+    @property
+    def timeStep(self) -> int: ...
+    @timeStep.setter
+    def timeStep(self, val: int) -> None: ...
+    @property
+    def topFraction(self) -> float: ...
+    @topFraction.setter
+    def topFraction(self, val: float) -> None: ...
+
+class TrialBatch:
+    @overload
+    def __init__(self, trials: List[aDDMTrial]) -> None: ...
+    @overload
+    def __init__(self, trials: List[DDMTrial]) -> None: ...
+    @overload
+    def __init__(self, store: TrialStore) -> None: ...
+    def DDMTrials(self) -> List[DDMTrial]: ...
+    def aDDMTrials(self) -> List[aDDMTrial]: ...
+    def numFixations(self) -> int: ...
+    def size(self) -> int: ...
+    def trial(self, index: int) -> aDDMTrial: ...
+    @property
+    def RT(self) -> List[int]: ...
+    @property
+    def choice(self) -> List[int]: ...
+    @property
+    def fixItem(self) -> List[int]: ...
+    @property
+    def fixOffsets(self) -> List[int]: ...
+    @property
+    def fixTime(self) -> List[int]: ...
+    @property
+    def valueLeft(self) -> List[int]: ...
+    @property
+    def valueRight(self) -> List[int]: ...
+
+class TrialStore:
+    version: ClassVar[int] = ...
+    def __init__(self, filename: str) -> None: ...
+    def DDMTrials(self) -> List[DDMTrial]: ...
+    def aDDMTrials(self) -> List[aDDMTrial]: ...
+    @classmethod
+    def convertCSV(cls, csvFilename: str, storeFilename: str, fixDataFilename: str = ...) -> None: ...
+    def numFixations(self) -> int: ...
+    @overload
+    @classmethod
+    def save(cls, filename: str, data: Dict[int,List[aDDMTrial]]) -> None: ...
+    @overload
+    @classmethod
+    def save(cls, filename: str, trials: List[aDDMTrial], subject: int = ...) -> None: ...
+    @overload
+    @classmethod
+    def save(cls, filename: str, trials: List[DDMTrial], subject: int = ...) -> None: ...
+    def size(self) -> int: ...
+    def subjectTrials(self) -> Dict[int,List[aDDMTrial]]: ...
+    def trial(self, index: int) -> aDDMTrial: ...
+
 class aDDM(DDM):
     def __init__(self, d: float, sigma: float, theta: float, k: float = ..., barrier: float = ..., nonDecisionTime: int = ..., bias: float = ..., decay: float = ...) -> None: ...
+    @overload
+    def computeCPUNLLGradient(self, trials: List[aDDMTrial], timeStep: int = ..., approxStateStep: float = ..., numThreads: int = ..., options: PropagationOptions = ...) -> NLLGradient: ...
+    @overload
+    def computeCPUNLLGradient(self, trials: TrialBatch, timeStep: int = ..., approxStateStep: float = ..., numThreads: int = ..., options: PropagationOptions = ...) -> NLLGradient: ...
+    @overload
+    @classmethod
+    def computeCPUNLLs(cls, models: List[aDDM], trials: List[aDDMTrial], trialsPerThread: int = ..., timeStep: int = ..., approxStateStep: float = ..., numThreads: int = ..., modelsPerBlock: int = ..., options: PropagationOptions = ...) -> List[ProbabilityData]: ...
+    @overload
+    @classmethod
+    def computeCPUNLLs(cls, models: List[aDDM], trials: TrialBatch, trialsPerThread: int = ..., timeStep: int = ..., approxStateStep: float = ..., numThreads: int = ..., modelsPerBlock: int = ..., options: PropagationOptions = ...) -> List[ProbabilityData]: ...
     def exportTrial(self, adt: aDDMTrial, filename: str) -> None: ...
+    @overload
+    @classmethod
+    def fitModelAnytime(cls, trials: List[aDDMTrial], rangeD: List[float], rangeSigma: List[float], rangeTheta: List[float], rangeK: List[float] = ..., computeMethod: str = ..., barrier: float = ..., nonDecisionTime: int = ..., bias: List[float] = ..., decay: List[float] = ..., timeStep: int = ..., approxStateStep: float = ..., trialsPerThread: int = ..., options: AnytimeOptions = ...) -> MLEinfoaDDM: ...
+    @overload
+    @classmethod
+    def fitModelAnytime(cls, trials: TrialBatch, rangeD: List[float], rangeSigma: List[float], rangeTheta: List[float], rangeK: List[float] = ..., computeMethod: str = ..., barrier: float = ..., nonDecisionTime: int = ..., bias: List[float] = ..., decay: List[float] = ..., timeStep: int = ..., approxStateStep: float = ..., trialsPerThread: int = ..., options: AnytimeOptions = ...) -> MLEinfoaDDM: ...
+    @overload
+    @classmethod
+    def fitModelLBFGSB(cls, trials: List[aDDMTrial], rangeD: List[float], rangeSigma: List[float], rangeTheta: List[float], rangeK: List[float] = ..., barrier: float = ..., nonDecisionTime: int = ..., bias: float = ..., decay: float = ..., timeStep: int = ..., approxStateStep: float = ..., numThreads: int = ..., warmStart: Optional[aDDM] = ..., options: OptimizerOptions = ...) -> MLEinfoaDDM: ...
+    @overload
+    @classmethod
+    def fitModelLBFGSB(cls, trials: TrialBatch, rangeD: List[float], rangeSigma: List[float], rangeTheta: List[float], rangeK: List[float] = ..., barrier: float = ..., nonDecisionTime: int = ..., bias: float = ..., decay: float = ..., timeStep: int = ..., approxStateStep: float = ..., numThreads: int = ..., warmStart: Optional[aDDM] = ..., options: OptimizerOptions = ...) -> MLEinfoaDDM: ...
+    @overload
+    @classmethod
+    def fitModelMLE(cls, trials: List[aDDMTrial], rangeD: List[float], rangeSigma: List[float], rangeTheta: List[float], rangeK: List[float] = ..., computeMethod: str = ..., normalizePosteriors: bool = ..., barrier: float = ..., nonDecisionTime: int = ..., bias: List[float] = ..., decay: List[float] = ..., timeStep: int = ..., approxStateStep: float = ..., trialsPerThread: int = ..., refinementLevels: int = ..., refinementNeighborhoods: int = ..., pruning: bool = ..., screening: ScreeningOptions = ...) -> MLEinfoaDDM: ...
+    @overload
+    @classmethod
+    def fitModelMLE(cls, trials: TrialBatch, rangeD: List[float], rangeSigma: List[float], rangeTheta: List[float], rangeK: List[float] = ..., computeMethod: str = ..., normalizePosteriors: bool = ..., barrier: float = ..., nonDecisionTime: int = ..., bias: List[float] = ..., decay: List[float] = ..., timeStep: int = ..., approxStateStep: float = ..., trialsPerThread: int = ..., refinementLevels: int = ..., refinementNeighborhoods: int = ..., pruning: bool = ..., screening: ScreeningOptions = ...) -> MLEinfoaDDM: ...
+    @overload
+    @classmethod
+    def fitModelOptimize(cls, trials: List[aDDMTrial], rangeD: List[float], rangeSigma: List[float], rangeTheta: List[float], rangeK: List[float] = ..., computeMethod: str = ..., barrier: float = ..., nonDecisionTime: int = ..., bias: List[float] = ..., decay: List[float] = ..., timeStep: int = ..., approxStateStep: float = ..., trialsPerThread: int = ..., warmStart: Optional[aDDM] = ..., options: OptimizerOptions = ...) -> MLEinfoaDDM: ...
+    @overload
+    @classmethod
+    def fitModelOptimize(cls, trials: TrialBatch, rangeD: List[float], rangeSigma: List[float], rangeTheta: List[float], rangeK: List[float] = ..., computeMethod: str = ..., barrier: float = ..., nonDecisionTime: int = ..., bias: List[float] = ..., decay: List[float] = ..., timeStep: int = ..., approxStateStep: float = ..., trialsPerThread: int = ..., warmStart: Optional[aDDM] = ..., options: OptimizerOptions = ...) -> MLEinfoaDDM: ...
+    @overload
+    @classmethod
+    def fitModelStreaming(cls, trials: List[aDDMTrial], rangeD: List[float], rangeSigma: List[float], rangeTheta: List[float], rangeK: List[float] = ..., computeMethod: str = ..., barrier: float = ..., nonDecisionTime: int = ..., bias: List[float] = ..., decay: List[float] = ..., timeStep: int = ..., approxStateStep: float = ..., trialsPerThread: int = ..., topK: int = ..., modelsPerBatch: int = ...) -> MLEinfoaDDM: ...
+    @overload
     @classmethod
-    def fitModelMLE(cls, trials: List[aDDMTrial], rangeD: List[float], rangeSigma: List[float], rangeTheta: List[float], rangeK: List[float] = ..., normalizePosteriors: bool = ..., barrier: float = ..., nonDecisionTime: int = ..., bias: List[float] = ..., decay: List[float] = ..., timeStep: int = ..., approxStateStep: float = ..., trialsPerThread: int = ...) -> MLEinfoaDDM: ...
+    def fitModelStreaming(cls, trials: TrialBatch, rangeD: List[float], rangeSigma: List[float], rangeTheta: List[float], rangeK: List[float] = ..., computeMethod: str = ..., barrier: float = ..., nonDecisionTime: int = ..., bias: List[float] = ..., decay: List[float] = ..., timeStep: int = ..., approxStateStep: float = ..., trialsPerThread: int = ..., topK: int = ..., modelsPerBatch: int = ...) -> MLEinfoaDDM: ...
     def simulateTrial(self, valueLeft: int, valueRight: int, fixationData: FixationData, timeStep: int = ..., numFixDists: int = ..., fixationDist: Dict[int,List[float]] = ..., timeBins: List[int] = ..., seed: int = ...) -> aDDMTrial: ...
     @property
     def theta(self) -> float: ...
@@ -97,5 +377,5 @@ class aDDMTrial(DDMTrial):
     def uninterruptedLastFixTime(self) -> float: ...
 
 def getEmpiricalDistributions(data: Dict[int,List[aDDMTrial]], timeStep: int = ..., maxFixTime: int = ..., numFixDists: int = ..., valueDiffs: List[int] = ..., subjectIDs: List[int] = ..., useOddTrials: bool = ..., useEvenTrials: bool = ..., useCisTrials: bool = ..., useTransTrials: bool = ...) -> FixationData: ...
-def loadDataFromCSV(expDataFilename: str, fixDataFilename: str) -> Dict[int,List[aDDMTrial]]: ...
+def loadDataFromCSV(expDataFilename: str, fixDataFilename: str, numThreads: int = ...) -> Dict[int,List[aDDMTrial]]: ...
 def loadDataFromSingleCSV(filename: str) -> Dict[int,List[aDDMTrial]]: ...
@@ -7,7 +7,11 @@
 #include <tuple>
 #include <functional> 
 #include "ddm.h"
+#include <optional>
 #include "mle_info.h"
+#include "anytime.h"
+#include "optimize.h"
+#include "propagation.h"
 
 using namespace std;
 using fixDists = map<int, vector<float>>; /**< Maps fixation numbers to the measured durations 
@@ -101,7 +105,7 @@ class aDDMTrial: public DDMTrial {
          * @param trials Vector of trials to be saved. 
          * @param filename File to store the trials in. 
          */
-        static void writeTrialsToCSV(vector<aDDMTrial> trials, string filename);
+        static void writeTrialsToCSV(const vector<aDDMTrial> &trials, const string &filename);
 
         /**
          * @brief Load a dataset of aDDMTrials into program memory. 
@@ -109,7 +113,7 @@ class aDDMTrial: public DDMTrial {
          * @param filename Location of the data trials. 
          * @return vector<aDDMTrial> containing the stored trials. 
          */
-        static vector<aDDMTrial> loadTrialsFromCSV(string filename);
+        static vector<aDDMTrial> loadTrialsFromCSV(const string &filename);
 };
 
 
@@ -129,18 +133,56 @@ class aDDM: public DDM {
     private:
         void callGetTrialLikelihoodKernel(
             int trialsPerThread, int numBlocks, int threadsPerBlock, 
-            aDDMTrial *trials, double *likelihoods, int numTrials, 
+            const TrialBatch &trials, double *likelihoods, 
             float d, float sigma, float theta,float k, float barrier, 
             int nonDecisionTime, int timeStep, float approxStateStep, float decay);
 
+        void advanceFixation(
+            const StateSpace &space, float mean, int numSteps, int &time, 
+            const PropagationOptions &options, vector<double> &prStates, 
+            vector<double> &prStatesNew, double *probUpCrossing, double *probDownCrossing, 
+            int &supportLo, int &supportHi, int numColumns);
+
+        void getTrialLikelihoods(
+            int valueLeft, int valueRight, int choice, const int *fixItem, const int *fixTime, 
+            int fixLen, const StateSpace &space, const vector<int> &biasStates, int timeStep, 
+            const PropagationOptions &options, double *likelihoods);
+
+        void getTrialLikelihoods(
+            const TrialBatch &trials, size_t trialNum, const StateSpace &space, 
+            const vector<int> &biasStates, int timeStep, const PropagationOptions &options, 
+            double *likelihoods);
+
+        void getLockstepLikelihoods(
+            const TrialBatch &trials, const vector<int> &batch, 
+            const StateSpace &space, int biasState, int timeStep, 
+            const PropagationOptions &options, double *likelihoods);
+
+        void getPrefixSharedLikelihoods(
+            const TrialBatch &trials, const vector<int> &group, 
+            const StateSpace &space, const vector<int> &biasStates, int timeStep, 
+            const PropagationOptions &options, double *likelihoods);
+
+        void getTrialLikelihoodGradient(
+            int valueLeft, int valueRight, int choice, const int *fixItem, const int *fixTime, 
+            int fixLen, const StateSpace &space, int timeStep, 
+            const PropagationOptions &options, double *likelihood);
+
+        static void getLaneLikelihoods(
+            const vector<aDDM> &block, const TrialBatch &trials, 
+            const vector<int> &batch, const StateSpace &space, int timeStep, 
+            const PropagationOptions &options, double *likelihoods);
+
     public: 
         float theta; /**< Float between 0 and 1, parameter of the model which 
             controls the attentional bias.*/
         float k; /**< Float that controls the additive bias for the fixated item. */
 
         bool operator <( const aDDM &rhs ) const { 
-            return (d * 17) + (sigma * 31) + (theta * 43) + (bias * 59) + (decay * 73) < 
-                (rhs.d * 17) + (rhs.sigma * 31) + (rhs.theta * 43) + (rhs.bias * 59) + (rhs.decay * 73);
+            return std::tie(d, sigma, theta, k, bias, decay, barrier, nonDecisionTime) < 
+                std::tie(
+                    rhs.d, rhs.sigma, rhs.theta, rhs.k, rhs.bias, rhs.decay, rhs.barrier, 
+                    rhs.nonDecisionTime);
         }
 
         bool operator ==( const aDDM &rhs ) const {
@@ -178,7 +220,7 @@ class aDDM: public DDM {
          * @param adt Trial to export. 
          * @param filename File to store the trial information in. 
          */
-        void exportTrial(aDDMTrial adt, std::string filename);
+        void exportTrial(const aDDMTrial &adt, const std::string &filename);
 
         /**
          * @brief Generate simulated fixations provided item values and empirical fixation data. 
@@ -194,8 +236,207 @@ class aDDM: public DDM {
          * @return aDDMTrial resulting from the simulation. 
          */
         aDDMTrial simulateTrial(
-            int valueLeft, int valueRight, FixationData fixationData, int timeStep=10, 
-            int numFixDists=3, fixDists fixationDist={}, vector<int> timeBins={}, int seed=-1
+            int valueLeft, int valueRight, const FixationData &fixationData, int timeStep=10, 
+            int numFixDists=3, const fixDists &fixationDist={}, const vector<int> &timeBins={}, 
+            int seed=-1
+        );
+
+        /**
+         * @brief Compute the likelihood of a single aDDMTrial on the CPU. The fixations are read 
+         * in place from the trial. 
+         * 
+         * @param trial aDDMTrial to compute the likelihood for. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param options Tuning parameters of the propagation. 
+         * @return double containing the likelihood of the trial, clamped below at 1e-20. 
+         * @throws std::invalid_argument if the trial has a different number of fixation items and 
+         * fixation times. 
+         */
+        double getTrialLikelihood(
+            const aDDMTrial &trial, int timeStep=10, float approxStateStep=0.1, 
+            PropagationOptions options=PropagationOptions()
+        );
+
+        /**
+         * @brief Compute the total Negative Log Likelihood (NLL) for a vector of aDDMTrials. Use 
+         * every available CPU core, with each task computing a contiguous chunk of trials. The 
+         * numerics are identical to computeGPUNLL. 
+         * 
+         * @param trials Vector of aDDMTrials that the model should calculate the NLL for. 
+         * @param trialsPerThread Number of trials that each task should be designated to compute. 
+         * The last task computes any remaining trials. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param numThreads Number of threads to use. 0 uses every available core. 
+         * @param options Tuning parameters of the propagation. 
+         * @return ProbabilityData containing NLL, sum of likelihoods, and a list of all computed 
+         * likelihoods.
+         */
+        ProbabilityData computeCPUNLL(
+            const vector<aDDMTrial> &trials, int trialsPerThread=10, 
+            int timeStep=10, float approxStateStep=0.1, int numThreads=0, 
+            PropagationOptions options=PropagationOptions()
+        );
+
+        /**
+         * @brief Compute the total Negative Log Likelihood (NLL) for a vector of aDDMTrials under 
+         * every bias in a grid, keeping all other parameters of the model. The propagation is 
+         * linear in the initial distribution, so the initial states of all biases are advanced 
+         * together as the columns of one matrix and each trial is traversed only once. 
+         * 
+         * @param trials Vector of aDDMTrials that the model should calculate the NLL for. 
+         * @param biases Initial RDV values to compute the NLL for. 
+         * @param trialsPerThread Number of trials that each task should be designated to compute. 
+         * The last task computes any remaining trials. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param numThreads Number of threads to use. 0 uses every available core. 
+         * @param options Tuning parameters of the propagation. 
+         * @return vector of ProbabilityData, one per entry of biases. 
+         */
+        vector<ProbabilityData> computeCPUNLL(
+            const vector<aDDMTrial> &trials, const vector<float> &biases, 
+            int trialsPerThread=10, int timeStep=10, float approxStateStep=0.1, 
+            int numThreads=0, PropagationOptions options=PropagationOptions()
+        );
+
+        /**
+         * @brief Compute the total Negative Log Likelihood (NLL) for a TrialBatch. The vector 
+         * overload packs its trials into a batch and calls this one. 
+         * 
+         * @param trials TrialBatch that the model should calculate the NLL for. 
+         * @param trialsPerThread Number of trials that each task should be designated to compute. 
+         * The last task computes any remaining trials. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param numThreads Number of threads to use. 0 uses every available core. 
+         * @param options Tuning parameters of the propagation. 
+         * @return ProbabilityData containing NLL, sum of likelihoods, and a list of all computed 
+         * likelihoods.
+         */
+        ProbabilityData computeCPUNLL(
+            const TrialBatch &trials, int trialsPerThread=10, 
+            int timeStep=10, float approxStateStep=0.1, int numThreads=0, 
+            PropagationOptions options=PropagationOptions()
+        );
+
+        /**
+         * @brief Compute the total Negative Log Likelihood (NLL) for a TrialBatch under every 
+         * bias in a grid. See the vector overload. 
+         * 
+         * @param trials TrialBatch that the model should calculate the NLL for. 
+         * @param biases Initial RDV values to compute the NLL for. 
+         * @param trialsPerThread Number of trials that each task should be designated to compute. 
+         * The last task computes any remaining trials. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param numThreads Number of threads to use. 0 uses every available core. 
+         * @param options Tuning parameters of the propagation. 
+         * @return vector of ProbabilityData, one per entry of biases. 
+         */
+        vector<ProbabilityData> computeCPUNLL(
+            const TrialBatch &trials, const vector<float> &biases, 
+            int trialsPerThread=10, int timeStep=10, float approxStateStep=0.1, 
+            int numThreads=0, PropagationOptions options=PropagationOptions()
+        );
+
+        /**
+         * @brief Compute the likelihood of the trials of a TrialBatch from begin up to, but 
+         * excluding, end under every bias in a grid. The fixations are read in place from the CSR
+         * columns of the batch, so a range of a batch shared by many models is evaluated without 
+         * copying its trials. 
+         * 
+         * @param trials TrialBatch holding the trials. 
+         * @param begin Index of the first trial to compute. 
+         * @param end Index past the last trial to compute. 
+         * @param biases Initial RDV values to compute the likelihoods for. 
+         * @param likelihoods Output array of (end - begin) * biases.size() likelihoods, where 
+         * likelihoods[(i - begin) * biases.size() + b] is the likelihood of trial i under bias b.
+         * @param trialsPerThread Number of trials that each task should be designated to compute. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param numThreads Number of threads to use. 0 uses every available core. 
+         * @param options Tuning parameters of the propagation. 
+         */
+        void computeCPULikelihoods(
+            const TrialBatch &trials, size_t begin, size_t end, const vector<float> &biases, 
+            double *likelihoods, int trialsPerThread, int timeStep, float approxStateStep, 
+            int numThreads, PropagationOptions options
+        );
+
+        /**
+         * @brief Compute the total Negative Log Likelihood (NLL) for a vector of aDDMTrials under 
+         * several models at once. The models are split into blocks of modelsPerBlock, and the 
+         * distributions of the models in a block are advanced together, one per vector lane, over
+         * a single traversal of each trial. Models may differ in d, sigma, theta and k, but must 
+         * share their barrier, decay and bias so that they use the same states and barriers. 
+         * Skip-ahead propagation is not used, and the likelihoods agree with computeCPUNLL with 
+         * skipAhead disabled up to rounding. 
+         * 
+         * @param models Models to compute the NLL for. 
+         * @param trials Vector of aDDMTrials that the models should calculate the NLL for. 
+         * @param trialsPerThread Number of trials with the same item values that each task should
+         * be designated to compute. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param numThreads Number of threads to use. 0 uses every available core. 
+         * @param modelsPerBlock Number of models advanced together. Blocks of 4 to 16 models fill 
+         * the vector registers without spilling the state vectors out of cache. 
+         * @param options Tuning parameters of the propagation. 
+         * @return vector of ProbabilityData, one per entry of models. 
+         */
+        static vector<ProbabilityData> computeCPUNLLs(
+            const vector<aDDM> &models, const vector<aDDMTrial> &trials, 
+            int trialsPerThread=10, int timeStep=10, float approxStateStep=0.1, 
+            int numThreads=0, int modelsPerBlock=8, 
+            PropagationOptions options=PropagationOptions()
+        );
+
+        /**
+         * @brief computeCPUNLLs on a TrialBatch, such as one built from a TrialStore. The vector 
+         * overload packs its trials once and calls this one. See the vector overload for the 
+         * parameters. 
+         * 
+         */
+        static vector<ProbabilityData> computeCPUNLLs(
+            const vector<aDDM> &models, const TrialBatch &trials, 
+            int trialsPerThread=10, int timeStep=10, float approxStateStep=0.1, 
+            int numThreads=0, int modelsPerBlock=8, 
+            PropagationOptions options=PropagationOptions()
+        );
+
+        /**
+         * @brief Compute the total Negative Log Likelihood (NLL) for a vector of aDDMTrials together 
+         * with its gradient. The derivatives of the RDV distribution with respect to d, sigma, 
+         * theta and k are propagated alongside it through every transition and barrier crossing 
+         * (forward-mode differentiation), so one pass over the trials yields the exact gradient of
+         * the discretized NLL. The bias only selects the initial state, so the discretized NLL is 
+         * piecewise constant in the bias and its derivative is reported as 0. Skip-ahead 
+         * propagation and support trimming are not used. 
+         * 
+         * @param trials Vector of aDDMTrials that the model should calculate the NLL for. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param numThreads Number of threads to use. 0 uses every available core. 
+         * @param options Tuning parameters of the propagation. 
+         * @return NLLGradient holding the NLL and its derivatives with respect to 
+         * (d, sigma, theta, k, bias). 
+         */
+        NLLGradient computeCPUNLLGradient(
+            const vector<aDDMTrial> &trials, int timeStep=10, float approxStateStep=0.1, 
+            int numThreads=0, PropagationOptions options=PropagationOptions()
+        );
+
+        /**
+         * @brief computeCPUNLLGradient on a TrialBatch, such as one built from a TrialStore. The 
+         * vector overload packs its trials once and calls this one. See the vector overload for 
+         * the parameters. 
+         * 
+         */
+        NLLGradient computeCPUNLLGradient(
+            const TrialBatch &trials, int timeStep=10, float approxStateStep=0.1, 
+            int numThreads=0, PropagationOptions options=PropagationOptions()
         );
 
         /**
@@ -203,16 +444,33 @@ class aDDM: public DDM {
          * GPU to maximize the number of trials being computed in parallel. 
          * 
          * @param trials Vector of aDDMTrials that the model should calculcate the NLL for. 
-         * @param debug Boolean specifying if state variables should be printed for debugging purposes.
          * @param trialsPerThread Number of trials that each thread should be designated to compute. 
-         * Must be divisible by the total number of trials. 
+         * The last thread computes any remaining trials. 
          * @param timeStep Value in milliseconds used for binning the time axis. 
          * @param approxStateStep Used for binning the RDV axis.
          * @return ProbabilityData containing NLL, sum of likelihoods, and a list of all computed 
          * likelihoods.
          */
         ProbabilityData computeGPUNLL(
-            vector<aDDMTrial> trials, int trialsPerThread=10, 
+            const vector<aDDMTrial> &trials, int trialsPerThread=10, 
+            int timeStep=10, float approxStateStep=0.1
+        );
+
+        /**
+         * @brief Compute the total Negative Log Likelihood (NLL) for a TrialBatch on the GPU. The 
+         * fixations are read in place from the CSR columns of the batch, so a batch built once 
+         * can be evaluated under many models without repacking the trials. 
+         * 
+         * @param trials TrialBatch that the model should calculate the NLL for. 
+         * @param trialsPerThread Number of trials that each thread should be designated to compute. 
+         * The last thread computes any remaining trials. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis.
+         * @return ProbabilityData containing NLL, sum of likelihoods, and a list of all computed 
+         * likelihoods.
+         */
+        ProbabilityData computeGPUNLL(
+            const TrialBatch &trials, int trialsPerThread=10, 
             int timeStep=10, float approxStateStep=0.1
         );
 
@@ -227,9 +485,12 @@ class aDDM: public DDM {
          * @param rangeSigma Vector of floats representing possible values of sigma to test for. 
          * @param rangeTheta Vector of floats representing possible values of theta to test for. 
          * @param rangeK Vector of floats representing possible values of k to test for. 
+         * @param computeMethod Likelihood engine used for every model. One of "basic", "thread", 
+         * "gpu", or "auto". See getComputeBackend for details. 
          * @param normalizePosteriors true if the returned MLEinfo should contain a mapping of aDDMs 
          * to the normzlied posteriors distribution for each model; otherwise, the MLEinfo should 
-         * containing a mapping of aDDMs to its corresponding NLL. 
+         * containing a mapping of aDDMs to its corresponding NLL. Every trial likelihood of 
+         * every model is held until the end; see fitModelStreaming for large grids. 
          * @param barrier Positive magnitude of the signal threshold. 
          * @param nonDecisionTime Amount of time in milliseconds in which only noise is added to 
          * the decision variable. 
@@ -243,15 +504,274 @@ class aDDM: public DDM {
          * means that the barriers are constant. Similarly to the `bias` argument, the three 
          * input forms of no input, a vector with single element, and a vector with a range of 
          * elements. 
-         * @return MLEinfo containing the most optimal model and a mapping of models to floats 
-         * determined by the normalizePosteriors argument. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param trialsPerThread Number of trials that each thread should be designated to 
+         * compute. 
+         * @param refinementLevels Number of coarse-to-fine refinement passes after the full grid
+         * of the ranges has been evaluated. Each pass evaluates the models within half the 
+         * previous spacing of the best models found so far, in every dimension with more than one
+         * value, so the spacing of the ranges is divided by 2^refinementLevels around the optimum.
+         * A value of 0 only evaluates the full grid. 
+         * @param refinementNeighborhoods Number of best models that are refined around in each 
+         * pass. 
+         * @param pruning Drop the models whose partial NLL, accumulated over chunks of trials, 
+         * already exceeds the best NLL found so far (branch and bound). The center of the grid is 
+         * evaluated first to set the initial bound and to order the trials so that poor models are
+         * rejected after few of them. Dropped models are left out of the returned MLEinfo. 
+         * Requires normalizePosteriors to be false. 
+         * @param screening Multi-fidelity screening of the grid. If enabled, every model of the 
+         * full grid is first evaluated at the coarse resolution of screening, and only the best 
+         * ones are evaluated at timeStep and approxStateStep, with every bias. The other models 
+         * keep their coarse NLL, and MLEinfo::fidelities records which resolution each NLL comes 
+         * from. Refinement and the optimum only use fine NLLs. With pruning, the best coarse model 
+         * is evaluated first. Requires normalizePosteriors to be false. 
+         * @return MLEinfo containing the most optimal model and a mapping of every evaluated model 
+         * to floats determined by the normalizePosteriors argument. With refinement, posteriors 
+         * use a uniform prior over the evaluated models. 
+         * The same values are stored by grid index in grid. Models are built and evaluated a 
+         * batch at a time, but likelihoods, and fidelities with screening, are still filled with 
+         * one entry per evaluated model for compatibility, so they grow with the grid; read grid 
+         * for large grids. 
          */
         static MLEinfo<aDDM> fitModelMLE(
-            vector<aDDMTrial> trials, vector<float> rangeD, vector<float> rangeSigma, 
+            const vector<aDDMTrial> &trials, vector<float> rangeD, vector<float> rangeSigma, 
             vector<float> rangeTheta, vector<float> rangeK={0}, 
-            bool normalizePosteriors=false, float barrier=1, unsigned int nonDecisionTime=0, 
+            string computeMethod="auto", bool normalizePosteriors=false, float barrier=1, unsigned int nonDecisionTime=0, 
             vector<float> bias={0}, vector<float> decay={0}, 
-            int timeStep=10, float approxStateStep=0.1, int trialsPerThread=10
+            int timeStep=10, float approxStateStep=0.1, int trialsPerThread=10, 
+            int refinementLevels=0, int refinementNeighborhoods=1, bool pruning=false, 
+            ScreeningOptions screening=ScreeningOptions()
+        );
+
+        /**
+         * @brief fitModelMLE on a TrialBatch, such as one built from a TrialStore. The vector 
+         * overload packs its trials once and calls this one. See the vector overload for the 
+         * parameters. 
+         * 
+         */
+        static MLEinfo<aDDM> fitModelMLE(
+            const TrialBatch &trials, vector<float> rangeD, vector<float> rangeSigma, 
+            vector<float> rangeTheta, vector<float> rangeK={0}, 
+            string computeMethod="auto", bool normalizePosteriors=false, float barrier=1, 
+            unsigned int nonDecisionTime=0, 
+            vector<float> bias={0}, vector<float> decay={0}, 
+            int timeStep=10, float approxStateStep=0.1, int trialsPerThread=10, 
+            int refinementLevels=0, int refinementNeighborhoods=1, bool pruning=false, 
+            ScreeningOptions screening=ScreeningOptions()
+        );
+
+        /**
+         * @brief Compute the posteriors of a grid of aDDMs, as fitModelMLE with 
+         * normalizePosteriors, without holding the trial likelihoods of every model. The grid is 
+         * evaluated in batches, and the per-trial log likelihoods of each model are folded into 
+         * the posterior as soon as they are computed. Only the topK models with the smallest NLL
+         * keep their full results, so memory does not grow with the size of the grid. 
+         * 
+         * @param trials Vector of aDDMTrials that each model should calculate the NLL for. 
+         * @param rangeD Vector of floats representing possible values of d to test for. 
+         * @param rangeSigma Vector of floats representing possible values of sigma to test for. 
+         * @param rangeTheta Vector of floats representing possible values of theta to test for. 
+         * @param rangeK Vector of floats representing possible values of k to test for. 
+         * @param computeMethod Likelihood engine used for every model. One of "basic", "thread", 
+         * "gpu", or "auto". See getComputeBackend for details. 
+         * @param barrier Positive magnitude of the signal threshold. 
+         * @param nonDecisionTime Amount of time in milliseconds in which only noise is added to 
+         * the decision variable. 
+         * @param bias Possible values of the initial RDV. 
+         * @param decay Possible values of the decay of the barriers. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param trialsPerThread Number of trials that each thread should be designated to 
+         * compute. 
+         * @param topK Number of models whose full results are kept. 
+         * @param modelsPerBatch Number of models, each under every bias, evaluated at once. 
+         * Bounds the number of trial likelihoods held at any time. 
+         * @return MLEinfo containing the most optimal model, a mapping of the topK models to their 
+         * posteriors, their full results in topModels, and the marginal posterior of every value
+         * of each parameter, aligned with the axes of grid. Posteriors use a uniform prior over 
+         * the grid. 
+         */
+        static MLEinfo<aDDM> fitModelStreaming(
+            const vector<aDDMTrial> &trials, vector<float> rangeD, vector<float> rangeSigma, 
+            vector<float> rangeTheta, vector<float> rangeK={0}, 
+            string computeMethod="auto", float barrier=1, unsigned int nonDecisionTime=0, 
+            vector<float> bias={0}, vector<float> decay={0}, 
+            int timeStep=10, float approxStateStep=0.1, int trialsPerThread=10, 
+            int topK=10, int modelsPerBatch=64
+        );
+
+        /**
+         * @brief fitModelStreaming on a TrialBatch, such as one built from a TrialStore. The 
+         * vector overload packs its trials once and calls this one. See the vector overload for 
+         * the parameters. 
+         * 
+         */
+        static MLEinfo<aDDM> fitModelStreaming(
+            const TrialBatch &trials, vector<float> rangeD, vector<float> rangeSigma, 
+            vector<float> rangeTheta, vector<float> rangeK={0}, 
+            string computeMethod="auto", float barrier=1, unsigned int nonDecisionTime=0, 
+            vector<float> bias={0}, vector<float> decay={0}, 
+            int timeStep=10, float approxStateStep=0.1, int trialsPerThread=10, 
+            int topK=10, int modelsPerBatch=64
+        );
+
+        /**
+         * @brief Grid search over the same models as fitModelMLE that can be stopped at any time
+         * and returns the best model found so far. The models are evaluated in batches, first on 
+         * a coarse lattice of the grid and then closest to the best model so far, so the best 
+         * model improves quickly. The fit stops once every model is evaluated, the time limit of 
+         * options has passed, or its cancellation token is cancelled, and it reports its 
+         * progress after every batch. 
+         * 
+         * @param trials Vector of aDDMTrials that each model should calculate the NLL for. 
+         * @param rangeD Vector of floats representing possible values of d to test for. 
+         * @param rangeSigma Vector of floats representing possible values of sigma to test for. 
+         * @param rangeTheta Vector of floats representing possible values of theta to test for. 
+         * @param rangeK Vector of floats representing possible values of k to test for. 
+         * @param computeMethod Likelihood engine used for every model. One of "basic", "thread", 
+         * "gpu", or "auto". See getComputeBackend for details. 
+         * @param barrier Positive magnitude of the signal threshold. 
+         * @param nonDecisionTime Amount of time in milliseconds in which only noise is added to 
+         * the decision variable. 
+         * @param bias Possible values of the initial RDV. 
+         * @param decay Possible values of the decay of the barriers. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param trialsPerThread Number of trials that each thread should be designated to 
+         * compute. 
+         * @param options Time limit, cancellation token, progress callback and batch size. 
+         * @return MLEinfo containing the best model found, a mapping of every evaluated model to 
+         * its NLL, the grid holding the same NLLs, and whether every model was evaluated in 
+         * complete. 
+         */
+        static MLEinfo<aDDM> fitModelAnytime(
+            const vector<aDDMTrial> &trials, vector<float> rangeD, vector<float> rangeSigma, 
+            vector<float> rangeTheta, vector<float> rangeK={0}, 
+            string computeMethod="auto", float barrier=1, unsigned int nonDecisionTime=0, 
+            vector<float> bias={0}, vector<float> decay={0}, 
+            int timeStep=10, float approxStateStep=0.1, int trialsPerThread=10, 
+            AnytimeOptions options=AnytimeOptions()
+        );
+
+        /**
+         * @brief fitModelAnytime on a TrialBatch, such as one built from a TrialStore. The vector 
+         * overload packs its trials once and calls this one. See the vector overload for the 
+         * parameters. 
+         * 
+         */
+        static MLEinfo<aDDM> fitModelAnytime(
+            const TrialBatch &trials, vector<float> rangeD, vector<float> rangeSigma, 
+            vector<float> rangeTheta, vector<float> rangeK={0}, 
+            string computeMethod="auto", float barrier=1, unsigned int nonDecisionTime=0, 
+            vector<float> bias={0}, vector<float> decay={0}, 
+            int timeStep=10, float approxStateStep=0.1, int trialsPerThread=10, 
+            AnytimeOptions options=AnytimeOptions()
+        );
+
+        /**
+         * @brief Find the aDDM with the minimum NLL for the provided aDDMTrials with a bounded 
+         * Nelder-Mead simplex over (d, sigma, theta, k, bias, decay) instead of a grid. Only the
+         * optimum is searched for, so a fit usually needs a few dozen likelihood evaluations. 
+         * 
+         * @param trials Vector of aDDMTrials that each model should calculate the NLL for. 
+         * @param rangeD Bounds of d, given as the smallest and largest value of the vector. 
+         * @param rangeSigma Bounds of sigma. 
+         * @param rangeTheta Bounds of theta. 
+         * @param rangeK Bounds of k. 
+         * @param computeMethod Likelihood engine used for every model. One of "basic", "thread", 
+         * "gpu", or "auto". See getComputeBackend for details. 
+         * @param barrier Positive magnitude of the signal threshold. 
+         * @param nonDecisionTime Amount of time in milliseconds in which only noise is added to 
+         * the decision variable. 
+         * @param bias Bounds of the bias. Must lie within the barriers. 
+         * @param decay Bounds of the decay. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param trialsPerThread Number of trials that each thread should be designated to 
+         * compute. 
+         * @param warmStart Initial model of the search, such as the fit of a previous subject. 
+         * Its parameters are clipped to the bounds. If empty, the search starts at the center of 
+         * the bounds. 
+         * @param options Convergence tolerances and evaluation budget of the simplex. 
+         * @return MLEinfo containing the best model found and a mapping of every evaluated model 
+         * to its NLL. 
+         */
+        static MLEinfo<aDDM> fitModelOptimize(
+            const vector<aDDMTrial> &trials, vector<float> rangeD, vector<float> rangeSigma, 
+            vector<float> rangeTheta, vector<float> rangeK={0}, 
+            string computeMethod="auto", float barrier=1, unsigned int nonDecisionTime=0, 
+            vector<float> bias={0}, vector<float> decay={0}, 
+            int timeStep=10, float approxStateStep=0.1, int trialsPerThread=10, 
+            std::optional<aDDM> warmStart=std::nullopt, 
+            OptimizerOptions options=OptimizerOptions()
+        );
+
+        /**
+         * @brief fitModelOptimize on a TrialBatch, such as one built from a TrialStore. The vector 
+         * overload packs its trials once and calls this one. See the vector overload for the 
+         * parameters. 
+         * 
+         */
+        static MLEinfo<aDDM> fitModelOptimize(
+            const TrialBatch &trials, vector<float> rangeD, vector<float> rangeSigma, 
+            vector<float> rangeTheta, vector<float> rangeK={0}, 
+            string computeMethod="auto", float barrier=1, unsigned int nonDecisionTime=0, 
+            vector<float> bias={0}, vector<float> decay={0}, 
+            int timeStep=10, float approxStateStep=0.1, int trialsPerThread=10, 
+            std::optional<aDDM> warmStart=std::nullopt, 
+            OptimizerOptions options=OptimizerOptions()
+        );
+
+        /**
+         * @brief Find the aDDM with the minimum NLL for the provided aDDMTrials with a bounded 
+         * quasi-Newton search (L-BFGS-B) over (d, sigma, theta, k), driven by the exact gradients
+         * of computeCPUNLLGradient. Each iteration costs about one pass over the trials, so a fit
+         * usually needs fewer likelihood evaluations than fitModelOptimize. The bias and decay 
+         * are held fixed, since the discretized NLL is not differentiable in either. 
+         * 
+         * @param trials Vector of aDDMTrials that each model should calculate the NLL for. 
+         * @param rangeD Bounds of d, given as the smallest and largest value of the vector. 
+         * @param rangeSigma Bounds of sigma. 
+         * @param rangeTheta Bounds of theta. 
+         * @param rangeK Bounds of k. 
+         * @param barrier Positive magnitude of the signal threshold. 
+         * @param nonDecisionTime Amount of time in milliseconds in which only noise is added to 
+         * the decision variable. 
+         * @param bias Initial value of the decision variable. 
+         * @param decay Controls the decay of the barriers over time. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param numThreads Number of threads to use. 0 uses every available core. 
+         * @param warmStart Initial model of the search, such as the fit of a previous subject. 
+         * Its parameters are clipped to the bounds. If empty, the search starts at the center of 
+         * the bounds. 
+         * @param options Convergence tolerances and evaluation budget of the search. 
+         * @return MLEinfo containing the best model found, a mapping of every evaluated model to 
+         * its NLL, and the converged flag and numEvaluations of the search. 
+         */
+        static MLEinfo<aDDM> fitModelLBFGSB(
+            const vector<aDDMTrial> &trials, vector<float> rangeD, vector<float> rangeSigma, 
+            vector<float> rangeTheta, vector<float> rangeK={0}, float barrier=1, 
+            unsigned int nonDecisionTime=0, float bias=0, float decay=0, 
+            int timeStep=10, float approxStateStep=0.1, int numThreads=0, 
+            std::optional<aDDM> warmStart=std::nullopt, 
+            OptimizerOptions options=OptimizerOptions()
+        );
+
+        /**
+         * @brief fitModelLBFGSB on a TrialBatch, such as one built from a TrialStore. The vector 
+         * overload packs its trials once and calls this one. See the vector overload for the 
+         * parameters. 
+         * 
+         */
+        static MLEinfo<aDDM> fitModelLBFGSB(
+            const TrialBatch &trials, vector<float> rangeD, vector<float> rangeSigma, 
+            vector<float> rangeTheta, vector<float> rangeK={0}, float barrier=1, 
+            unsigned int nonDecisionTime=0, float bias=0, float decay=0, 
+            int timeStep=10, float approxStateStep=0.1, int numThreads=0, 
+            std::optional<aDDM> warmStart=std::nullopt, 
+            OptimizerOptions options=OptimizerOptions()
         );
 };
 
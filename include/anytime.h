@@ -0,0 +1,211 @@
+#ifndef ANYTIME_H
+#define ANYTIME_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "mle_info.h"
+#include "parameter_grid.h"
+
+/**
+ * @brief Flag shared between a fit and the code that may cancel it. Copies of a token refer to 
+ * the same flag, so a token can be handed to a fit running on another thread and cancelled from 
+ * the calling one. 
+ *
+ */
+class CancellationToken {
+    private:
+        std::shared_ptr<std::atomic<bool>> cancelled; /**< Shared by every copy of the token. */
+
+    public:
+        /**
+         * @brief Construct a new CancellationToken object that is not cancelled. 
+         *
+         */
+        CancellationToken() : cancelled(std::make_shared<std::atomic<bool>>(false)) {}
+
+        /**
+         * @brief Ask every fit holding a copy of the token to stop. 
+         *
+         */
+        void cancel() { cancelled->store(true); }
+
+        /**
+         * @brief Whether cancel was called on any copy of the token. 
+         *
+         * @return true if the token is cancelled. 
+         */
+        bool isCancelled() const { return cancelled->load(); }
+};
+
+/**
+ * @brief Progress of an anytime fit, reported after every batch of models. 
+ *
+ */
+struct FitProgress {
+    size_t modelsDone = 0; /**< Number of models evaluated so far, counting each bias. */
+    size_t numModels = 0; /**< Number of models of the grid, counting each bias. */
+    double bestNLL = 0; /**< Smallest NLL found so far. */
+    double elapsedSeconds = 0; /**< Wall-clock time since the fit started. */
+    double etaSeconds = 0; /**< Estimated time left to evaluate the rest of the grid at the rate
+        observed so far. */
+};
+
+/**
+ * @brief Settings of an anytime grid search. The grid is evaluated in batches, and the deadline 
+ * and the cancellation token are checked between batches, so a fit can overrun its deadline by 
+ * up to the duration of one batch. 
+ *
+ */
+struct AnytimeOptions {
+    double timeLimit = 0; /**< Wall-clock seconds after which the fit returns the best model
+        found so far. 0 means no limit. */
+    CancellationToken cancellation; /**< Stops the fit after the current batch once cancelled. */
+    std::function<void(const FitProgress &)> progress; /**< Called after every batch, if set. */
+    int modelsPerBatch = 16; /**< Number of models, each under every bias, evaluated at once. */
+};
+
+/**
+ * @brief Evaluate the models of a grid in an order that improves the best model quickly, until 
+ * every model is done, the time limit has passed, or the fit is cancelled. The first batches 
+ * cover a coarse lattice of the grid, made of the first, middle and last value of each axis. 
+ * Every later batch holds the remaining models closest to the best model so far, with distances 
+ * measured in grid coordinates scaled to the length of each axis. 
+ *
+ * @tparam T DDM or aDDM. 
+ * @param grid Grid to evaluate, whose last axis is the bias. 
+ * @param options Deadline, cancellation, progress callback and batch size. 
+ * @param makeModel Callable building the model of the parameters of a grid point, ignoring the 
+ * bias. 
+ * @param evaluate Callable computing the ProbabilityData of a batch of models under every bias, 
+ * such as ComputeBackend::computeGridNLLs. 
+ * @return MLEinfo with the best model found, a mapping of every evaluated model to its NLL, the 
+ * grid holding the same NLLs, and complete set to whether every model was evaluated. 
+ */
+template <typename T, typename MakeModel, typename Evaluate>
+MLEinfo<T> fitAnytimeGrid(
+    ParameterGrid grid, const AnytimeOptions &options, MakeModel makeModel, Evaluate evaluate) {
+
+    if (options.timeLimit < 0 || options.modelsPerBatch <= 0) {
+        throw std::invalid_argument(
+            "timeLimit must be non-negative and modelsPerBatch positive.");
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    const std::vector<float> biases = grid.axes.back();
+    size_t numBiases = biases.size();
+    int numAxes = grid.axes.size() - 1;
+
+    // Row-major strides of the grid, so that coordinates are read off a point without 
+    // allocating. 
+    std::vector<size_t> strides(numAxes + 1, 1);
+    for (int a = numAxes - 1; a >= 0; a--) {
+        strides[a] = strides[a + 1] * grid.axes[a + 1].size();
+    }
+    auto coordinate = [&](size_t point, int a) {
+        return (int) (point / strides[a] % grid.axes[a].size());
+    };
+    auto distance = [&](size_t point, size_t center) {
+        double squares = 0;
+        for (int a = 0; a < numAxes; a++) {
+            double length = std::max((int) grid.axes[a].size() - 1, 1);
+            double delta = (coordinate(point, a) - coordinate(center, a)) / length;
+            squares += delta * delta;
+        }
+        return squares;
+    };
+
+    // Models are identified by the index of their first bias. The coarse lattice goes first. 
+    // The other models wait in a min-heap of their distance to the best model, which is only 
+    // re-ranked when the best model changes. 
+    std::vector<size_t> lattice;
+    std::vector<std::pair<double, size_t>> remaining;
+    for (size_t point = 0; point < grid.size(); point += numBiases) {
+        bool onLattice = true;
+        for (int a = 0; a < numAxes; a++) {
+            int last = grid.axes[a].size() - 1;
+            int c = coordinate(point, a);
+            onLattice = onLattice && (c == 0 || c == last / 2 || c == last);
+        }
+        if (onLattice) {
+            lattice.push_back(point);
+        } else {
+            remaining.push_back({0, point});
+        }
+    }
+    auto closer = std::greater<std::pair<double, size_t>>();
+
+    MLEinfo<T> info;
+    FitProgress progress;
+    progress.numModels = grid.size();
+    progress.bestNLL = __DBL_MAX__;
+    size_t optimalPoint = 0;
+    bool ranked = false;
+    size_t rankedPoint = 0;
+    while (!lattice.empty() || !remaining.empty()) {
+        if (options.cancellation.isCancelled() ||
+            (options.timeLimit > 0 && elapsed() >= options.timeLimit)) {
+            break;
+        }
+        std::vector<size_t> batch;
+        if (!lattice.empty()) {
+            size_t size = std::min(lattice.size(), (size_t) options.modelsPerBatch);
+            batch.assign(lattice.begin(), lattice.begin() + size);
+            lattice.erase(lattice.begin(), lattice.begin() + size);
+        } else {
+            if (!ranked || rankedPoint != optimalPoint) {
+                for (std::pair<double, size_t> &entry : remaining) {
+                    entry.first = distance(entry.second, optimalPoint);
+                }
+                std::make_heap(remaining.begin(), remaining.end(), closer);
+                ranked = true;
+                rankedPoint = optimalPoint;
+            }
+            while (!remaining.empty() && batch.size() < (size_t) options.modelsPerBatch) {
+                std::pop_heap(remaining.begin(), remaining.end(), closer);
+                batch.push_back(remaining.back().second);
+                remaining.pop_back();
+            }
+        }
+
+        std::vector<T> models;
+        for (size_t point : batch) {
+            models.push_back(makeModel(grid.parameters(point)));
+        }
+        std::vector<std::vector<ProbabilityData>> gridData = evaluate(models, biases);
+        for (int m = 0; m < models.size(); m++) {
+            for (int b = 0; b < numBiases; b++) {
+                T model = models[m];
+                model.bias = biases[b];
+                double NLL = gridData[m][b].NLL;
+                grid.values[batch[m] + b] = NLL;
+                info.likelihoods.insert({model, NLL});
+                if (NLL < progress.bestNLL) {
+                    progress.bestNLL = NLL;
+                    info.optimal = model;
+                    optimalPoint = batch[m];
+                }
+            }
+        }
+
+        progress.modelsDone += batch.size() * numBiases;
+        progress.elapsedSeconds = elapsed();
+        progress.etaSeconds = progress.elapsedSeconds / progress.modelsDone *
+            (progress.numModels - progress.modelsDone);
+        if (options.progress) {
+            options.progress(progress);
+        }
+    }
+    info.complete = lattice.empty() && remaining.empty();
+    info.grid = std::move(grid);
+    return info;
+}
+
+#endif
@@ -0,0 +1,308 @@
+#ifndef COMPUTE_BACKEND_H
+#define COMPUTE_BACKEND_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "ddm.h"
+#include "addm.h"
+#include "mle_info.h"
+#include "trial_batch.h"
+
+/**
+ * @brief Interface of a likelihood engine that can be selected by name when fitting models.
+ *
+ * Each backend computes the total Negative Log Likelihood (NLL) of a dataset for a single DDM or
+ * aDDM. Backends are created by getComputeBackend from one of the names listed in
+ * validComputeMethods.
+ *
+ */
+class ComputeBackend {
+    private:
+    public:
+        virtual ~ComputeBackend() {}
+
+        /**
+         * @brief Compute the total NLL of a vector of DDMTrials for a single DDM.
+         *
+         * @param ddm Model to compute the NLL for.
+         * @param trials Vector of DDMTrials that the model should calculate the NLL for.
+         * @param trialsPerThread Number of trials that each thread should be designated to
+         * compute, if the backend distributes individual trials.
+         * @param timeStep Value in milliseconds used for binning the time axis.
+         * @param approxStateStep Used for binning the RDV axis.
+         * @return ProbabilityData containing NLL, sum of likelihoods, and a list of all computed
+         * likelihoods.
+         */
+        virtual ProbabilityData computeNLL(
+            DDM &ddm, const vector<DDMTrial> &trials,
+            int trialsPerThread, int timeStep, float approxStateStep) = 0;
+
+        /**
+         * @brief Compute the total NLL of a vector of aDDMTrials for a single aDDM.
+         *
+         * @param addm Model to compute the NLL for.
+         * @param trials Vector of aDDMTrials that the model should calculate the NLL for.
+         * @param trialsPerThread Number of trials that each thread should be designated to
+         * compute.
+         * @param timeStep Value in milliseconds used for binning the time axis.
+         * @param approxStateStep Used for binning the RDV axis.
+         * @return ProbabilityData containing NLL, sum of likelihoods, and a list of all computed
+         * likelihoods.
+         */
+        virtual ProbabilityData computeNLL(
+            aDDM &addm, const vector<aDDMTrial> &trials,
+            int trialsPerThread, int timeStep, float approxStateStep) = 0;
+
+        /**
+         * @brief Compute the total NLL of a TrialBatch for a single DDM. By default the trials are
+         * copied out of the batch and passed to the vector overload; backends that consume the 
+         * columns directly override this. 
+         *
+         * @param ddm Model to compute the NLL for.
+         * @param trials TrialBatch that the model should calculate the NLL for.
+         * @param trialsPerThread Number of trials that each thread should be designated to
+         * compute, if the backend distributes individual trials.
+         * @param timeStep Value in milliseconds used for binning the time axis.
+         * @param approxStateStep Used for binning the RDV axis.
+         * @return ProbabilityData containing NLL, sum of likelihoods, and a list of all computed
+         * likelihoods.
+         */
+        virtual ProbabilityData computeNLL(
+            DDM &ddm, const TrialBatch &trials,
+            int trialsPerThread, int timeStep, float approxStateStep);
+
+        /**
+         * @brief Compute the total NLL of a TrialBatch for a single aDDM. See the DDM overload. 
+         *
+         * @param addm Model to compute the NLL for.
+         * @param trials TrialBatch that the model should calculate the NLL for.
+         * @param trialsPerThread Number of trials that each thread should be designated to
+         * compute.
+         * @param timeStep Value in milliseconds used for binning the time axis.
+         * @param approxStateStep Used for binning the RDV axis.
+         * @return ProbabilityData containing NLL, sum of likelihoods, and a list of all computed
+         * likelihoods.
+         */
+        virtual ProbabilityData computeNLL(
+            aDDM &addm, const TrialBatch &trials,
+            int trialsPerThread, int timeStep, float approxStateStep);
+
+        /**
+         * @brief Compute the total NLL of a vector of DDMTrials for a DDM under every bias in a 
+         * grid. By default each bias is computed with a separate call to computeNLL. 
+         *
+         * @param ddm Model to compute the NLL for. Its bias is ignored.
+         * @param trials Vector of DDMTrials that the model should calculate the NLL for.
+         * @param biases Initial RDV values to compute the NLL for.
+         * @param trialsPerThread Number of trials that each thread should be designated to
+         * compute, if the backend distributes individual trials.
+         * @param timeStep Value in milliseconds used for binning the time axis.
+         * @param approxStateStep Used for binning the RDV axis.
+         * @return vector of ProbabilityData, one per entry of biases.
+         */
+        virtual vector<ProbabilityData> computeNLLs(
+            DDM &ddm, const vector<DDMTrial> &trials, const vector<float> &biases,
+            int trialsPerThread, int timeStep, float approxStateStep);
+
+        /**
+         * @brief Compute the total NLL of a vector of aDDMTrials for an aDDM under every bias in a
+         * grid. By default each bias is computed with a separate call to computeNLL. 
+         *
+         * @param addm Model to compute the NLL for. Its bias is ignored.
+         * @param trials Vector of aDDMTrials that the model should calculate the NLL for.
+         * @param biases Initial RDV values to compute the NLL for.
+         * @param trialsPerThread Number of trials that each thread should be designated to
+         * compute.
+         * @param timeStep Value in milliseconds used for binning the time axis.
+         * @param approxStateStep Used for binning the RDV axis.
+         * @return vector of ProbabilityData, one per entry of biases.
+         */
+        virtual vector<ProbabilityData> computeNLLs(
+            aDDM &addm, const vector<aDDMTrial> &trials, const vector<float> &biases,
+            int trialsPerThread, int timeStep, float approxStateStep);
+
+        /**
+         * @brief Compute the total NLL of a vector of DDMTrials for every model of a grid under 
+         * every bias. By default each model is computed with a separate call to computeNLLs. 
+         *
+         * @param models Models to compute the NLL for. Their biases are ignored.
+         * @param trials Vector of DDMTrials that the models should calculate the NLL for.
+         * @param biases Initial RDV values to compute the NLL for.
+         * @param trialsPerThread Number of trials that each thread should be designated to
+         * compute, if the backend distributes individual trials.
+         * @param timeStep Value in milliseconds used for binning the time axis.
+         * @param approxStateStep Used for binning the RDV axis.
+         * @param keepTrialLikelihoods Whether to return the likelihood of every trial. Without 
+         * them only the sums are returned, so memory does not grow with the number of trials.
+         * @return vector with one entry per model, each holding one ProbabilityData per bias.
+         */
+        virtual vector<vector<ProbabilityData>> computeGridNLLs(
+            const vector<DDM> &models, const vector<DDMTrial> &trials, 
+            const vector<float> &biases, int trialsPerThread, int timeStep, 
+            float approxStateStep, bool keepTrialLikelihoods=true);
+
+        /**
+         * @brief Compute the total NLL of a vector of aDDMTrials for every model of a grid under 
+         * every bias. By default each model is computed with a separate call to computeNLLs. 
+         *
+         * @param models Models to compute the NLL for. Their biases are ignored.
+         * @param trials Vector of aDDMTrials that the models should calculate the NLL for.
+         * @param biases Initial RDV values to compute the NLL for.
+         * @param trialsPerThread Number of trials that each thread should be designated to
+         * compute.
+         * @param timeStep Value in milliseconds used for binning the time axis.
+         * @param approxStateStep Used for binning the RDV axis.
+         * @param keepTrialLikelihoods Whether to return the likelihood of every trial.
+         * @return vector with one entry per model, each holding one ProbabilityData per bias.
+         */
+        virtual vector<vector<ProbabilityData>> computeGridNLLs(
+            const vector<aDDM> &models, const vector<aDDMTrial> &trials, 
+            const vector<float> &biases, int trialsPerThread, int timeStep, 
+            float approxStateStep, bool keepTrialLikelihoods=true);
+
+        /**
+         * @brief Compute the total NLL of a TrialBatch for every model of a grid under every 
+         * bias. By default the trials are copied out of the batch once and passed to the vector 
+         * overload. 
+         *
+         * @param models Models to compute the NLL for. Their biases are ignored.
+         * @param trials TrialBatch that the models should calculate the NLL for.
+         * @param biases Initial RDV values to compute the NLL for.
+         * @param trialsPerThread Number of trials that each thread should be designated to
+         * compute, if the backend distributes individual trials.
+         * @param timeStep Value in milliseconds used for binning the time axis.
+         * @param approxStateStep Used for binning the RDV axis.
+         * @param keepTrialLikelihoods Whether to return the likelihood of every trial.
+         * @return vector with one entry per model, each holding one ProbabilityData per bias.
+         */
+        virtual vector<vector<ProbabilityData>> computeGridNLLs(
+            const vector<DDM> &models, const TrialBatch &trials, 
+            const vector<float> &biases, int trialsPerThread, int timeStep, 
+            float approxStateStep, bool keepTrialLikelihoods=true);
+
+        /**
+         * @brief Compute the total NLL of a TrialBatch for every model of a grid of aDDMs under 
+         * every bias. See the DDM overload. 
+         *
+         * @param models Models to compute the NLL for. Their biases are ignored.
+         * @param trials TrialBatch that the models should calculate the NLL for.
+         * @param biases Initial RDV values to compute the NLL for.
+         * @param trialsPerThread Number of trials that each thread should be designated to
+         * compute.
+         * @param timeStep Value in milliseconds used for binning the time axis.
+         * @param approxStateStep Used for binning the RDV axis.
+         * @param keepTrialLikelihoods Whether to return the likelihood of every trial.
+         * @return vector with one entry per model, each holding one ProbabilityData per bias.
+         */
+        virtual vector<vector<ProbabilityData>> computeGridNLLs(
+            const vector<aDDM> &models, const TrialBatch &trials, 
+            const vector<float> &biases, int trialsPerThread, int timeStep, 
+            float approxStateStep, bool keepTrialLikelihoods=true);
+
+        /**
+         * @brief Compute the total NLL of a vector of DDMTrials for every model of a grid under 
+         * every bias, abandoning the models that cannot beat the best NLL found so far (branch 
+         * and bound). The NLL is a sum of non-negative terms, so the trials are accumulated in 
+         * chunks, in the given order, and a model is dropped as soon as its partial NLL exceeds 
+         * the bound under every bias. The bound is lowered whenever a model completes with a 
+         * smaller NLL. By default the models are evaluated one after another with computeNLLs.
+         *
+         * @param models Models to compute the NLL for. Their biases are ignored.
+         * @param trials Vector of DDMTrials that the models should calculate the NLL for, in the 
+         * order they are accumulated.
+         * @param biases Initial RDV values to compute the NLL for.
+         * @param trialsPerThread Number of trials that each thread should be designated to
+         * compute, if the backend distributes individual trials.
+         * @param timeStep Value in milliseconds used for binning the time axis.
+         * @param approxStateStep Used for binning the RDV axis.
+         * @param bound Initial bound, such as the NLL of a model evaluated beforehand. Updated in
+         * place to the smallest NLL found.
+         * @return vector with one entry per model, each holding one ProbabilityData per bias. 
+         * Dropped models have an NLL of infinity. trialLikelihoods are left empty.
+         */
+        virtual vector<vector<ProbabilityData>> computeBoundedGridNLLs(
+            const vector<DDM> &models, const vector<DDMTrial> &trials, 
+            const vector<float> &biases, int trialsPerThread, int timeStep, 
+            float approxStateStep, double &bound);
+
+        /**
+         * @brief Compute the total NLL of a vector of aDDMTrials for every model of a grid under 
+         * every bias, abandoning the models that cannot beat the best NLL found so far. See the 
+         * DDM overload for details. 
+         *
+         * @param models Models to compute the NLL for. Their biases are ignored.
+         * @param trials Vector of aDDMTrials that the models should calculate the NLL for, in the
+         * order they are accumulated.
+         * @param biases Initial RDV values to compute the NLL for.
+         * @param trialsPerThread Number of trials that each thread should be designated to
+         * compute.
+         * @param timeStep Value in milliseconds used for binning the time axis.
+         * @param approxStateStep Used for binning the RDV axis.
+         * @param bound Initial bound, updated in place to the smallest NLL found.
+         * @return vector with one entry per model, each holding one ProbabilityData per bias. 
+         * Dropped models have an NLL of infinity. trialLikelihoods are left empty.
+         */
+        virtual vector<vector<ProbabilityData>> computeBoundedGridNLLs(
+            const vector<aDDM> &models, const vector<aDDMTrial> &trials, 
+            const vector<float> &biases, int trialsPerThread, int timeStep, 
+            float approxStateStep, double &bound);
+
+        /**
+         * @brief Compute the total NLL of a TrialBatch for every model of a grid of DDMs under 
+         * every bias with branch and bound. By default the trials are copied out of the batch 
+         * once and passed to the vector overload. 
+         *
+         * @param models Models to compute the NLL for. Their biases are ignored.
+         * @param trials TrialBatch that the models should calculate the NLL for, in the order 
+         * they are accumulated.
+         * @param biases Initial RDV values to compute the NLL for.
+         * @param trialsPerThread Number of trials that each thread should be designated to
+         * compute, if the backend distributes individual trials.
+         * @param timeStep Value in milliseconds used for binning the time axis.
+         * @param approxStateStep Used for binning the RDV axis.
+         * @param bound Initial bound, updated in place to the smallest NLL found.
+         * @return vector with one entry per model, each holding one ProbabilityData per bias. 
+         * Dropped models have an NLL of infinity. trialLikelihoods are left empty.
+         */
+        virtual vector<vector<ProbabilityData>> computeBoundedGridNLLs(
+            const vector<DDM> &models, const TrialBatch &trials, 
+            const vector<float> &biases, int trialsPerThread, int timeStep, 
+            float approxStateStep, double &bound);
+
+        /**
+         * @brief Compute the total NLL of a TrialBatch for every model of a grid of aDDMs under 
+         * every bias with branch and bound. See the DDM overload. 
+         *
+         * @param models Models to compute the NLL for. Their biases are ignored.
+         * @param trials TrialBatch that the models should calculate the NLL for, in the order 
+         * they are accumulated.
+         * @param biases Initial RDV values to compute the NLL for.
+         * @param trialsPerThread Number of trials that each thread should be designated to
+         * compute.
+         * @param timeStep Value in milliseconds used for binning the time axis.
+         * @param approxStateStep Used for binning the RDV axis.
+         * @param bound Initial bound, updated in place to the smallest NLL found.
+         * @return vector with one entry per model, each holding one ProbabilityData per bias. 
+         * Dropped models have an NLL of infinity. trialLikelihoods are left empty.
+         */
+        virtual vector<vector<ProbabilityData>> computeBoundedGridNLLs(
+            const vector<aDDM> &models, const TrialBatch &trials, 
+            const vector<float> &biases, int trialsPerThread, int timeStep, 
+            float approxStateStep, double &bound);
+};
+
+/**
+ * @brief Create the likelihood engine corresponding to a compute method. Available methods are:
+ *
+ * - "basic": CPU engine on a single thread.
+ * - "thread": CPU engine on every available core.
+ * - "gpu": CUDA engine. Only available if libaddm was built with CUDA and a device is present.
+ * - "auto": "gpu" when it is available, otherwise "thread".
+ *
+ * @param computeMethod Name of the compute method.
+ * @return std::unique_ptr<ComputeBackend> to the requested backend.
+ */
+std::unique_ptr<ComputeBackend> getComputeBackend(std::string computeMethod);
+
+#endif
@@ -1,9 +1,16 @@
 #ifndef ADDM_TOOLBOX_GPU_H
 #define ADDM_TOOLBOX_GPU_H
 
+#include "anytime.h"
 #include "ddm.h"
 #include "addm.h"
 #include "mle_info.h"
+#include "compute_backend.h"
+#include "optimize.h"
+#include "parameter_grid.h"
+#include "streaming_posterior.h"
+#include "trial_batch.h"
+#include "trial_store.h"
 #include "util.h"
 
 #endif
@@ -14,4 +14,49 @@ __device__ inline double __pdf(float x, float mean, float sigma) {
         sigma * sqrtf(2 * M_PI));
 }
 
+/**
+ * @brief Fill the banded Toeplitz transition kernel for a single time step. The density of moving
+ * by m states is stored at kernel[m - lo] for every offset m in [lo, hi] whose distance from the
+ * mean is at most halfWidth. 
+ */
+__device__ inline void __fillTransitionKernel(
+    float *kernel, int *lo, int *hi, int numStates, float stateStep, 
+    float mean, float sigma, float halfWidth) {
+
+    float maxOffset = numStates - 1; 
+    *lo = (int) fminf(maxOffset, fmaxf(-maxOffset, floorf((mean - halfWidth) / stateStep)));
+    *hi = (int) fminf(maxOffset, fmaxf(-maxOffset, ceilf((mean + halfWidth) / stateStep)));
+    for (int m = *lo; m <= *hi; m++) {
+        kernel[m - *lo] = __pdf(m * stateStep, mean, sigma);
+    }
+}
+
+/**
+ * @brief Density of the mass moved into state i by the banded transition kernel. 
+ */
+__device__ inline double __applyTransitionKernel(
+    const float *kernel, int lo, int hi, const double *prStates, int i, int numStates) {
+
+    int mBegin = max(lo, i - (numStates - 1)); 
+    int mEnd = min(hi, i); 
+    double rowSum = 0; 
+    for (int m = mBegin; m <= mEnd; m++) {
+        rowSum += kernel[m - lo] * prStates[i - m]; 
+    }
+    return rowSum; 
+}
+
+/**
+ * @brief Shrink the support window [lo, hi] of a distribution by zeroing the states at either end
+ * whose probability is at most epsilon. 
+ */
+__device__ inline void __trimSupport(double *prStates, int *lo, int *hi, double epsilon) {
+    while (*lo <= *hi && prStates[*lo] <= epsilon) {
+        prStates[(*lo)++] = 0; 
+    }
+    while (*hi >= *lo && prStates[*hi] <= epsilon) {
+        prStates[(*hi)--] = 0; 
+    }
+}
+
 #endif 
\ No newline at end of file
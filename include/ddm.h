@@ -6,10 +6,16 @@
 #include <functional> 
 #include <tuple>
 #include <map> 
+#include <optional>
 #include "mle_info.h"
+#include "anytime.h"
+#include "optimize.h"
+#include "propagation.h"
 
 using namespace std; 
 
+class TrialBatch;
+
 
 /**
  * @brief Implementation of a single DDMTrial object
@@ -51,7 +57,7 @@ class DDMTrial {
          * @param trials Vector of trials to be saved. 
          * @param filename File to store the trials in. 
          */
-        static void writeTrialsToCSV(vector<DDMTrial> trials, string filename);
+        static void writeTrialsToCSV(const vector<DDMTrial> &trials, const string &filename);
 
         /**
          * @brief Load a dataset of DDMTrials into program memory. 
@@ -59,7 +65,7 @@ class DDMTrial {
          * @param filename Location of the data trials. 
          * @return vector<DDMTrial> containing the stored trials. 
          */
-        static vector<DDMTrial> loadTrialsFromCSV(string filename);
+        static vector<DDMTrial> loadTrialsFromCSV(const string &filename);
 };
 
 /**
@@ -76,10 +82,15 @@ class DDM {
     private:
         void callGetTrialLikelihoodKernel(
             int trialsPerThread, int numBlocks, int threadsPerBlock, 
-            DDMTrial *trials, double *likelihoods, int numTrials, 
+            const TrialBatch &trials, double *likelihoods, 
             float d, float sigma, float barrier, 
             int nonDecisionTime, int timeStep, float approxStateStep, float dec);
 
+        void getCrossingProbabilities(
+            int valDiff, int numTimeSteps, const StateSpace &space, const vector<int> &biasStates, 
+            int timeStep, const PropagationOptions &options, 
+            vector<double> &probUpCrossing, vector<double> &probDownCrossing);
+
     public: 
         float d; /**< Float parameter of the model that controls the speed of integration. Referred
             to as drift rate. */
@@ -94,8 +105,8 @@ class DDM {
             zero means the barriers are constant. */
 
         bool operator <( const DDM &rhs ) const { 
-            return (d * 17) + (sigma * 31) + (bias * 43) + (decay * 59) < 
-                (rhs.d * 17) + (rhs.sigma * 31) + (rhs.bias * 43) + (rhs.decay * 59);
+            return std::tie(d, sigma, bias, decay, barrier, nonDecisionTime) < 
+                std::tie(rhs.d, rhs.sigma, rhs.bias, rhs.decay, rhs.barrier, rhs.nonDecisionTime);
         }
 
         bool operator ==( const DDM &rhs ) const {
@@ -129,7 +140,7 @@ class DDM {
          * @param dt Trial to export
          * @param filename File to store the trial information in. 
          */
-        void exportTrial(DDMTrial dt, std::string filename); 
+        void exportTrial(const DDMTrial &dt, const std::string &filename); 
 
         /**
          * @brief Generate a simulated DDM trial provided item values. 
@@ -142,20 +153,144 @@ class DDM {
          */
         DDMTrial simulateTrial(int valueLeft, int valueRight, int timeStep=10, int seed=-1);
 
+        /**
+         * @brief Compute the likelihood of a single DDMTrial on the CPU. 
+         * 
+         * @param trial DDMTrial to compute the likelihood for. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param options Tuning parameters of the propagation. 
+         * @return double containing the likelihood of the trial, clamped below at 1e-20. 
+         */
+        double getTrialLikelihood(
+            const DDMTrial &trial, int timeStep=10, float approxStateStep=0.1, 
+            PropagationOptions options=PropagationOptions());
+
+        /**
+         * @brief Compute the total Negative Log Likelihood (NLL) for a vector of DDMTrials on the 
+         * CPU. The distribution of the RDV only depends on the value difference of a trial, so 
+         * the state propagation is run once per distinct value difference up to the longest 
+         * response time in that group. The crossing probabilities of every time step are recorded
+         * and each trial reads its likelihood at its own response time. Value differences are 
+         * processed in parallel. 
+         * 
+         * @param trials Vector of DDMTrials that the model should calculate the NLL for. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param numThreads Number of threads to use. 0 uses every available core. 
+         * @param options Tuning parameters of the propagation. 
+         * @return ProbabilityData containing NLL, sum of likelihoods, and a list of all computed 
+         * likelihoods. 
+         */
+        ProbabilityData computeCPUNLL(
+            const vector<DDMTrial> &trials, int timeStep=10, float approxStateStep=0.1, 
+            int numThreads=0, PropagationOptions options=PropagationOptions());
+
+        /**
+         * @brief Compute the total Negative Log Likelihood (NLL) for a vector of DDMTrials under 
+         * every bias in a grid, keeping all other parameters of the model. The propagation is 
+         * linear in the initial distribution, so the initial states of all biases are advanced 
+         * together as the columns of one matrix and each value difference is traversed only 
+         * once. 
+         * 
+         * @param trials Vector of DDMTrials that the model should calculate the NLL for. 
+         * @param biases Initial RDV values to compute the NLL for. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param numThreads Number of threads to use. 0 uses every available core. 
+         * @param options Tuning parameters of the propagation. 
+         * @return vector of ProbabilityData, one per entry of biases. 
+         */
+        vector<ProbabilityData> computeCPUNLL(
+            const vector<DDMTrial> &trials, const vector<float> &biases, int timeStep=10, 
+            float approxStateStep=0.1, int numThreads=0, 
+            PropagationOptions options=PropagationOptions());
+
+        /**
+         * @brief Compute the total Negative Log Likelihood (NLL) for a TrialBatch on the CPU. The 
+         * vector overload packs its trials into a batch and calls this one. 
+         * 
+         * @param trials TrialBatch that the model should calculate the NLL for. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param numThreads Number of threads to use. 0 uses every available core. 
+         * @param options Tuning parameters of the propagation. 
+         * @return ProbabilityData containing NLL, sum of likelihoods, and a list of all computed 
+         * likelihoods. 
+         */
+        ProbabilityData computeCPUNLL(
+            const TrialBatch &trials, int timeStep=10, float approxStateStep=0.1, 
+            int numThreads=0, PropagationOptions options=PropagationOptions());
+
+        /**
+         * @brief Compute the total Negative Log Likelihood (NLL) for a TrialBatch under every 
+         * bias in a grid. See the vector overload. 
+         * 
+         * @param trials TrialBatch that the model should calculate the NLL for. 
+         * @param biases Initial RDV values to compute the NLL for. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param numThreads Number of threads to use. 0 uses every available core. 
+         * @param options Tuning parameters of the propagation. 
+         * @return vector of ProbabilityData, one per entry of biases. 
+         */
+        vector<ProbabilityData> computeCPUNLL(
+            const TrialBatch &trials, const vector<float> &biases, int timeStep=10, 
+            float approxStateStep=0.1, int numThreads=0, 
+            PropagationOptions options=PropagationOptions());
+
+        /**
+         * @brief Compute the likelihood of the trials of a TrialBatch from begin up to, but 
+         * excluding, end under every bias in a grid, reading the trials in place from the 
+         * columns of the batch. 
+         * 
+         * @param trials TrialBatch holding the trials. 
+         * @param begin Index of the first trial to compute. 
+         * @param end Index past the last trial to compute. 
+         * @param biases Initial RDV values to compute the likelihoods for. 
+         * @param likelihoods Output array of (end - begin) * biases.size() likelihoods, where 
+         * likelihoods[(i - begin) * biases.size() + b] is the likelihood of trial i under bias b.
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param numThreads Number of threads to use. 0 uses every available core. 
+         * @param options Tuning parameters of the propagation. 
+         */
+        void computeCPULikelihoods(
+            const TrialBatch &trials, size_t begin, size_t end, const vector<float> &biases, 
+            double *likelihoods, int timeStep, float approxStateStep, int numThreads, 
+            PropagationOptions options);
+
         /**
          * @brief Compute the total Negative Log Likelihood (NLL) for a vector of DDMTrials. Use
          * the GPU to maximize the number of trials being computed in parallel. 
          * 
          * @param trials Vector of DDMTrials that the model should calculate the NLL for. 
          * @param trialsPerThread Number of trials that each thread should be designated to 
-         * copmute. Must be divisible by the total number of trials. 
+         * copmute. The last thread computes any remaining trials. 
          * @param timeStep Value in milliseconds used for binning the time axis. 
          * @param approxStateStep Used for binning the RDV axis. 
          * @return ProbabilityData containing NLL, sum of likelihoods, and a list  of all computed 
          * likelihood. 
          */
         ProbabilityData computeGPUNLL(
-            vector<DDMTrial> trials, int trialsPerThread=10, 
+            const vector<DDMTrial> &trials, int trialsPerThread=10, 
+            int timeStep=10, float approxStateStep=0.1);
+
+        /**
+         * @brief Compute the total Negative Log Likelihood (NLL) for a TrialBatch on the GPU. The 
+         * columns of the batch are uploaded as they are, so a batch built once can be evaluated 
+         * under many models without repacking the trials. 
+         * 
+         * @param trials TrialBatch that the model should calculate the NLL for. 
+         * @param trialsPerThread Number of trials that each thread should be designated to 
+         * compute. The last thread computes any remaining trials. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @return ProbabilityData containing NLL, sum of likelihoods, and a list of all computed 
+         * likelihoods. 
+         */
+        ProbabilityData computeGPUNLL(
+            const TrialBatch &trials, int trialsPerThread=10, 
             int timeStep=10, float approxStateStep=0.1);
 
         /**
@@ -167,9 +302,12 @@ class DDM {
          * @param trials Vector of DDMTrials that each model should calculate the NLL for. 
          * @param rangeD Vector of floats representing possible values of d to dest for. 
          * @param rangeSigma Vector of floats representing possible values of sigma to test for. 
+         * @param computeMethod Likelihood engine used for every model. One of "basic", "thread", 
+         * "gpu", or "auto". See getComputeBackend for details. 
          * @param normalizePosteriors true if the returned MLEinfo should contain a mapping of aDDMs 
          * to the normzlied posteriors distribution for each model; otherwise, the MLEinfo should 
-         * containing a mapping of aDDMs to its corresponding NLL. 
+         * containing a mapping of aDDMs to its corresponding NLL. Every trial likelihood of 
+         * every model is held until the end; see fitModelStreaming for large grids. 
          * @param barrier Positive magnitude of the sigmal threshold.
          * @param nonDecisionTime Amount of time in milliseconds in which only noise is added to 
          * the decision variable. 
@@ -183,13 +321,205 @@ class DDM {
          * means that the barriers are constant. Similarly to the `bias` argument, the three 
          * input forms of no input, a vector with single element, and a vector with a range of 
          * elements. 
-         * @return MLEinfo containing the most optimal model and a mapping of models to floats 
-         * determined by the normalizePosteriors argument. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param trialsPerThread Number of trials that each thread should be designated to 
+         * compute on the GPU. 
+         * @param refinementLevels Number of coarse-to-fine refinement passes after the full grid
+         * of the ranges has been evaluated. Each pass evaluates the models within half the 
+         * previous spacing of the best models found so far, in every dimension with more than one
+         * value. A value of 0 only evaluates the full grid. 
+         * @param refinementNeighborhoods Number of best models that are refined around in each 
+         * pass. 
+         * @param pruning Drop the models whose partial NLL, accumulated over chunks of trials, 
+         * already exceeds the best NLL found so far (branch and bound). The center of the grid is 
+         * evaluated first to set the initial bound and to order the trials so that poor models are
+         * rejected after few of them. Dropped models are left out of the returned MLEinfo. 
+         * Requires normalizePosteriors to be false. 
+         * @param screening Multi-fidelity screening of the grid. If enabled, every model of the 
+         * full grid is first evaluated at the coarse resolution of screening, and only the best 
+         * ones are evaluated at timeStep and approxStateStep, with every bias. The other models 
+         * keep their coarse NLL, and MLEinfo::fidelities records which resolution each NLL comes 
+         * from. Refinement and the optimum only use fine NLLs. With pruning, the best coarse model 
+         * is evaluated first. Requires normalizePosteriors to be false. 
+         * @return MLEinfo containing the most optimal model and a mapping of every evaluated model 
+         * to floats determined by the normalizePosteriors argument. 
+         * The same values are stored by grid index in grid. Models are built and evaluated a 
+         * batch at a time, but likelihoods, and fidelities with screening, are still filled with 
+         * one entry per evaluated model for compatibility, so they grow with the grid; read grid 
+         * for large grids. 
          */
         static MLEinfo<DDM> fitModelMLE(
-            vector<DDMTrial> trials, vector<float> rangeD, vector<float> rangeSigma, 
-            bool normalizePosteriors=false, float barrier=1, unsigned int nonDecisionTime=0, 
-            vector<float> bias={0}, vector<float> decay={0}
+            const vector<DDMTrial> &trials, vector<float> rangeD, vector<float> rangeSigma, 
+            string computeMethod="auto", bool normalizePosteriors=false, float barrier=1, 
+            unsigned int nonDecisionTime=0, vector<float> bias={0}, vector<float> decay={0}, 
+            int timeStep=10, float approxStateStep=0.1, int trialsPerThread=10, 
+            int refinementLevels=0, int refinementNeighborhoods=1, bool pruning=false, 
+            ScreeningOptions screening=ScreeningOptions()
+        );
+
+        /**
+         * @brief fitModelMLE on a TrialBatch, such as one built from a TrialStore. Fixations of 
+         * the batch are ignored. The vector overload packs its trials once and calls this one. 
+         * See the vector overload for the parameters. 
+         * 
+         */
+        static MLEinfo<DDM> fitModelMLE(
+            const TrialBatch &trials, vector<float> rangeD, vector<float> rangeSigma, 
+            string computeMethod="auto", bool normalizePosteriors=false, float barrier=1, 
+            unsigned int nonDecisionTime=0, vector<float> bias={0}, vector<float> decay={0}, 
+            int timeStep=10, float approxStateStep=0.1, int trialsPerThread=10, 
+            int refinementLevels=0, int refinementNeighborhoods=1, bool pruning=false, 
+            ScreeningOptions screening=ScreeningOptions()
+        );
+
+        /**
+         * @brief Compute the posteriors of a grid of DDMs, as fitModelMLE with 
+         * normalizePosteriors, without holding the trial likelihoods of every model. The grid is 
+         * evaluated in batches, and the per-trial log likelihoods of each model are folded into 
+         * the posterior as soon as they are computed. Only the topK models with the smallest NLL
+         * keep their full results, so memory does not grow with the size of the grid. 
+         * 
+         * @param trials Vector of DDMTrials that each model should calculate the NLL for. 
+         * @param rangeD Vector of floats representing possible values of d to test for. 
+         * @param rangeSigma Vector of floats representing possible values of sigma to test for. 
+         * @param computeMethod Likelihood engine used for every model. One of "basic", "thread", 
+         * "gpu", or "auto". See getComputeBackend for details. 
+         * @param barrier Positive magnitude of the signal threshold. 
+         * @param nonDecisionTime Amount of time in milliseconds in which only noise is added to 
+         * the decision variable. 
+         * @param bias Possible values of the initial RDV. 
+         * @param decay Possible values of the decay of the barriers. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param trialsPerThread Number of trials that each thread should be designated to 
+         * compute on the GPU. 
+         * @param topK Number of models whose full results are kept. 
+         * @param modelsPerBatch Number of models, each under every bias, evaluated at once. 
+         * Bounds the number of trial likelihoods held at any time. 
+         * @return MLEinfo containing the most optimal model, a mapping of the topK models to their 
+         * posteriors, their full results in topModels, and the marginal posterior of every value
+         * of each parameter, aligned with the axes of grid. Posteriors use a uniform prior over 
+         * the grid. 
+         */
+        static MLEinfo<DDM> fitModelStreaming(
+            const vector<DDMTrial> &trials, vector<float> rangeD, vector<float> rangeSigma, 
+            string computeMethod="auto", float barrier=1, unsigned int nonDecisionTime=0, 
+            vector<float> bias={0}, vector<float> decay={0}, 
+            int timeStep=10, float approxStateStep=0.1, int trialsPerThread=10, 
+            int topK=10, int modelsPerBatch=64
+        );
+
+        /**
+         * @brief fitModelStreaming on a TrialBatch, such as one built from a TrialStore. Fixations 
+         * of the batch are ignored. The vector overload packs its trials once and calls this one. 
+         * See the vector overload for the parameters. 
+         * 
+         */
+        static MLEinfo<DDM> fitModelStreaming(
+            const TrialBatch &trials, vector<float> rangeD, vector<float> rangeSigma, 
+            string computeMethod="auto", float barrier=1, unsigned int nonDecisionTime=0, 
+            vector<float> bias={0}, vector<float> decay={0}, 
+            int timeStep=10, float approxStateStep=0.1, int trialsPerThread=10, 
+            int topK=10, int modelsPerBatch=64
+        );
+
+        /**
+         * @brief Grid search over the same models as fitModelMLE that can be stopped at any time
+         * and returns the best model found so far. The models are evaluated in batches, first on 
+         * a coarse lattice of the grid and then closest to the best model so far, so the best 
+         * model improves quickly. The fit stops once every model is evaluated, the time limit of 
+         * options has passed, or its cancellation token is cancelled, and it reports its 
+         * progress after every batch. 
+         * 
+         * @param trials Vector of DDMTrials that each model should calculate the NLL for. 
+         * @param rangeD Vector of floats representing possible values of d to test for. 
+         * @param rangeSigma Vector of floats representing possible values of sigma to test for. 
+         * @param computeMethod Likelihood engine used for every model. One of "basic", "thread", 
+         * "gpu", or "auto". See getComputeBackend for details. 
+         * @param barrier Positive magnitude of the signal threshold. 
+         * @param nonDecisionTime Amount of time in milliseconds in which only noise is added to 
+         * the decision variable. 
+         * @param bias Possible values of the initial RDV. 
+         * @param decay Possible values of the decay of the barriers. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param trialsPerThread Number of trials that each thread should be designated to 
+         * compute on the GPU. 
+         * @param options Time limit, cancellation token, progress callback and batch size. 
+         * @return MLEinfo containing the best model found, a mapping of every evaluated model to 
+         * its NLL, the grid holding the same NLLs, and whether every model was evaluated in 
+         * complete. 
+         */
+        static MLEinfo<DDM> fitModelAnytime(
+            const vector<DDMTrial> &trials, vector<float> rangeD, vector<float> rangeSigma, 
+            string computeMethod="auto", float barrier=1, unsigned int nonDecisionTime=0, 
+            vector<float> bias={0}, vector<float> decay={0}, 
+            int timeStep=10, float approxStateStep=0.1, int trialsPerThread=10, 
+            AnytimeOptions options=AnytimeOptions()
+        );
+
+        /**
+         * @brief fitModelAnytime on a TrialBatch, such as one built from a TrialStore. Fixations 
+         * of the batch are ignored. The vector overload packs its trials once and calls this one. 
+         * See the vector overload for the parameters. 
+         * 
+         */
+        static MLEinfo<DDM> fitModelAnytime(
+            const TrialBatch &trials, vector<float> rangeD, vector<float> rangeSigma, 
+            string computeMethod="auto", float barrier=1, unsigned int nonDecisionTime=0, 
+            vector<float> bias={0}, vector<float> decay={0}, 
+            int timeStep=10, float approxStateStep=0.1, int trialsPerThread=10, 
+            AnytimeOptions options=AnytimeOptions()
+        );
+
+        /**
+         * @brief Find the DDM with the minimum NLL for the provided DDMTrials with a bounded 
+         * Nelder-Mead simplex over (d, sigma, bias, decay) instead of a grid. 
+         * 
+         * @param trials Vector of DDMTrials that each model should calculate the NLL for. 
+         * @param rangeD Bounds of d, given as the smallest and largest value of the vector. 
+         * @param rangeSigma Bounds of sigma. 
+         * @param computeMethod Likelihood engine used for every model. One of "basic", "thread", 
+         * "gpu", or "auto". See getComputeBackend for details. 
+         * @param barrier Positive magnitude of the signal threshold. 
+         * @param nonDecisionTime Amount of time in milliseconds in which only noise is added to 
+         * the decision variable. 
+         * @param bias Bounds of the bias. Must lie within the barriers. 
+         * @param decay Bounds of the decay. 
+         * @param timeStep Value in milliseconds used for binning the time axis. 
+         * @param approxStateStep Used for binning the RDV axis. 
+         * @param trialsPerThread Number of trials that each thread should be designated to 
+         * compute on the GPU. 
+         * @param warmStart Initial model of the search, such as the fit of a previous subject. 
+         * Its parameters are clipped to the bounds. If empty, the search starts at the center of 
+         * the bounds. 
+         * @param options Convergence tolerances and evaluation budget of the simplex. 
+         * @return MLEinfo containing the best model found and a mapping of every evaluated model 
+         * to its NLL. 
+         */
+        static MLEinfo<DDM> fitModelOptimize(
+            const vector<DDMTrial> &trials, vector<float> rangeD, vector<float> rangeSigma, 
+            string computeMethod="auto", float barrier=1, unsigned int nonDecisionTime=0, 
+            vector<float> bias={0}, vector<float> decay={0}, 
+            int timeStep=10, float approxStateStep=0.1, int trialsPerThread=10, 
+            std::optional<DDM> warmStart=std::nullopt, 
+            OptimizerOptions options=OptimizerOptions()
+        );
+
+        /**
+         * @brief fitModelOptimize on a TrialBatch, such as one built from a TrialStore. Fixations 
+         * of the batch are ignored. The vector overload packs its trials once and calls this one. 
+         * See the vector overload for the parameters. 
+         * 
+         */
+        static MLEinfo<DDM> fitModelOptimize(
+            const TrialBatch &trials, vector<float> rangeD, vector<float> rangeSigma, 
+            string computeMethod="auto", float barrier=1, unsigned int nonDecisionTime=0, 
+            vector<float> bias={0}, vector<float> decay={0}, 
+            int timeStep=10, float approxStateStep=0.1, int trialsPerThread=10, 
+            std::optional<DDM> warmStart=std::nullopt, 
+            OptimizerOptions options=OptimizerOptions()
         );
 };
 
@@ -0,0 +1,48 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Read-only memory map of a whole file. The file is mapped on construction and unmapped 
+ * when the object is destroyed, so its contents can be parsed in place without copying them into
+ * a buffer. 
+ * 
+ */
+class MappedFile {
+    private:
+        int descriptor; /**< Open file descriptor, or -1. */
+        void *address; /**< Start of the mapping, or nullptr for an empty file. */
+        size_t length; /**< Size of the file in bytes. */
+
+    public:
+        /**
+         * @brief Construct a new MappedFile object mapping the given file. 
+         * 
+         * @param filename Name of the file. 
+         * @throws std::invalid_argument if the file cannot be opened or mapped. 
+         */
+        MappedFile(const std::string &filename);
+
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        /**
+         * @brief First byte of the file. 
+         * 
+         * @return const char * to the mapped contents, or nullptr for an empty file. 
+         */
+        const char *data() const { return static_cast<const char *>(address); }
+
+        /**
+         * @brief Size of the file. 
+         * 
+         * @return size_t number of mapped bytes. 
+         */
+        size_t size() const { return length; }
+};
+
+#endif
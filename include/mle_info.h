@@ -3,18 +3,33 @@
 
 #include <map> 
 #include <vector>
+#include "parameter_grid.h"
 
 /**
- * @brief Information returned by MLE computations containing the most optimal model and 
- * NLLs/marginalized posteriors, as specified. 
+ * @brief Discretization a score of a screened grid search was computed at. 
  * 
- * @tparam T DDM or aDDM. 
  */
-template <typename T>
-struct MLEinfo {
-    T optimal; /**< Most optimal model. */
-    std::map<T, float> likelihoods; /**< Either a mapping of models to NLLs or models to 
-        marginalized posteriors. */
+enum class Fidelity {
+    Coarse, /**< Resolution of the screening pass, see ScreeningOptions. */
+    Fine /**< Requested timeStep and approxStateStep. */
+};
+
+/**
+ * @brief Settings of the multi-fidelity screening of a grid search. Every model is first 
+ * evaluated at a coarse discretization, and only the most promising ones are evaluated again at 
+ * the requested resolution. The likelihood cost grows with 1 / approxStateStep and 1 / timeStep,
+ * so the coarse pass costs a small fraction of the fine one. 
+ * 
+ */
+struct ScreeningOptions {
+    bool enabled = false; /**< Screen the grid before evaluating it at the full resolution. */
+    int timeStep = 50; /**< Value in milliseconds used for binning the time axis in the coarse 
+        pass. */
+    float approxStateStep = 0.2; /**< Used for binning the RDV axis in the coarse pass. */
+    double topFraction = 0.1; /**< Fraction of the models with the smallest coarse NLL that is 
+        evaluated again. At least one model is. */
+    double margin = 0; /**< Models whose coarse NLL is within margin of the smallest coarse NLL
+        are evaluated again as well. Coarse NLLs are only comparable with each other. */
 };
 
 /**
@@ -46,4 +61,44 @@ class ProbabilityData {
         };
 };
 
+/**
+ * @brief Information returned by MLE computations containing the most optimal model and 
+ * NLLs/marginalized posteriors, as specified. 
+ * 
+ * @tparam T DDM or aDDM. 
+ */
+template <typename T>
+struct MLEinfo {
+    T optimal; /**< Most optimal model. */
+    std::map<T, float> likelihoods; /**< Either a mapping of models to NLLs or models to 
+        marginalized posteriors. */
+    std::map<T, Fidelity> fidelities; /**< Discretization each NLL in likelihoods was computed 
+        at. Only filled by screened grid searches. */
+    ParameterGrid grid; /**< Grid of the ranges of a grid search, holding the same value as 
+        likelihoods for every grid point that has one. Models added by refinement lie off the 
+        grid and only appear in likelihoods. Streaming fits leave its values empty. Empty for 
+        other fits. */
+    std::vector<std::vector<double>> marginals; /**< Marginal posterior of every value of each 
+        axis of grid. Only filled by streaming fits. */
+    std::map<T, ProbabilityData> topModels; /**< Full results, including the trial likelihoods, 
+        of the models with the smallest NLL. Only filled by streaming fits. */
+    bool complete = true; /**< false if an anytime fit stopped at its time limit or was 
+        cancelled before every model was evaluated. */
+    bool converged = true; /**< false if the optimizer of fitModelOptimize or fitModelLBFGSB 
+        stopped at its maxEvaluations before meeting its tolerances. */
+    int numEvaluations = 0; /**< Number of objective calls made by the optimizer of 
+        fitModelOptimize or fitModelLBFGSB. Those of fitModelOptimize include repeated points 
+        answered from its scores. */
+};
+
+/**
+ * @brief Negative Log Likelihood (NLL) of a dataset of trials together with its gradient with 
+ * respect to the parameters of the model. 
+ * 
+ */
+struct NLLGradient {
+    double NLL = 0; /**< Sum of negative log likelihoods for all trials. */
+    std::vector<double> gradient; /**< Derivative of the NLL with respect to each parameter. */
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,76 @@
+#ifndef OPTIMIZE_H
+#define OPTIMIZE_H
+
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Convergence settings of the bounded optimizers used by fitModelOptimize and 
+ * fitModelLBFGSB. 
+ * 
+ */
+struct OptimizerOptions {
+    double xTolerance = 1e-3; /**< The search stops once every vertex of the simplex lies within 
+        xTolerance of the best vertex in every parameter, measured as a fraction of the width of 
+        the parameter's bounds, and the NLLs of the vertices are within fTolerance. */
+    double fTolerance = 1e-2; /**< Largest spread of the NLLs of the simplex vertices at 
+        convergence. */
+    int maxEvaluations = 200; /**< Largest number of likelihood evaluations. */
+    double initialStep = 0.1; /**< Length of the edges of the initial simplex as a fraction of 
+        the width of each parameter's bounds. A warm start close to the optimum converges in 
+        fewer evaluations with a smaller step. */
+    double gTolerance = 1e-3; /**< L-BFGS-B stops once no component of the projected gradient 
+        exceeds gTolerance, with each parameter scaled to the width of its bounds. */
+    int historySize = 6; /**< Number of previous steps L-BFGS-B keeps to approximate the inverse
+        Hessian. */
+};
+
+/**
+ * @brief Outcome of a bounded Nelder-Mead minimization. 
+ * 
+ */
+struct OptimizerResult {
+    std::vector<double> x; /**< Best point found. */
+    double value; /**< Objective at x. */
+    int numEvaluations; /**< Number of calls to the objective. */
+    bool converged; /**< Whether the tolerances were met before maxEvaluations. */
+};
+
+/**
+ * @brief Minimize a function over a box with the Nelder-Mead simplex method. Every trial point is
+ * projected onto the box before it is evaluated. Parameters whose lower and upper bounds are 
+ * equal are held fixed and do not take part in the simplex. 
+ * 
+ * @param fn Objective. 
+ * @param x0 Initial point. Projected onto the box. 
+ * @param lower Lower bound of each parameter. 
+ * @param upper Upper bound of each parameter. 
+ * @param options Convergence settings. 
+ * @return OptimizerResult with the best point found. 
+ */
+OptimizerResult nelderMead(
+    const std::function<double(const std::vector<double> &)> &fn, std::vector<double> x0, 
+    const std::vector<double> &lower, const std::vector<double> &upper, 
+    const OptimizerOptions &options=OptimizerOptions());
+
+/**
+ * @brief Minimize a differentiable function over a box with a projected limited-memory BFGS 
+ * method (L-BFGS-B). Parameters at a bound whose gradient points out of the box are held at the 
+ * bound for the step, the two-loop recursion gives a quasi-Newton direction for the others, and 
+ * a backtracking line search along the projected path enforces sufficient decrease. Parameters 
+ * whose lower and upper bounds are equal are held fixed. 
+ * 
+ * @param fn Objective. Returns the value at x and stores the gradient in its second argument. 
+ * @param x0 Initial point. Projected onto the box. 
+ * @param lower Lower bound of each parameter. 
+ * @param upper Upper bound of each parameter. 
+ * @param options Convergence settings. initialStep is the length of the first step, before any 
+ * curvature information is available. 
+ * @return OptimizerResult with the best point found. numEvaluations counts the calls to fn. 
+ */
+OptimizerResult lbfgsb(
+    const std::function<double(const std::vector<double> &, std::vector<double> &)> &fn, 
+    std::vector<double> x0, const std::vector<double> &lower, const std::vector<double> &upper, 
+    const OptimizerOptions &options=OptimizerOptions());
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef PARAMETER_GRID_H
+#define PARAMETER_GRID_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Cartesian grid of model parameters together with a dense tensor holding one result per 
+ * grid point. 
+ * 
+ * Grid points are never materialized: a point is identified by its flat index, and its 
+ * coordinates and parameter values are computed from the index on demand. Results are stored 
+ * contiguously in row-major order, with the last axis varying fastest, so filling and scanning 
+ * the grid walks memory linearly. 
+ * 
+ */
+class ParameterGrid {
+    private:
+        std::vector<size_t> strides; /**< Distance in values between neighbors along each axis. */
+
+    public:
+        std::vector<std::string> names; /**< Name of the parameter of each axis. */
+        std::vector<std::vector<float>> axes; /**< Sorted, distinct values of each parameter. */
+        std::vector<double> values; /**< Result of every grid point, indexed by its flat index. 
+            NaN for points without a result. */
+
+        /**
+         * @brief Construct a new ParameterGrid object. Every result is set to NaN. 
+         * 
+         * @param names Name of the parameter of each axis. 
+         * @param axes Values of each parameter. They are sorted and duplicates are removed. 
+         * @param storeValues Allocate the result tensor. Grids that are only enumerated, such as 
+         * those of streaming fits, leave values empty. 
+         */
+        ParameterGrid(
+            std::vector<std::string> names, std::vector<std::vector<float>> axes, 
+            bool storeValues=true);
+
+        /**
+         * @brief Construct an empty ParameterGrid object. 
+         * 
+         */
+        ParameterGrid() {}
+
+        /**
+         * @brief Number of grid points. 
+         * 
+         * @return size_t product of the lengths of the axes, or 0 for an empty grid. 
+         */
+        size_t size() const;
+
+        /**
+         * @brief Flat index of a grid point. 
+         * 
+         * @param coordinates Position of the point along each axis. 
+         * @return size_t index of the point in values. 
+         */
+        size_t index(const std::vector<int> &coordinates) const;
+
+        /**
+         * @brief Position of a grid point along each axis. 
+         * 
+         * @param index Flat index of the point. 
+         * @return std::vector<int> with one coordinate per axis. 
+         */
+        std::vector<int> coordinates(size_t index) const;
+
+        /**
+         * @brief Parameter values of a grid point. 
+         * 
+         * @param index Flat index of the point. 
+         * @return std::vector<float> with one value per axis, in the order of names. 
+         */
+        std::vector<float> parameters(size_t index) const;
+
+        /**
+         * @brief Flat index of the grid point with the given parameter values. 
+         * 
+         * @param parameters One value per axis, in the order of names. 
+         * @return long index of the point, or -1 if any value is not on its axis. 
+         */
+        long find(const std::vector<float> &parameters) const;
+};
+
+#endif
@@ -0,0 +1,541 @@
+#ifndef PROPAGATION_H
+#define PROPAGATION_H
+
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <tuple>
+#include <vector>
+
+/**
+ * @brief Discretization of the relative decision value (RDV) axis used by the likelihood engines.
+ *
+ * The RDV axis between the two barriers is divided into an odd number of equally sized bins,
+ * with the center of each bin stored in the states vector. The bin closest to the model bias is
+ * used as the initial state of every trial.
+ *
+ */
+class StateSpace {
+    private:
+    public:
+        float stateStep; /**< Width of a single state bin. */
+        int numStates; /**< Total number of state bins. */
+        int biasState; /**< Index of the state bin closest to the bias. */
+        std::vector<float> states; /**< Center of each state bin in ascending order. */
+
+        /**
+         * @brief Construct a new StateSpace object.
+         *
+         * @param barrier Positive magnitude of the signal threshold.
+         * @param approxStateStep Approximate width of each state bin.
+         * @param bias Initial RDV used to select the initial state bin.
+         */
+        StateSpace(float barrier, float approxStateStep, float bias=0);
+};
+
+
+/**
+ * @brief Distance from the mean beyond which the transition density is dropped. 
+ * 
+ * @param sigma Standard deviation of the RDV change during a single time step. 
+ * @param tailMass Probability mass dropped from both tails together. 
+ * @return double Half width of the kept band, or DBL_MAX if tailMass is not positive. 
+ */
+double transitionKernelHalfWidth(float sigma, double tailMass);
+
+/**
+ * @brief Banded Toeplitz operator that moves probability mass between states in a single time 
+ * step. 
+ * 
+ * The mass moved from state j to state i only depends on the offset m = i - j, so the operator is
+ * stored as a single vector of weights stateStep * pdf(m * stateStep) for the offsets in [lo, hi].
+ * Offsets whose distance from the mean exceeds the quantile corresponding to the tail mass are 
+ * dropped, so applying the operator costs O(numStates * (hi - lo + 1)) instead of 
+ * O(numStates^2). 
+ * 
+ */
+class TransitionKernel {
+    private:
+    public:
+        int lo; /**< Smallest state offset with a nonzero weight. */
+        int hi; /**< Largest state offset with a nonzero weight. */
+        std::vector<double> weights; /**< Weight of offset m stored at weights[m - lo]. */
+
+        /**
+         * @brief Construct a new TransitionKernel object. 
+         * 
+         * @param space State discretization. 
+         * @param mean Mean of the RDV change during a single time step. 
+         * @param sigma Standard deviation of the RDV change during a single time step. 
+         * @param tailMass Maximum probability mass dropped from the tails of the density. 
+         */
+        TransitionKernel(const StateSpace &space, float mean, float sigma, double tailMass);
+
+        /**
+         * @brief Construct an empty TransitionKernel object. 
+         * 
+         */
+        TransitionKernel() {}
+
+        /**
+         * @brief Apply the operator to numColumns distributions over states interleaved as 
+         * in[i * numColumns + c]: out[i] = sum over m of weights[m - lo] * in[i - m]. Only the 
+         * support of the input is read and only the support of the output is written. 
+         * 
+         * @param in Input distributions of size numStates * numColumns, zero outside 
+         * [inLo, inHi]. 
+         * @param out Output distributions of size numStates * numColumns. Must not alias in. 
+         * @param numStates Number of states. 
+         * @param inLo First state of the input support. 
+         * @param inHi Last state of the input support. 
+         * @param outLo Output first state of the output support. 
+         * @param outHi Output last state of the output support. Less than outLo if the support is 
+         * empty. 
+         * @param numColumns Number of interleaved distributions. 
+         */
+        void apply(
+            const double *in, double *out, int numStates, int inLo, int inHi, 
+            int &outLo, int &outHi, int numColumns=1) const;
+
+        /**
+         * @brief Apply the transposed operator to a row vector over states: 
+         * out[j] = sum over m of weights[m - lo] * in[j + m]. 
+         * 
+         * @param in Input row vector of size numStates. 
+         * @param out Output row vector of size numStates. Must not alias in. 
+         * @param numStates Number of states. 
+         */
+        void applyTranspose(const double *in, double *out, int numStates) const;
+};
+
+/**
+ * @brief TransitionKernels of several models interleaved as lanes, so that the distributions of 
+ * numLanes models stored as the columns of one matrix are advanced in a single pass. 
+ * 
+ * Every kernel is padded with zeros to the union of their bands, so the weights of one offset 
+ * form a contiguous vector with one entry per lane. 
+ * 
+ */
+class LaneKernel {
+    private:
+    public:
+        int lo; /**< Smallest state offset with a nonzero weight in any lane. */
+        int hi; /**< Largest state offset with a nonzero weight in any lane. */
+        int numLanes; /**< Number of interleaved kernels. */
+        std::vector<double> weights; /**< Weight of offset m in lane c stored at 
+            weights[(m - lo) * numLanes + c]. */
+
+        /**
+         * @brief Construct a new LaneKernel object. 
+         * 
+         * @param kernels Kernel of each lane. Must be defined on the same StateSpace. 
+         */
+        LaneKernel(const std::vector<const TransitionKernel *> &kernels);
+
+        /**
+         * @brief Construct an empty LaneKernel object. 
+         * 
+         */
+        LaneKernel() {}
+
+        /**
+         * @brief Apply the kernel of every lane to its column of in, interleaved as 
+         * in[i * numLanes + c]. See TransitionKernel::apply. 
+         * 
+         * @param in Input distributions of size numStates * numLanes, zero outside [inLo, inHi]. 
+         * @param out Output distributions of size numStates * numLanes. Must not alias in. 
+         * @param numStates Number of states. 
+         * @param inLo First state of the input support. 
+         * @param inHi Last state of the input support. 
+         * @param outLo Output first state of the output support. 
+         * @param outHi Output last state of the output support. 
+         */
+        void apply(
+            const double *in, double *out, int numStates, int inLo, int inHi, 
+            int &outLo, int &outHi) const;
+};
+
+/**
+ * @brief Compute the probability of crossing each barrier from every state in a single time step.
+ *
+ * @param space State discretization.
+ * @param mean Mean of the RDV change during a single time step.
+ * @param sigma Standard deviation of the RDV change during a single time step.
+ * @param barrierUp Position of the upper barrier.
+ * @param barrierDown Position of the lower barrier.
+ * @param changeUpCDFs Output probability of crossing the upper barrier from each state.
+ * @param changeDownCDFs Output probability of crossing the lower barrier from each state.
+ */
+void computeCrossingCDFs(
+    const StateSpace &space, float mean, float sigma, float barrierUp, float barrierDown,
+    std::vector<double> &changeUpCDFs, std::vector<double> &changeDownCDFs);
+
+/**
+ * @brief Probability of crossing each barrier from every state in a single time step. 
+ * 
+ */
+struct CrossingCDFs {
+    std::vector<double> changeUpCDFs; /**< Probability of crossing the upper barrier. */
+    std::vector<double> changeDownCDFs; /**< Probability of crossing the lower barrier. */
+};
+
+/**
+ * @brief Derivatives of a TransitionKernel with respect to the mean and the standard deviation of
+ * the RDV change. Both share the band of the kernel, since the dropped offsets have no weight. 
+ * 
+ */
+struct KernelDerivatives {
+    TransitionKernel dMean; /**< Derivative of every weight with respect to the mean. */
+    TransitionKernel dSigma; /**< Derivative of every weight with respect to sigma. */
+
+    /**
+     * @brief Construct a new KernelDerivatives object. 
+     * 
+     * @param space State discretization. 
+     * @param kernel Kernel to differentiate. 
+     * @param mean Mean of the RDV change the kernel was built with. 
+     * @param sigma Standard deviation of the RDV change the kernel was built with. 
+     */
+    KernelDerivatives(
+        const StateSpace &space, const TransitionKernel &kernel, float mean, float sigma);
+};
+
+/**
+ * @brief Derivatives of the crossing CDFs with respect to the mean and the standard deviation of 
+ * the RDV change. 
+ * 
+ */
+struct CrossingCDFDerivatives {
+    std::vector<double> changeUpDMean; /**< Derivative of changeUpCDFs with respect to the mean. */
+    std::vector<double> changeUpDSigma; /**< Derivative of changeUpCDFs with respect to sigma. */
+    std::vector<double> changeDownDMean; /**< Derivative of changeDownCDFs with respect to the 
+        mean. */
+    std::vector<double> changeDownDSigma; /**< Derivative of changeDownCDFs with respect to 
+        sigma. */
+
+    /**
+     * @brief Construct a new CrossingCDFDerivatives object. 
+     * 
+     * @param space State discretization. 
+     * @param mean Mean of the RDV change during a single time step. 
+     * @param sigma Standard deviation of the RDV change during a single time step. 
+     * @param barrierUp Position of the upper barrier. 
+     * @param barrierDown Position of the lower barrier. 
+     */
+    CrossingCDFDerivatives(
+        const StateSpace &space, float mean, float sigma, float barrierUp, float barrierDown);
+};
+
+/**
+ * @brief Advances the RDV distribution over many time steps with the same drift and barriers in a
+ * single call. 
+ * 
+ * With a constant operator M, the distribution after t steps is proportional to M^t applied to 
+ * the initial distribution. The operator stores M^(2^b) for every bit b of maxSteps so that M^t 
+ * costs one matrix-vector product per set bit of t, and the row vectors 1^T M^t, up^T M^t and 
+ * down^T M^t for t in [0, maxSteps]. A single dot product with each row then gives the surviving
+ * and absorbed mass of step t, so the per-step renormalization of propagateStep is reproduced 
+ * exactly without materializing the intermediate distributions. Only valid while no state lies 
+ * beyond the barriers, i.e. when the barriers do not decay. 
+ * 
+ */
+class SkipAheadOperator {
+    private:
+    public:
+        int numStates; /**< Number of states. */
+        int maxSteps; /**< Largest number of steps the operator can advance by. */
+        std::vector<std::vector<double>> powers; /**< powers[b] holds M^(2^b) in row-major order. */
+        std::vector<double> sumRows; /**< Row t holds 1^T M^t. */
+        std::vector<double> upRows; /**< Row t holds up^T M^t. */
+        std::vector<double> downRows; /**< Row t holds down^T M^t. */
+
+        /**
+         * @brief Construct a new SkipAheadOperator object. 
+         * 
+         * @param space State discretization. 
+         * @param kernel Transition operator of every step. 
+         * @param cdfs Crossing CDFs of every step. 
+         * @param maxSteps Largest number of steps the operator can advance by. 
+         */
+        SkipAheadOperator(
+            const StateSpace &space, const TransitionKernel &kernel, const CrossingCDFs &cdfs, 
+            int maxSteps);
+
+        /**
+         * @brief Advance numColumns interleaved distributions by numSteps time steps. Equivalent
+         * to numSteps calls of propagateStep with the same kernel and CDFs. 
+         * 
+         * @param numSteps Number of time steps in [1, maxSteps]. 
+         * @param prStates Distributions over states, updated in place. 
+         * @param scratch Scratch buffer of size numStates * numColumns. 
+         * @param probUpCrossing Output probability of crossing the upper barrier in the last step,
+         * one per column.
+         * @param probDownCrossing Output probability of crossing the lower barrier in the last 
+         * step, one per column.
+         * @param supportLo First state of the support, updated in place. 
+         * @param supportHi Last state of the support, updated in place. 
+         * @param supportEpsilon Largest probability trimmed from the ends of the support. 
+         * @param numColumns Number of interleaved distributions. 
+         */
+        void advance(
+            int numSteps, std::vector<double> &prStates, std::vector<double> &scratch, 
+            double *probUpCrossing, double *probDownCrossing, 
+            int &supportLo, int &supportHi, double supportEpsilon, int numColumns=1) const;
+
+        /**
+         * @brief Number of doubles held by the operator. 
+         */
+        size_t numValues() const;
+};
+
+/**
+ * @brief Thread-safe store of the transition kernels and crossing CDFs computed by the CPU 
+ * likelihood engines. 
+ * 
+ * An aDDM trial only has three distinct drift means, and most trials and many models of a grid 
+ * share them, so each kernel and set of CDFs is computed once and reused by every later request 
+ * with the same key. Kernels are keyed by (mean, sigma, stateStep, numStates, tailMass). CDFs are 
+ * keyed by (mean, sigma, stateStep, numStates) and the barrier positions, which with a nonzero 
+ * decay identify the time index of the step. Once the store holds maxCachedValues values, new 
+ * kernels and CDFs are computed but no longer stored, while new skip-ahead operators replace the 
+ * ones already held. 
+ * 
+ */
+class PropagationCache {
+    private:
+        using KernelKey = std::tuple<float, float, float, int, double>;
+        using CDFKey = std::tuple<float, float, float, int, float, float>;
+
+        std::map<KernelKey, std::shared_ptr<const TransitionKernel>> kernels;
+        std::map<CDFKey, std::shared_ptr<const CrossingCDFs>> crossingCDFs;
+        std::map<std::tuple<KernelKey, float, float>, std::shared_ptr<const SkipAheadOperator>> 
+            skipAheadOperators;
+        size_t numCachedValues = 0;
+        size_t maxCachedValues;
+        mutable std::shared_mutex mutex;
+
+    public:
+        /**
+         * @brief Construct a new PropagationCache object. 
+         * 
+         * @param maxCachedValues Maximum number of kernel weights and CDF values held at once. 
+         */
+        PropagationCache(size_t maxCachedValues=(1 << 22));
+
+        /**
+         * @brief Get the transition kernel of a single time step, computing it on a miss. 
+         * 
+         * @param space State discretization. 
+         * @param mean Mean of the RDV change during a single time step. 
+         * @param sigma Standard deviation of the RDV change during a single time step. 
+         * @param tailMass Maximum probability mass dropped from the tails of the density. 
+         * @return std::shared_ptr to the kernel. 
+         */
+        std::shared_ptr<const TransitionKernel> getTransitionKernel(
+            const StateSpace &space, float mean, float sigma, double tailMass);
+
+        /**
+         * @brief Get the crossing CDFs of a single time step, computing them on a miss. 
+         * 
+         * @param space State discretization. 
+         * @param mean Mean of the RDV change during a single time step. 
+         * @param sigma Standard deviation of the RDV change during a single time step. 
+         * @param barrierUp Position of the upper barrier. 
+         * @param barrierDown Position of the lower barrier. 
+         * @return std::shared_ptr to the CDFs. 
+         */
+        std::shared_ptr<const CrossingCDFs> getCrossingCDFs(
+            const StateSpace &space, float mean, float sigma, float barrierUp, float barrierDown);
+
+        /**
+         * @brief Get the crossing CDFs of consecutive time steps whose barriers decay as 
+         * barrier / (1 + decay * time). Hits are looked up under a single shared lock, so a 
+         * decaying fixation does not take the lock once per step. 
+         * 
+         * @param space State discretization. 
+         * @param mean Mean of the RDV change during a single time step. 
+         * @param sigma Standard deviation of the RDV change during a single time step. 
+         * @param barrier Positive magnitude of the barriers at time 0. 
+         * @param decay Decay of the barriers per time step. 
+         * @param firstTime Time index of the first step. 
+         * @param numSteps Number of steps. 
+         * @return std::vector of the CDFs of each step, from firstTime on. 
+         */
+        std::vector<std::shared_ptr<const CrossingCDFs>> getDecayingCrossingCDFs(
+            const StateSpace &space, float mean, float sigma, float barrier, float decay, 
+            int firstTime, int numSteps);
+
+        /**
+         * @brief Get an operator that advances at least numSteps time steps with a constant drift
+         * and constant barriers, building or extending it on a miss. 
+         * 
+         * @param space State discretization. 
+         * @param mean Mean of the RDV change during a single time step. 
+         * @param sigma Standard deviation of the RDV change during a single time step. 
+         * @param tailMass Maximum probability mass dropped from the tails of the density. 
+         * @param barrier Positive magnitude of the constant barriers. 
+         * @param numSteps Number of steps the operator must be able to advance by. 
+         * @return std::shared_ptr to the operator, or nullptr if it would take more than half of
+         * the cache. 
+         */
+        std::shared_ptr<const SkipAheadOperator> getSkipAheadOperator(
+            const StateSpace &space, float mean, float sigma, double tailMass, float barrier, 
+            int numSteps);
+
+        /**
+         * @brief Number of kernel weights, CDF values and skip-ahead values currently held. 
+         */
+        size_t size() const;
+
+        /**
+         * @brief Remove every entry. 
+         */
+        void clear();
+};
+
+/**
+ * @brief Tuning parameters of the CPU likelihood engines. 
+ * 
+ */
+struct PropagationOptions {
+    double tailMass = 1e-12; /**< Probability mass of the transition density that may be dropped 
+        from the tails when truncating the transition kernel. A tailMass of 0 keeps the full 
+        numStates x numStates operator. */
+    std::shared_ptr<PropagationCache> cache; /**< Store of kernels and crossing CDFs shared by 
+        every trial and model propagated with these options. If empty, the engines create a 
+        cache for the duration of a single call. */
+    bool skipAhead = true; /**< Advance fixations with a constant drift using a cached 
+        SkipAheadOperator instead of step by step. Only applies to models without decay. */
+    int skipAheadMinSteps = 16; /**< Shortest fixation, in time steps, that is advanced with a 
+        SkipAheadOperator. */
+    double supportEpsilon = 1e-15; /**< States at the ends of the support of the distribution 
+        whose probability is at most supportEpsilon are dropped, so each step only visits the 
+        states that carry mass. Each step drops at most numStates * supportEpsilon of mass, which 
+        bounds the absolute error of a likelihood by numTimeSteps * numStates * supportEpsilon. 
+        With the default, a 1000 step trial over 200 states is off by at most 2e-10, far below 
+        the likelihood of any trial that contributes to an NLL. The relative error of unlikely 
+        trials can be much larger, so keep supportEpsilon well below the smallest likelihood of 
+        interest, or set it to 0 to only drop states without mass, which is exact. */
+    bool lockstep = false; /**< Batch the aDDM trials that share their item values and advance 
+        the trials of a batch that fixate the same item together, as the columns of one matrix. 
+        Trials are regrouped at fixation boundaries. The likelihoods agree with stepping each 
+        trial on its own up to rounding, but skip-ahead propagation is not used. */
+    bool prefixSharing = false; /**< Arrange the aDDM trials that share their item values in a 
+        trie over their sequences of fixated items and fixation lengths in time steps. Each 
+        shared prefix is propagated once and the state is copied at the points where trials 
+        diverge. The likelihoods agree with propagating each trial on its own up to rounding. 
+        Ignored if lockstep is set. */
+};
+
+/**
+ * @brief Shrink the support of numColumns interleaved distributions by zeroing the states at 
+ * either end whose probability is at most supportEpsilon in every column. 
+ * 
+ * @param prStates Distributions over states, updated in place. 
+ * @param supportLo First state of the support, updated in place. 
+ * @param supportHi Last state of the support, updated in place. 
+ * @param supportEpsilon Largest probability that is dropped. 
+ * @param numColumns Number of interleaved distributions. 
+ */
+void trimSupport(
+    std::vector<double> &prStates, int &supportLo, int &supportHi, double supportEpsilon, 
+    int numColumns=1);
+
+/**
+ * @brief Advance the RDV distribution by a single time step. States beyond the barriers are
+ * zeroed and the remaining mass and crossing probabilities are renormalized so that the total
+ * probability is conserved. Only the states in the support window [supportLo, supportHi] are 
+ * visited. The window grows by the kernel offsets and is then trimmed with trimSupport. 
+ * 
+ * Several distributions, e.g. one per initial state, can be advanced together by interleaving 
+ * them as prStates[i * numColumns + c]. Each column is renormalized on its own, so the columns 
+ * evolve as if they were propagated one at a time. 
+ *
+ * @param space State discretization.
+ * @param kernel Transition operator of the current time step.
+ * @param changeUpCDFs Upper crossing probabilities from computeCrossingCDFs.
+ * @param changeDownCDFs Lower crossing probabilities from computeCrossingCDFs.
+ * @param barrierUp Position of the upper barrier at the new time step.
+ * @param barrierDown Position of the lower barrier at the new time step.
+ * @param prStates Distributions over states, zero outside the support and updated in place.
+ * @param prStatesNew Scratch buffer of size numStates * numColumns.
+ * @param probUpCrossing Output probability of crossing the upper barrier in this time step, one
+ * per column.
+ * @param probDownCrossing Output probability of crossing the lower barrier in this time step, 
+ * one per column.
+ * @param supportLo First state of the support, updated in place. 
+ * @param supportHi Last state of the support, updated in place. 
+ * @param supportEpsilon Largest probability trimmed from the ends of the support. 
+ * @param numColumns Number of interleaved distributions. 
+ */
+void propagateStep(
+    const StateSpace &space, const TransitionKernel &kernel,
+    const std::vector<double> &changeUpCDFs, const std::vector<double> &changeDownCDFs,
+    float barrierUp, float barrierDown,
+    std::vector<double> &prStates, std::vector<double> &prStatesNew,
+    double *probUpCrossing, double *probDownCrossing, 
+    int &supportLo, int &supportHi, double supportEpsilon, int numColumns=1);
+
+/**
+ * @brief Advance the distributions of several models, one per lane of a LaneKernel, by a single 
+ * time step. Equivalent to calling propagateStep on every lane with its own kernel and crossing 
+ * CDFs, but the lanes are updated together so that the inner loops run over contiguous lanes. 
+ * 
+ * @param space State discretization shared by every lane. 
+ * @param kernel Transition kernels of the lanes. 
+ * @param changeUpCDFs Probability of crossing the upper barrier from state i in lane c, stored 
+ * at changeUpCDFs[i * numLanes + c]. 
+ * @param changeDownCDFs Probability of crossing the lower barrier, laid out as changeUpCDFs. 
+ * @param barrierUp Position of the upper barrier at the current time step. 
+ * @param barrierDown Position of the lower barrier at the current time step. 
+ * @param prStates Interleaved distributions of the lanes, updated in place. 
+ * @param prStatesNew Scratch buffer of the same size as prStates. 
+ * @param probUpCrossing Output probability of crossing the upper barrier in each lane. 
+ * @param probDownCrossing Output probability of crossing the lower barrier in each lane. 
+ * @param supportLo First state of the support of prStates, updated in place. 
+ * @param supportHi Last state of the support of prStates, updated in place. 
+ * @param supportEpsilon Probability below which states at the ends of the support are dropped. 
+ */
+void propagateLanesStep(
+    const StateSpace &space, const LaneKernel &kernel,
+    const std::vector<double> &changeUpCDFs, const std::vector<double> &changeDownCDFs,
+    float barrierUp, float barrierDown,
+    std::vector<double> &prStates, std::vector<double> &prStatesNew,
+    double *probUpCrossing, double *probDownCrossing, 
+    int &supportLo, int &supportHi, double supportEpsilon);
+
+/**
+ * @brief Advance the RDV distribution by a single time step together with its derivatives with 
+ * respect to numParams model parameters (forward-mode differentiation). The distribution and its
+ * tangents are interleaved as prStates[i * (numParams + 1) + c], where column 0 holds the 
+ * distribution and column c > 0 its derivative with respect to parameter c - 1. 
+ * 
+ * @param space State discretization. 
+ * @param kernel Transition kernel of the time step. 
+ * @param kernelDerivatives Derivatives of kernel. 
+ * @param cdfs Crossing CDFs of the time step. 
+ * @param cdfDerivatives Derivatives of cdfs. 
+ * @param meanSensitivities Derivative of the mean of the RDV change with respect to each 
+ * parameter. 
+ * @param sigmaSensitivities Derivative of sigma with respect to each parameter. 
+ * @param barrierUp Position of the upper barrier at the current time step. 
+ * @param barrierDown Position of the lower barrier at the current time step. 
+ * @param prStates Distribution and tangents, updated in place. 
+ * @param prStatesNew Scratch buffer of the same size as prStates. 
+ * @param probUpCrossing Output probability of crossing the upper barrier followed by its 
+ * derivative with respect to each parameter. 
+ * @param probDownCrossing Output probability of crossing the lower barrier followed by its 
+ * derivatives. 
+ * @param supportLo First state of the support of prStates, updated in place. 
+ * @param supportHi Last state of the support of prStates, updated in place. 
+ */
+void propagateTangentStep(
+    const StateSpace &space, const TransitionKernel &kernel, 
+    const KernelDerivatives &kernelDerivatives, const CrossingCDFs &cdfs, 
+    const CrossingCDFDerivatives &cdfDerivatives, 
+    const std::vector<double> &meanSensitivities, const std::vector<double> &sigmaSensitivities,
+    float barrierUp, float barrierDown,
+    std::vector<double> &prStates, std::vector<double> &prStatesNew,
+    double *probUpCrossing, double *probDownCrossing, int &supportLo, int &supportHi);
+
+#endif
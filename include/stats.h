@@ -31,4 +31,19 @@ inline double cumulativeDensityFunction(float mean, float sigma, float x) {
     return cdf;
 }
 
+/**
+ * @brief Compute the inverse of the cumulative density function provided mean and standard 
+ * deviation. 
+ * 
+ * @param mean Mean of the distribution. 
+ * @param sigma Standard deviation of the distribution. 
+ * @param p Probability to compute the quantile at. Must be in (0, 1). 
+ * @return double containing the computed quantile. 
+ */
+inline double inverseCumulativeDensityFunction(float mean, float sigma, double p) {
+    boost::math::normal_distribution<double> dist(mean, sigma);
+    double quantile = boost::math::quantile(dist, p);
+    return quantile;
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,145 @@
+#ifndef STREAMING_POSTERIOR_H
+#define STREAMING_POSTERIOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "mle_info.h"
+#include "parameter_grid.h"
+
+/**
+ * @brief Posterior of a grid of models under a uniform prior, accumulated one model at a time. 
+ *
+ * Only the normalizer and the marginal of every value of each axis are kept, as sums of 
+ * exp(log likelihood - shift), where shift is the largest log likelihood added so far. The sums 
+ * are rescaled whenever the shift grows, so nothing underflows however many trials there are, 
+ * and memory does not depend on the number of models or trials. 
+ *
+ */
+class StreamingPosterior {
+    private:
+        ParameterGrid grid; /**< Axes of the models, without values. */
+        double shift; /**< Largest log likelihood added so far. */
+        double normalizer; /**< Sum of exp(log likelihood - shift) over every model. */
+        std::vector<std::vector<double>> marginalSums; /**< Same sum, restricted to the models
+            with each value of each axis. */
+
+    public:
+        /**
+         * @brief Construct a new StreamingPosterior object holding no model. 
+         *
+         * @param grid Grid the models are taken from. Its values are not used. 
+         */
+        StreamingPosterior(const ParameterGrid &grid);
+
+        /**
+         * @brief Fold a model into the posterior. 
+         *
+         * @param index Flat index of the model in the grid. 
+         * @param logLikelihood Sum of the per-trial log likelihoods of the model. 
+         */
+        void add(size_t index, double logLikelihood);
+
+        /**
+         * @brief Log of the sum of the likelihoods of every model added so far. 
+         *
+         * @return double log-sum-exp of the log likelihoods, or -infinity if no model was added. 
+         */
+        double logNormalizer() const;
+
+        /**
+         * @brief Posterior of a model, relative to the models added so far. 
+         *
+         * @param logLikelihood Sum of the per-trial log likelihoods of the model. 
+         * @return double posterior probability of the model. 
+         */
+        double posterior(double logLikelihood) const;
+
+        /**
+         * @brief Marginal posterior of every value of each axis of the grid. 
+         *
+         * @return std::vector<std::vector<double>> with one vector per axis, aligned with the axes 
+         * of the grid, each summing to one. 
+         */
+        std::vector<std::vector<double>> marginals() const;
+};
+
+/**
+ * @brief Evaluate every model of a grid in batches and fold each batch into a StreamingPosterior 
+ * as soon as it is computed. Only the topK models with the smallest NLL keep their full 
+ * ProbabilityData, so memory is bounded by the batch and by topK rather than by the grid. 
+ *
+ * @tparam T DDM or aDDM. 
+ * @param grid Grid to evaluate, whose last axis is the bias. Its values are not used. 
+ * @param topK Number of models whose full results are kept. 
+ * @param modelsPerBatch Number of models, each under every bias, evaluated at once. 
+ * @param makeModel Callable building the model of the parameters of a grid point, ignoring the 
+ * bias. 
+ * @param evaluate Callable computing the ProbabilityData of a batch of models under every bias, 
+ * such as ComputeBackend::computeGridNLLs. 
+ * @return MLEinfo with the best model, the posteriors of the topK models in likelihoods, their 
+ * full results in topModels, the marginals, and the grid without values. 
+ */
+template <typename T, typename MakeModel, typename Evaluate>
+MLEinfo<T> fitStreamingGrid(
+    ParameterGrid grid, int topK, int modelsPerBatch, MakeModel makeModel, Evaluate evaluate) {
+
+    if (topK <= 0 || modelsPerBatch <= 0) {
+        throw std::invalid_argument("topK and modelsPerBatch must be positive.");
+    }
+    const std::vector<float> biases = grid.axes.back();
+    size_t numBiases = biases.size();
+    StreamingPosterior posterior(grid);
+    // Best models so far, ordered by negative log likelihood and then by index. 
+    std::map<std::pair<double, size_t>, std::pair<T, ProbabilityData>> top;
+
+    size_t pointsPerBatch = modelsPerBatch * numBiases;
+    for (size_t first = 0; first < grid.size(); first += pointsPerBatch) {
+        size_t last = std::min(grid.size(), first + pointsPerBatch);
+        std::vector<T> models;
+        for (size_t point = first; point < last; point += numBiases) {
+            models.push_back(makeModel(grid.parameters(point)));
+        }
+        std::vector<std::vector<ProbabilityData>> gridData = evaluate(models, biases);
+        for (int m = 0; m < models.size(); m++) {
+            for (int b = 0; b < numBiases; b++) {
+                size_t index = first + m * numBiases + b;
+                ProbabilityData &aux = gridData[m][b];
+                double logLikelihood = 0;
+                for (double likelihood : aux.trialLikelihoods) {
+                    logLikelihood += log(likelihood);
+                }
+                posterior.add(index, logLikelihood);
+
+                std::pair<double, size_t> key = {-logLikelihood, index};
+                if (top.size() < topK || key < top.rbegin()->first) {
+                    T model = models[m];
+                    model.bias = biases[b];
+                    top.insert({key, {model, std::move(aux)}});
+                    if (top.size() > topK) {
+                        top.erase(std::prev(top.end()));
+                    }
+                }
+            }
+        }
+    }
+
+    MLEinfo<T> info;
+    if (!top.empty()) {
+        info.optimal = top.begin()->second.first;
+    }
+    for (auto &entry : top) {
+        const T &model = entry.second.first;
+        info.likelihoods.insert({model, posterior.posterior(-entry.first.first)});
+        info.topModels.insert({model, std::move(entry.second.second)});
+    }
+    info.marginals = posterior.marginals();
+    info.grid = std::move(grid);
+    return info;
+}
+
+#endif
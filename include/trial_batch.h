@@ -0,0 +1,108 @@
+#ifndef TRIAL_BATCH_H
+#define TRIAL_BATCH_H
+
+#include <cstdint>
+#include <vector>
+#include "ddm.h"
+#include "addm.h"
+#include "trial_store.h"
+
+/**
+ * @brief Dataset of trials packed as a struct of arrays, built once per dataset and shared by 
+ * every model evaluation. 
+ * 
+ * Each trial field is a separate contiguous column, and the fixations of all trials are packed 
+ * back to back in compressed sparse row (CSR) form: the fixations of trial i are entries 
+ * fixOffsets[i] to fixOffsets[i + 1] of fixItem and fixTime. The columns can be uploaded to a 
+ * device as they are, without padding every trial to the longest one. DDMTrials yield a batch 
+ * without fixations. 
+ * 
+ */
+class TrialBatch {
+    private:
+    public:
+        vector<int> RT; /**< Response time of each trial in milliseconds. */
+        vector<int> choice; /**< Choice of each trial, -1 for left and +1 for right. */
+        vector<int> valueLeft; /**< Value of the left item of each trial. */
+        vector<int> valueRight; /**< Value of the right item of each trial. */
+        vector<uint64_t> fixOffsets = {0}; /**< Index of the first fixation of each trial, 
+            followed by the total number of fixations. 64-bit, as in TrialStore. */
+        vector<int> fixItem; /**< Fixated item of every fixation, trial after trial. */
+        vector<int> fixTime; /**< Duration of every fixation, trial after trial. */
+
+        /**
+         * @brief Construct an empty TrialBatch object. 
+         * 
+         */
+        TrialBatch() {}
+
+        /**
+         * @brief Construct a new TrialBatch object from DDMTrials, without fixations. 
+         * 
+         * @param trials Trials to pack. 
+         */
+        explicit TrialBatch(const vector<DDMTrial> &trials);
+
+        /**
+         * @brief Construct a new TrialBatch object from aDDMTrials. 
+         * 
+         * @param trials Trials to pack. 
+         * @throws std::invalid_argument if a trial has a different number of fixation items and 
+         * fixation times. 
+         */
+        explicit TrialBatch(const vector<aDDMTrial> &trials);
+
+        /**
+         * @brief Construct a new TrialBatch object from every trial of a TrialStore. The columns 
+         * are copied in bulk, without going through aDDMTrial objects. 
+         * 
+         * @param store Store to pack. 
+         */
+        explicit TrialBatch(const TrialStore &store);
+
+        /**
+         * @brief Number of trials. 
+         * 
+         * @return size_t length of the trial columns. 
+         */
+        size_t size() const { return RT.size(); }
+
+        /**
+         * @brief Total number of fixations of every trial. 
+         * 
+         * @return size_t length of the fixation columns. 
+         */
+        size_t numFixations() const { return fixItem.size(); }
+
+        /**
+         * @brief Copy a single trial out of the batch. 
+         * 
+         * @param index Position of the trial. 
+         * @return aDDMTrial with the choice, RT, values and fixations of the trial. 
+         */
+        aDDMTrial trial(size_t index) const;
+
+        /**
+         * @brief Copy every trial out of the batch. 
+         * 
+         * @return vector<aDDMTrial> in the order of the batch. 
+         */
+        vector<aDDMTrial> aDDMTrials() const;
+
+        /**
+         * @brief Copy every trial out of the batch without its fixations. 
+         * 
+         * @return vector<DDMTrial> in the order of the batch. 
+         */
+        vector<DDMTrial> DDMTrials() const;
+
+        /**
+         * @brief Copy some of the trials of the batch into a new batch. 
+         * 
+         * @param indices Positions of the trials to copy, in the order of the new batch. 
+         * @return TrialBatch holding the selected trials. 
+         */
+        TrialBatch subset(const vector<size_t> &indices) const;
+};
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef TRIAL_STORE_H
+#define TRIAL_STORE_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ddm.h"
+#include "addm.h"
+#include "mapped_file.h"
+
+/**
+ * @brief Header at the start of a trial store file. 
+ * 
+ * A trial store holds one row per trial in separate columns, and the fixations of every trial 
+ * packed in compressed sparse row (CSR) form: the fixations of trial i are entries 
+ * fixOffsets[i] to fixOffsets[i + 1] of fixItem and fixTime. Every column starts at a multiple of 
+ * 8 bytes, so the columns can be read in place from a memory map. Values are stored in the byte 
+ * order of the machine that wrote the file. 
+ * 
+ */
+struct TrialStoreHeader {
+    char magic[8]; /**< "ADDMTRLS". */
+    uint32_t version; /**< Format version, see TrialStore::version. */
+    uint32_t byteOrder; /**< 0x01020304 as written by the producer, to detect foreign files. */
+    uint64_t numTrials; /**< Number of rows of the trial columns. */
+    uint64_t numFixations; /**< Number of rows of the fixation columns. */
+    uint64_t columns[8]; /**< Byte offset of each column from the start of the file, in the
+        order subject, RT, choice, valueLeft, valueRight, fixOffsets, fixItem, fixTime. */
+};
+
+/**
+ * @brief Read-only, memory-mapped dataset of trials in the binary columnar format described by 
+ * TrialStoreHeader. Opening a store only maps and validates the file, so large datasets open 
+ * instantly and the same file can be shared between processes through the page cache. The 
+ * columns are read in place; trials are only copied into aDDMTrial or DDMTrial objects on 
+ * request. Copies of a TrialStore share the same mapping. 
+ * 
+ */
+class TrialStore {
+    private:
+        std::shared_ptr<MappedFile> file; /**< Mapping of the store. */
+        const TrialStoreHeader *header; /**< Start of the mapping. */
+
+        /**
+         * @brief Start of a column. 
+         * 
+         * @tparam T Type of the entries of the column. 
+         * @param column Position of the column in TrialStoreHeader::columns. 
+         * @return const T * to the first entry. 
+         */
+        template <typename T>
+        const T *column(int column) const {
+            return reinterpret_cast<const T *>(file->data() + header->columns[column]);
+        }
+
+    public:
+        static const uint32_t version = 1; /**< Format version written by save. */
+
+        /**
+         * @brief Construct a new TrialStore object by mapping a store file. 
+         * 
+         * @param filename Name of a file written by save or convertCSV. 
+         * @throws std::invalid_argument if the file cannot be mapped, is not a trial store, was 
+         * written with another version or byte order, is truncated, or has fixation offsets 
+         * that decrease. 
+         */
+        TrialStore(const std::string &filename);
+
+        /**
+         * @brief Number of trials. 
+         * 
+         * @return size_t number of rows of the trial columns. 
+         */
+        size_t size() const { return header->numTrials; }
+
+        /**
+         * @brief Total number of fixations of every trial. 
+         * 
+         * @return size_t number of rows of the fixation columns. 
+         */
+        size_t numFixations() const { return header->numFixations; }
+
+        /**
+         * @brief Columns of the store, read in place from the mapping. Each trial column has 
+         * size() entries, fixOffsets has size() + 1, and fixItems and fixTimes have 
+         * numFixations(). 
+         * 
+         */
+        const int32_t *subjects() const { return column<int32_t>(0); }
+        const uint32_t *RTs() const { return column<uint32_t>(1); }
+        const int32_t *choices() const { return column<int32_t>(2); }
+        const int32_t *valuesLeft() const { return column<int32_t>(3); }
+        const int32_t *valuesRight() const { return column<int32_t>(4); }
+        const uint64_t *fixOffsets() const { return column<uint64_t>(5); }
+        const int32_t *fixItems() const { return column<int32_t>(6); }
+        const int32_t *fixTimes() const { return column<int32_t>(7); }
+
+        /**
+         * @brief Copy a single trial out of the store. 
+         * 
+         * @param index Row of the trial. 
+         * @return aDDMTrial with the choice, RT, values and fixations of the row. 
+         */
+        aDDMTrial trial(size_t index) const;
+
+        /**
+         * @brief Copy every trial out of the store. 
+         * 
+         * @return vector<aDDMTrial> in the order of the store. 
+         */
+        vector<aDDMTrial> aDDMTrials() const;
+
+        /**
+         * @brief Copy every trial out of the store without its fixations. 
+         * 
+         * @return vector<DDMTrial> in the order of the store. 
+         */
+        vector<DDMTrial> DDMTrials() const;
+
+        /**
+         * @brief Copy every trial out of the store, grouped by subject as loadDataFromCSV does. 
+         * 
+         * @return std::map<int, std::vector<aDDMTrial>> mapping subject IDs to their trials, in 
+         * the order of the store. 
+         */
+        std::map<int, std::vector<aDDMTrial>> subjectTrials() const;
+
+        /**
+         * @brief Write the trials of every subject to a store file. 
+         * 
+         * @param filename File to store the trials in. 
+         * @param data Mapping of subject IDs to their trials, such as from loadDataFromCSV. 
+         */
+        static void save(
+            const std::string &filename, const std::map<int, std::vector<aDDMTrial>> &data);
+
+        /**
+         * @brief Write aDDMTrials of a single subject to a store file. 
+         * 
+         * @param filename File to store the trials in. 
+         * @param trials Trials to be saved. 
+         * @param subject Subject ID of every trial. 
+         */
+        static void save(
+            const std::string &filename, const vector<aDDMTrial> &trials, int subject=0);
+
+        /**
+         * @brief Write DDMTrials of a single subject to a store file, without fixations. 
+         * 
+         * @param filename File to store the trials in. 
+         * @param trials Trials to be saved. 
+         * @param subject Subject ID of every trial. 
+         */
+        static void save(
+            const std::string &filename, const vector<DDMTrial> &trials, int subject=0);
+
+        /**
+         * @brief Convert a dataset from one of the CSV layouts of the toolbox to a store file. 
+         * The layout is recognized from the first column of the header of csvFilename: 
+         * 
+         * - parcode: experimental data file of loadDataFromCSV, with fixations in fixDataFilename. 
+         * - trial: single file of aDDMTrial::loadTrialsFromCSV, as subject 0. 
+         * - choice: single file of DDMTrial::loadTrialsFromCSV, as subject 0. 
+         * 
+         * @param csvFilename Name of the CSV file. 
+         * @param storeFilename File to store the trials in. 
+         * @param fixDataFilename Name of the fixations file of the parcode layout. 
+         * @throws std::invalid_argument if the layout is not recognized. 
+         */
+        static void convertCSV(
+            const std::string &csvFilename, const std::string &storeFilename,
+            const std::string &fixDataFilename="");
+};
+
+#endif
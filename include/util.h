@@ -1,6 +1,10 @@
 #ifndef UTIL_H
 #define UTIL_H
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <future>
 #include <vector>
 #include <map>
 #include <string>
@@ -14,6 +18,145 @@ using json = nlohmann::json;
 
 extern vector<string> validComputeMethods;
 
+/**
+ * @brief Thread pool with numThreads threads shared by every parallel loop. One pool is created 
+ * per thread count on first use and kept until the program exits, so that repeated loops do not 
+ * spawn and join their threads. A numThreads of 0 uses every available core. 
+ * 
+ * @param numThreads Number of threads of the pool. 
+ * @return BS::thread_pool& the persistent pool. 
+ */
+BS::thread_pool &getThreadPool(int numThreads);
+
+/**
+ * @brief Whether the calling thread is running a task of a pool returned by getThreadPool. 
+ * Parallel loops started from such a task run on the calling thread, since waiting for the pool 
+ * from one of its own threads could deadlock. 
+ * 
+ * @return bool& flag of the calling thread. 
+ */
+inline bool &onPoolThread() {
+    static thread_local bool value = false;
+    return value;
+}
+
+/**
+ * @brief Run work(w) for every worker w in [0, numWorkers) on a pool, and wait for these tasks 
+ * only, so that loops started concurrently on the same pool do not wait for each other. The 
+ * first exception thrown by a worker is rethrown once every worker has finished. 
+ * 
+ * @tparam F Callable taking a single int. 
+ * @param pool Pool to run the workers on. 
+ * @param numWorkers Number of tasks to submit. 
+ * @param work Body of each worker. 
+ */
+template <class F>
+void runWorkers(BS::thread_pool &pool, int numWorkers, F &work) {
+    std::vector<std::future<void>> futures;
+    futures.reserve(numWorkers);
+    for (int w = 0; w < numWorkers; w++) {
+        futures.push_back(pool.submit_task([&work, w]() {
+            onPoolThread() = true;
+            work(w);
+            onPoolThread() = false;
+        }));
+    }
+    for (std::future<void> &future : futures) {
+        future.wait();
+    }
+    for (std::future<void> &future : futures) {
+        future.get();
+    }
+}
+
+/**
+ * @brief Call fn(i) for every i in [0, n). Iterations are claimed one at a time by the threads of
+ * the persistent pool of numThreads threads. A numThreads of 0 uses every available core and a 
+ * numThreads of 1 runs the loop on the calling thread. 
+ * 
+ * @tparam F Callable taking a single int. 
+ * @param n Number of iterations. 
+ * @param numThreads Number of threads to use. 
+ * @param fn Body of the loop. 
+ */
+template <class F>
+void parallelFor(int n, int numThreads, F fn) {
+    if (numThreads == 1 || n <= 1 || onPoolThread()) {
+        for (int i = 0; i < n; i++) {
+            fn(i);
+        }
+        return;
+    }
+    BS::thread_pool &pool = getThreadPool(numThreads);
+    int numWorkers = std::min((int) pool.get_thread_count(), n);
+    std::atomic<int> next(0);
+    auto work = [&](int) {
+        for (int i = next.fetch_add(1, std::memory_order_relaxed); i < n; 
+            i = next.fetch_add(1, std::memory_order_relaxed)) {
+            fn(i);
+        }
+    };
+    runWorkers(pool, numWorkers, work);
+}
+
+/**
+ * @brief Call fn(i) for every i in [0, costs.size()), balancing the iterations over numThreads 
+ * threads by their estimated cost. Each thread starts on a contiguous range of iterations with 
+ * about the same total cost and, once its own range is exhausted, steals the remaining 
+ * iterations of the other ranges. Iterations are claimed with atomic counters, so no locks are 
+ * taken. The threads come from the persistent pool of getThreadPool. A numThreads of 0 uses 
+ * every available core and a numThreads of 1 runs the loop on the calling thread. 
+ * 
+ * @tparam F Callable taking a single int. 
+ * @param costs Estimated cost of each iteration. 
+ * @param numThreads Number of threads to use. 
+ * @param fn Body of the loop. 
+ */
+template <class F>
+void parallelForWeighted(const std::vector<double> &costs, int numThreads, F fn) {
+    int n = costs.size();
+    if (numThreads == 1 || n <= 1 || onPoolThread()) {
+        for (int i = 0; i < n; i++) {
+            fn(i);
+        }
+        return;
+    }
+    BS::thread_pool &pool = getThreadPool(numThreads);
+    int numWorkers = std::min((int) pool.get_thread_count(), n);
+
+    // Kept on separate cache lines so that claiming an iteration does not stall other workers. 
+    struct alignas(64) Range {
+        std::atomic<int> next;
+        int end;
+    };
+    std::vector<Range> ranges(numWorkers);
+    double totalCost = 0;
+    for (double cost : costs) {
+        totalCost += cost;
+    }
+    double cost = 0;
+    int i = 0;
+    for (int w = 0; w < numWorkers; w++) {
+        ranges[w].next.store(i, std::memory_order_relaxed);
+        double target = totalCost * (w + 1) / numWorkers;
+        while (i < n && (w == numWorkers - 1 || cost + costs[i] / 2 <= target)) {
+            cost += costs[i++];
+        }
+        ranges[w].end = i;
+    }
+
+    auto work = [&](int w) {
+        for (int v = 0; v < numWorkers; v++) {
+            Range &range = ranges[(w + v) % numWorkers];
+            for (int j = range.next.fetch_add(1, std::memory_order_relaxed); j < range.end; 
+                j = range.next.fetch_add(1, std::memory_order_relaxed)) {
+                fn(j);
+            }
+        }
+    };
+    runWorkers(pool, numWorkers, work);
+}
+
 /**
  * @brief Single entry in the experimental data CSV file. 
  * 
@@ -49,7 +192,7 @@ struct fixEntry {
  * corresponding aDDMTrials. 
  */
 std::map<int, std::vector<aDDMTrial>> loadDataFromSingleCSV(
-    std::string filename);
+    const std::string &filename);
 
 /**
  * @brief Load experimental data from two CSV files: an experimental data file and a fixations 
@@ -61,14 +204,22 @@ std::map<int, std::vector<aDDMTrial>> loadDataFromSingleCSV(
  * 
  * parcode, trial, fixItem, fixTime
  * 
+ * Both files are memory mapped and parsed in line-aligned chunks in parallel. Rows are grouped by
+ * (parcode, trial) in a single pass, and each fixation is attached to the trial with the same 
+ * parcode and trial. Non-integer parcodes are hashed. 
+ * 
  * @param expDataFilename Name of the experimental data trial. 
  * @param fixDataFilename Name of the fixations file. 
+ * @param numThreads Number of threads used for parsing. 0 uses every available core. 
  * @return std::map<int, std::vector<aDDMTrial>> mapping subject IDs to each subject's 
- * corresponding aDDMTrials. 
+ * corresponding aDDMTrials, ordered by trial ID. 
+ * @throws std::invalid_argument if a file cannot be read, or listing the file, line and reason of
+ * every malformed row, such as a missing field or a non-integer value. 
  */
 std::map<int, std::vector<aDDMTrial>> loadDataFromCSV(
-    std::string expDataFilename,
-    std::string fixDataFilename);
+    const std::string &expDataFilename,
+    const std::string &fixDataFilename, 
+    int numThreads=0);
 
 /**
  * @brief Create empirical distributions fro the data ot be used when generating model simulations.
@@ -96,17 +247,71 @@ std::map<int, std::vector<aDDMTrial>> loadDataFromCSV(
  * @return FixationData object serving as a record of empirical fixation distributions. 
  */
 FixationData getEmpiricalDistributions(
-    std::map<int, std::vector<aDDMTrial>> data, 
+    const std::map<int, std::vector<aDDMTrial>> &data, 
     int timeStep=10, int maxFixTime=3000,
     int numFixDists=3, 
-    std::vector<int> valueDiffs={-3,-2,-1,0,1,2,3},
-    std::vector<int> subjectIDs={},
+    const std::vector<int> &valueDiffs={-3,-2,-1,0,1,2,3},
+    const std::vector<int> &subjectIDs={},
     bool useOddTrials=true, 
     bool useEvenTrials=true, 
     bool useCisTrials=true, 
     bool useTransTrials=true
     );
 
+/**
+ * @brief Values of a parameter to evaluate around the best value found so far during 
+ * coarse-to-fine refinement of a grid. The spacing of the coarse range is halved at every level, 
+ * so the values are center and center +/- (range spacing) / 2^level, clipped to the coarse range.
+ * 
+ * @param range Sorted coarse values of the parameter. 
+ * @param center Value to refine around. 
+ * @param level Refinement level, starting at 1. 
+ * @return std::vector<float> of sorted, distinct values. Holds only center if the coarse range 
+ * has a single value. 
+ */
+std::vector<float> refineRange(const std::vector<float> &range, float center, int level);
+
+/**
+ * @brief Posterior probability of each model of a grid under a uniform prior. The per-trial log 
+ * likelihoods of every model are summed row by row in parallel, and the posteriors are normalized
+ * with a log-sum-exp over the models, so they do not underflow however many trials there are. 
+ * 
+ * @param logLikelihoods Dense numModels x numTrials matrix of per-trial log likelihoods, stored 
+ * as logLikelihoods[m * numTrials + t]. 
+ * @param numModels Number of models. 
+ * @param numThreads Number of threads to use. 0 uses every available core. 
+ * @return std::vector<double> with the posterior of each model. 
+ */
+std::vector<double> computePosteriors(
+    const std::vector<double> &logLikelihoods, int numModels, int numThreads=0);
+
+/**
+ * @brief Choose the models of a screened grid that are evaluated again at the full resolution: 
+ * the topFraction of models with the smallest coarse NLL, together with every model within 
+ * margin of the smallest coarse NLL. 
+ * 
+ * @param coarseNLLs NLL of each model at the coarse resolution. 
+ * @param topFraction Fraction of the models that is always kept. At least one model is kept. 
+ * @param margin Largest difference to the smallest coarse NLL of the other models that are kept.
+ * @return std::vector<int> of the indices of the kept models, by increasing coarse NLL. 
+ */
+std::vector<int> selectFinalists(
+    const std::vector<double> &coarseNLLs, double topFraction, double margin);
+
+/**
+ * @brief Order trials for branch-and-bound evaluation of a grid. Trials with the largest NLL per 
+ * time step under a reference model come first, so the partial NLL of poor models grows as fast 
+ * as possible per unit of work and they are rejected after few trials. 
+ * 
+ * @param RT Response time of each trial. 
+ * @param referenceLikelihoods Likelihood of each trial under the reference model. 
+ * @param timeStep Value in milliseconds used for binning the time axis. 
+ * @return std::vector<size_t> of the indices of the trials in evaluation order. Ties keep their 
+ * input order.
+ */
+std::vector<size_t> orderTrialsForBounding(
+    const std::vector<int> &RT, const std::vector<double> &referenceLikelihoods, int timeStep);
+
 /**
  * @brief Print a matrix stored in nested-vector format. Utility function for debugging purposes.
  * 
@@ -115,9 +320,9 @@ FixationData getEmpiricalDistributions(
  * @param name Name to print as a header for the matrix. 
  */
 template <class T> 
-void pmat(std::vector<std::vector<T>> mat, std::string name) {
+void pmat(const std::vector<std::vector<T>> &mat, const std::string &name) {
     std::cout << name << std::endl;
-    for (auto row : mat) {
+    for (const auto &row : mat) {
         for (auto f : row) {
             std::cout << f;
             if (f >= 0 && f < 10) {
@@ -3,24 +3,30 @@
 #include <stdexcept>
 #include <fstream>
 #include <sstream>
+#include <functional>
 #include <map>
+#include <set>
 #include <ctime>
 #include <time.h>
 #include <cstdlib>
 #include <random> 
+#include <cmath>
 #include "ddm.h"
 #include "util.h"
 #include "addm.h"
+#include "compute_backend.h"
+#include "trial_batch.h"
 #include "stats.h"
+#include "streaming_posterior.h"
 
 
 FixationData::FixationData(float probFixLeftFirst, std::vector<int> latencies, 
     std::vector<int> transitions, fixDists fixations) {
 
     this->probFixLeftFirst = probFixLeftFirst;
-    this->latencies = latencies;
-    this->transitions = transitions;
-    this->fixations = fixations;
+    this->latencies = std::move(latencies);
+    this->transitions = std::move(transitions);
+    this->fixations = std::move(fixations);
 }
 
 
@@ -29,9 +35,9 @@ aDDMTrial::aDDMTrial(
     std::vector<int> fixItem, std::vector<int> fixTime, 
     std::vector<float> fixRDV, float uninterruptedLastFixTime) :
     DDMTrial(RT, choice, valueLeft, valueRight) {
-        this->fixItem = fixItem;
-        this->fixTime = fixTime;
-        this->fixRDV = fixRDV;
+        this->fixItem = std::move(fixItem);
+        this->fixTime = std::move(fixTime);
+        this->fixRDV = std::move(fixRDV);
         this->uninterruptedLastFixTime = uninterruptedLastFixTime;
 }
 
@@ -43,7 +49,7 @@ aDDM::aDDM(float d, float sigma, float theta, float k, float barrier,
         this->k = k; 
 }
 
-void aDDM::exportTrial(aDDMTrial adt, std::string filename) {
+void aDDM::exportTrial(const aDDMTrial &adt, const std::string &filename) {
     std::ofstream o(filename);
     json j;
     j["d"] = d;
@@ -66,8 +72,8 @@ void aDDM::exportTrial(aDDMTrial adt, std::string filename) {
 
 
 aDDMTrial aDDM::simulateTrial(
-    int valueLeft, int valueRight, FixationData fixationData, int timeStep, 
-    int numFixDists, fixDists fixationDist, vector<int> timeBins, int seed) {
+    int valueLeft, int valueRight, const FixationData &fixationData, int timeStep, 
+    int numFixDists, const fixDists &fixationDist, const vector<int> &timeBins, int seed) {
 
     std::vector<int> fixItem;
     std::vector<int> fixTime;
@@ -112,7 +118,8 @@ aDDMTrial aDDM::simulateTrial(
             uninterruptedLastFixTime = latency;
             return aDDMTrial(
                 RT, choice, valueLeft, valueRight, 
-                fixItem, fixTime, fixRDV, uninterruptedLastFixTime);
+                std::move(fixItem), std::move(fixTime), std::move(fixRDV), 
+                uninterruptedLastFixTime);
         }
     }
 
@@ -143,7 +150,7 @@ aDDMTrial aDDM::simulateTrial(
             }
             prevFixatedItem = currFixLocation;
             if (fixationDist.empty()) {
-                vector<float> fixTimes = fixationData.fixations.at(fixNumber);
+                const vector<float> &fixTimes = fixationData.fixations.at(fixNumber);
                 std::uniform_int_distribution<std::size_t> fudist(0, fixTimes.size() - 1);
                 rIDX = fudist(gen);
                 currFixTime = fixTimes.at(rIDX);
@@ -234,20 +241,22 @@ aDDMTrial aDDM::simulateTrial(
         time += dt;
     } 
 
-    aDDMTrial trial = aDDMTrial(RT, choice, valueLeft, valueRight, fixItem, fixTime, fixRDV, uninterruptedLastFixTime);
-    trial.RDVs = RDVs;
+    aDDMTrial trial = aDDMTrial(
+        RT, choice, valueLeft, valueRight, 
+        std::move(fixItem), std::move(fixTime), std::move(fixRDV), uninterruptedLastFixTime);
+    trial.RDVs = std::move(RDVs);
     trial.timeStep = timeStep;
     return trial;
 }
 
 
-void aDDMTrial::writeTrialsToCSV(std::vector<aDDMTrial> trials, string filename) {
+void aDDMTrial::writeTrialsToCSV(const std::vector<aDDMTrial> &trials, const string &filename) {
     std::ofstream fp;
     fp.open(filename);
     fp << "trial,choice,rt,valueLeft,valueRight,fixItem,fixTime\n";
     int id = 0; 
 
-    for (aDDMTrial adt : trials) {
+    for (const aDDMTrial &adt : trials) {
         assert(adt.fixItem.size() == adt.fixTime.size());
         for (int i = 0; i < adt.fixItem.size(); i++) {
             fp << id << "," << adt.choice << "," << adt.RT << "," << 
@@ -260,7 +269,7 @@ void aDDMTrial::writeTrialsToCSV(std::vector<aDDMTrial> trials, string filename)
 }
 
 
-vector<aDDMTrial> aDDMTrial::loadTrialsFromCSV(string filename) {
+vector<aDDMTrial> aDDMTrial::loadTrialsFromCSV(const string &filename) {
     std::vector<aDDMTrial> trials; 
     std::vector<aDDM> addms;
     std::ifstream file(filename);
@@ -304,7 +313,7 @@ vector<aDDMTrial> aDDMTrial::loadTrialsFromCSV(string filename) {
             if (firstIter) {
                 firstIter = false; 
             } else {
-                trials.push_back(adt);
+                trials.push_back(std::move(adt));
             }
             adt = aDDMTrial(RT, choice, valueLeft, valueRight);
             adt.fixItem.push_back(fItem);
@@ -313,18 +322,19 @@ vector<aDDMTrial> aDDMTrial::loadTrialsFromCSV(string filename) {
         }
         prevID = ID;
     }
-    trials.push_back(adt);
+    trials.push_back(std::move(adt));
     file.close();
     return trials;
 }
 
 
 MLEinfo<aDDM> aDDM::fitModelMLE(
-    std::vector<aDDMTrial> trials, 
+    const std::vector<aDDMTrial> &trials, 
     std::vector<float> rangeD, 
     std::vector<float> rangeSigma, 
     std::vector<float> rangeTheta, 
     std::vector<float> rangeK,
+    std::string computeMethod, 
     bool normalizePosteriors,
     float barrier,
     unsigned int nonDecisionTime,
@@ -332,8 +342,55 @@ MLEinfo<aDDM> aDDM::fitModelMLE(
     std::vector<float> decay, 
     int timeStep, 
     float approxStateStep, 
-    int trialsPerThread) {
+    int trialsPerThread, 
+    int refinementLevels, 
+    int refinementNeighborhoods, 
+    bool pruning, 
+    ScreeningOptions screening) {
+
+    return fitModelMLE(
+        TrialBatch(trials), rangeD, rangeSigma, rangeTheta, rangeK, computeMethod, 
+        normalizePosteriors, barrier, nonDecisionTime, bias, decay, timeStep, approxStateStep, 
+        trialsPerThread, refinementLevels, refinementNeighborhoods, pruning, screening);
+}
+
 
+MLEinfo<aDDM> aDDM::fitModelMLE(
+    const TrialBatch &trials, 
+    std::vector<float> rangeD, 
+    std::vector<float> rangeSigma, 
+    std::vector<float> rangeTheta, 
+    std::vector<float> rangeK, 
+    std::string computeMethod, 
+    bool normalizePosteriors, 
+    float barrier, 
+    unsigned int nonDecisionTime, 
+    std::vector<float> bias, 
+    std::vector<float> decay, 
+    int timeStep, 
+    float approxStateStep, 
+    int trialsPerThread, 
+    int refinementLevels, 
+    int refinementNeighborhoods, 
+    bool pruning, 
+    ScreeningOptions screening) {
+
+    if (refinementLevels < 0 || refinementNeighborhoods <= 0) {
+        throw std::invalid_argument(
+            "refinementLevels must be non-negative and refinementNeighborhoods positive.");
+    }
+    if (pruning && normalizePosteriors) {
+        throw std::invalid_argument("pruning requires normalizePosteriors to be false.");
+    }
+    if (screening.enabled && normalizePosteriors) {
+        throw std::invalid_argument("screening requires normalizePosteriors to be false.");
+    }
+    if (screening.enabled && (screening.timeStep <= 0 || screening.approxStateStep <= 0 || 
+        screening.topFraction <= 0 || screening.topFraction > 1 || screening.margin < 0)) {
+        throw std::invalid_argument(
+            "screening requires positive steps, a topFraction in (0, 1] and a non-negative "
+            "margin.");
+    }
     sort(rangeD.begin(), rangeD.end());
     sort(rangeSigma.begin(), rangeSigma.end());
     sort(rangeTheta.begin(), rangeTheta.end()); 
@@ -341,71 +398,578 @@ MLEinfo<aDDM> aDDM::fitModelMLE(
     sort(bias.begin(), bias.end());
     sort(decay.begin(), decay.end());
 
-    std::vector<aDDM> potentialModels; 
-    for (float d : rangeD) {
-        for (float sigma : rangeSigma) {
-            for (float theta : rangeTheta) {
-                for (float k : rangeK) {
-                    for (float b : bias) {
-                        for (float dec : decay) {
-                            aDDM addm = aDDM(d, sigma, theta, k, barrier, nonDecisionTime, b, dec);
-                            potentialModels.push_back(addm);
-                        }
+    std::unique_ptr<ComputeBackend> backend = getComputeBackend(computeMethod);
+    // Pruning evaluates the trials from a copy in bounding order. 
+    TrialBatch boundingOrder; 
+
+    // Results of the grid of the ranges, NaN until a point is evaluated and infinity once 
+    // pruning drops it. Bias is the last axis, so the biases of a model are neighbors. 
+    ParameterGrid grid(
+        {"d", "sigma", "theta", "k", "decay", "bias"}, 
+        {rangeD, rangeSigma, rangeTheta, rangeK, decay, bias});
+    int numBiases = grid.axes.back().size();
+    // Whether each grid model, whose biases are the points from m * numBiases on, is only 
+    // evaluated at the coarse resolution. 
+    std::vector<bool> coarse(grid.size() / numBiases, false);
+    // NLL of every model added off the grid by refinement, keyed by 
+    // (d, sigma, theta, k, decay, bias). 
+    std::map<std::vector<float>, double> refinedScores; 
+
+    double minNLL = __DBL_MAX__;
+    aDDM optimal = aDDM(); 
+    // Models entering the posterior, with their grid index or -1 off the grid, and their 
+    // per-trial log likelihoods, one row per model. 
+    std::vector<aDDM> posteriorModels; 
+    std::vector<long> posteriorIndices; 
+    std::vector<double> logLikelihoods; 
+    // Every bias of a model is evaluated together, so only the other parameters are enumerated. 
+    // indices holds the grid index of every (model, bias) point, or -1 off the grid. 
+    auto record = [&](
+        const std::vector<aDDM> &potentialModels, const std::vector<float> &biases, 
+        const std::vector<long> &indices, 
+        const std::vector<std::vector<ProbabilityData>> &gridData) {
+        for (int m = 0; m < potentialModels.size(); m++) {
+            const std::vector<ProbabilityData> &biasData = gridData[m];
+            for (int b = 0; b < biases.size(); b++) {
+                aDDM addm = potentialModels[m]; 
+                addm.bias = biases[b]; 
+                const ProbabilityData &aux = biasData[b]; 
+                long index = indices[m * biases.size() + b];
+                if (index >= 0) {
+                    if (!std::isnan(grid.values[index])) {
+                        continue;
+                    }
+                    grid.values[index] = aux.NLL;
+                } else if (!refinedScores.insert({
+                    {addm.d, addm.sigma, addm.theta, addm.k, addm.decay, addm.bias}, 
+                    aux.NLL}).second) {
+                    continue;
+                }
+                if (std::isinf(aux.NLL)) {
+                    continue;
+                }
+                if (normalizePosteriors) {
+                    posteriorModels.push_back(addm);
+                    posteriorIndices.push_back(index);
+                    for (double likelihood : aux.trialLikelihoods) {
+                        logLikelihoods.push_back(log(likelihood));
                     }
                 }
+                if (aux.NLL < minNLL) {
+                    minNLL = aux.NLL; 
+                    optimal = addm; 
+                }
             }
         }
-    }
-    
-    double minNLL = __DBL_MAX__; 
-    std::map<aDDM, ProbabilityData> allTrialLikelihoods; 
-    std::map<aDDM, float> posteriors; 
-    double numModels = rangeD.size() * rangeSigma.size() * rangeTheta.size() * bias.size() * decay.size();
-
-    aDDM optimal = aDDM(); 
-    for (aDDM addm : potentialModels) {
-        ProbabilityData aux = addm.computeGPUNLL(trials, trialsPerThread, timeStep, approxStateStep);
-        if (normalizePosteriors) {
-            allTrialLikelihoods.insert({addm, aux});
-            posteriors.insert({addm, 1 / numModels});
+    };
+    auto evaluate = [&](
+        const std::vector<aDDM> &potentialModels, const std::vector<float> &biases, 
+        const std::vector<long> &indices) {
+        if (pruning) {
+            double bound = minNLL;
+            record(potentialModels, biases, indices, backend->computeBoundedGridNLLs(
+                potentialModels, boundingOrder, biases, trialsPerThread, timeStep, 
+                approxStateStep, bound));
         } else {
-            posteriors.insert({addm, aux.NLL});
+            record(potentialModels, biases, indices, backend->computeGridNLLs(
+                potentialModels, trials, biases, trialsPerThread, timeStep, approxStateStep, 
+                normalizePosteriors));
         }
-
-        if (aux.NLL < minNLL) {
-            minNLL = aux.NLL; 
-            optimal = addm; 
+    };
+    auto gridModel = [&](size_t point) {
+        std::vector<float> p = grid.parameters(point);
+        return aDDM(p[0], p[1], p[2], p[3], barrier, nonDecisionTime, p[5], p[4]);
+    };
+
+    // Models are built and evaluated a batch at a time, so that only grid.values and the 
+    // indices of the models left to evaluate are held for the whole grid. 
+    const size_t modelsPerBatch = 256;
+    // Index of the first grid point of each model left to evaluate. 
+    std::vector<size_t> points; 
+    for (size_t point = 0; point < grid.size(); point += numBiases) {
+        points.push_back(point);
+    }
+    if (screening.enabled) {
+        // Drift, noise and decay are given per time step, so the coarse models are rescaled to 
+        // describe the same process over the longer coarse time step. 
+        float scale = (float) screening.timeStep / timeStep;
+        // The coarse NLLs are stored in the grid as each batch completes, and cleared again for 
+        // the finalists. 
+        std::vector<double> coarseNLLs;
+        for (size_t begin = 0; begin < points.size(); begin += modelsPerBatch) {
+            size_t end = std::min(points.size(), begin + modelsPerBatch);
+            std::vector<aDDM> screenedModels;
+            for (size_t m = begin; m < end; m++) {
+                aDDM addm = gridModel(points[m]);
+                screenedModels.push_back(aDDM(
+                    addm.d * scale, addm.sigma * sqrt(scale), addm.theta, addm.k, barrier, 
+                    nonDecisionTime, 0, addm.decay * scale));
+            }
+            std::vector<std::vector<ProbabilityData>> gridData = backend->computeGridNLLs(
+                screenedModels, trials, grid.axes.back(), trialsPerThread, screening.timeStep, 
+                screening.approxStateStep, false);
+            for (size_t m = begin; m < end; m++) {
+                const std::vector<ProbabilityData> &biasData = gridData[m - begin];
+                for (int b = 0; b < numBiases; b++) {
+                    grid.values[points[m] + b] = biasData[b].NLL;
+                }
+                coarseNLLs.push_back(std::min_element(
+                    biasData.begin(), biasData.end(), 
+                    [](const ProbabilityData &a, const ProbabilityData &b) { 
+                        return a.NLL < b.NLL; 
+                    })->NLL);
+            }
+        }
+        std::vector<int> finalists = selectFinalists(
+            coarseNLLs, screening.topFraction, screening.margin);
+        std::vector<size_t> finePoints;
+        for (int m : finalists) {
+            finePoints.push_back(points[m]);
         }
+        // Coarse scores are not comparable with fine ones, so refinement never centers on them. 
+        coarse.assign(points.size(), true);
+        for (int m : finalists) {
+            coarse[m] = false;
+            std::fill_n(grid.values.begin() + points[m], numBiases, NAN);
+        }
+        points = finePoints;
     }
-    if (normalizePosteriors) {
-        for (int tn = 0; tn < trials.size(); tn++) {
-            double denominator = 0; 
-            for (const auto &addmPD : allTrialLikelihoods) {
-                aDDM curr = addmPD.first; 
-                ProbabilityData data = addmPD.second; 
-                double likelihood = data.trialLikelihoods[tn];
-                denominator += posteriors[curr] * likelihood; 
+    // Evaluate numModels models under every bias of biases, building them with 
+    // append(m, potentialModels, indices) a batch at a time. 
+    auto evaluateBatches = [&](
+        size_t numModels, const std::vector<float> &biases, 
+        const std::function<void(size_t, std::vector<aDDM> &, std::vector<long> &)> &append) {
+        std::vector<aDDM> potentialModels; 
+        std::vector<long> indices; 
+        for (size_t begin = 0; begin < numModels; begin += modelsPerBatch) {
+            potentialModels.clear();
+            indices.clear();
+            for (size_t m = begin; m < std::min(numModels, begin + modelsPerBatch); m++) {
+                append(m, potentialModels, indices);
             }
-            double sum = 0; 
-            for (const auto &addmPD : allTrialLikelihoods) {
-                aDDM curr = addmPD.first; 
-                ProbabilityData data = addmPD.second; 
-                double prior = posteriors[curr];
-                double newLikelihoood = data.trialLikelihoods[tn] * prior / denominator; 
-                posteriors[curr] = newLikelihoood; 
-                sum += newLikelihoood;
+            evaluate(potentialModels, biases, indices);
+        }
+    };
+    if (pruning) {
+        // The best model of the screening pass, or else the center of the grid, is evaluated in 
+        // full first. Its NLL is the initial bound and its trial likelihoods decide the order in 
+        // which the other models visit the trials. 
+        size_t pilot = screening.enabled ? points[0] : grid.index({
+            (int) grid.axes[0].size() / 2, (int) grid.axes[1].size() / 2, 
+            (int) grid.axes[2].size() / 2, (int) grid.axes[3].size() / 2, 
+            (int) grid.axes[4].size() / 2, 0});
+        std::vector<aDDM> pilotModel = {gridModel(pilot)};
+        std::vector<std::vector<ProbabilityData>> pilotData = backend->computeGridNLLs(
+            pilotModel, trials, grid.axes.back(), trialsPerThread, timeStep, approxStateStep);
+        std::vector<long> pilotIndices; 
+        for (int b = 0; b < numBiases; b++) {
+            pilotIndices.push_back(pilot + b);
+        }
+        record(pilotModel, grid.axes.back(), pilotIndices, pilotData);
+        auto best = std::min_element(
+            pilotData[0].begin(), pilotData[0].end(), 
+            [](const ProbabilityData &a, const ProbabilityData &b) { return a.NLL < b.NLL; });
+        boundingOrder = trials.subset(
+            orderTrialsForBounding(trials.RT, best->trialLikelihoods, timeStep));
+        points.erase(std::find(points.begin(), points.end(), pilot));
+    }
+    evaluateBatches(points.size(), grid.axes.back(), [&](
+        size_t m, std::vector<aDDM> &potentialModels, std::vector<long> &indices) {
+        potentialModels.push_back(gridModel(points[m]));
+        for (int b = 0; b < numBiases; b++) {
+            indices.push_back(points[m] + b);
+        }
+    });
+
+    // Coarse-to-fine refinement: evaluate a grid with half the spacing around the best models so
+    // far, skipping the models that were already evaluated. 
+    auto evaluated = [&](const std::vector<float> &key) {
+        long index = grid.find(key);
+        return index >= 0 ? !std::isnan(grid.values[index]) : refinedScores.count(key) > 0;
+    };
+    for (int level = 1; level <= refinementLevels; level++) {
+        // Fine NLLs on the grid are ranked by index and those off it by their position in 
+        // refinedKeys, past the end of the grid. 
+        std::vector<std::pair<double, size_t>> ranked;
+        for (size_t i = 0; i < grid.size(); i++) {
+            if (std::isfinite(grid.values[i]) && !coarse[i / numBiases]) {
+                ranked.push_back({grid.values[i], i});
+            }
+        }
+        std::vector<const std::vector<float> *> refinedKeys;
+        for (const auto &score : refinedScores) {
+            if (std::isfinite(score.second)) {
+                ranked.push_back({score.second, grid.size() + refinedKeys.size()});
+                refinedKeys.push_back(&score.first);
             }
-            if (sum != 1) {
-                double normalizer = 1 / sum; 
-                for (auto &p : posteriors) {
-                    p.second *= normalizer; 
+        }
+        int numCenters = std::min((int) ranked.size(), refinementNeighborhoods);
+        std::partial_sort(ranked.begin(), ranked.begin() + numCenters, ranked.end());
+
+        std::set<std::vector<float>> refinedModels;
+        std::set<float> refinedBiases;
+        for (int c = 0; c < numCenters; c++) {
+            size_t i = ranked[c].second;
+            std::vector<float> center = i < grid.size() ? 
+                grid.parameters(i) : *refinedKeys[i - grid.size()];
+            for (float d : refineRange(rangeD, center[0], level)) {
+                for (float sigma : refineRange(rangeSigma, center[1], level)) {
+                    for (float theta : refineRange(rangeTheta, center[2], level)) {
+                        for (float k : refineRange(rangeK, center[3], level)) {
+                            for (float dec : refineRange(decay, center[4], level)) {
+                                refinedModels.insert({d, sigma, theta, k, dec});
+                            }
+                        }
+                    }
                 }
             }
+            for (float b : refineRange(bias, center[5], level)) {
+                refinedBiases.insert(b);
+            }
+        }
+        std::vector<float> biases(refinedBiases.begin(), refinedBiases.end());
+        std::vector<const std::vector<float> *> pending;
+        for (const std::vector<float> &p : refinedModels) {
+            bool allEvaluated = true;
+            for (float b : biases) {
+                allEvaluated = allEvaluated && evaluated({p[0], p[1], p[2], p[3], p[4], b});
+            }
+            if (!allEvaluated) {
+                pending.push_back(&p);
+            }
+        }
+        if (pending.empty()) {
+            break;
+        }
+        evaluateBatches(pending.size(), biases, [&](
+            size_t m, std::vector<aDDM> &potentialModels, std::vector<long> &indices) {
+            const std::vector<float> &p = *pending[m];
+            potentialModels.push_back(
+                aDDM(p[0], p[1], p[2], p[3], barrier, nonDecisionTime, 0, p[4]));
+            for (float b : biases) {
+                indices.push_back(grid.find({p[0], p[1], p[2], p[3], p[4], b}));
+            }
+        });
+    }
+
+    if (normalizePosteriors) {
+        // Uniform prior over every evaluated model. 
+        std::vector<double> modelPosteriors = computePosteriors(
+            logLikelihoods, posteriorModels.size());
+        for (int m = 0; m < posteriorModels.size(); m++) {
+            const aDDM &curr = posteriorModels[m];
+            if (posteriorIndices[m] >= 0) {
+                grid.values[posteriorIndices[m]] = modelPosteriors[m];
+            } else {
+                refinedScores[{
+                    curr.d, curr.sigma, curr.theta, curr.k, curr.decay, curr.bias}] = 
+                    modelPosteriors[m];
+            }
         }
     }
     MLEinfo<aDDM> info;
     info.optimal = optimal; 
-    info.likelihoods = posteriors; 
+    // Models dropped by pruning have no result. likelihoods and fidelities still get one entry 
+    // per evaluated model, so that existing callers keep working, at the cost of one map node 
+    // per grid point. 
+    for (size_t i = 0; i < grid.size(); i++) {
+        if (std::isinf(grid.values[i])) {
+            grid.values[i] = NAN;
+        } else if (!std::isnan(grid.values[i])) {
+            aDDM addm = gridModel(i);
+            info.likelihoods.insert({addm, grid.values[i]});
+            if (screening.enabled) {
+                info.fidelities.insert(
+                    {addm, coarse[i / numBiases] ? Fidelity::Coarse : Fidelity::Fine});
+            }
+        }
+    }
+    for (const auto &score : refinedScores) {
+        if (std::isinf(score.second)) {
+            continue;
+        }
+        const std::vector<float> &p = score.first;
+        aDDM addm = aDDM(p[0], p[1], p[2], p[3], barrier, nonDecisionTime, p[5], p[4]);
+        info.likelihoods.insert({addm, score.second});
+        if (screening.enabled) {
+            info.fidelities.insert({addm, Fidelity::Fine});
+        }
+    }
+    info.grid = std::move(grid);
     return info;   
 }
 
+
+MLEinfo<aDDM> aDDM::fitModelStreaming(
+    const std::vector<aDDMTrial> &trials, 
+    std::vector<float> rangeD, 
+    std::vector<float> rangeSigma, 
+    std::vector<float> rangeTheta, 
+    std::vector<float> rangeK, 
+    std::string computeMethod, 
+    float barrier, 
+    unsigned int nonDecisionTime, 
+    std::vector<float> bias, 
+    std::vector<float> decay, 
+    int timeStep, 
+    float approxStateStep, 
+    int trialsPerThread, 
+    int topK, 
+    int modelsPerBatch) {
+
+    return fitModelStreaming(
+        TrialBatch(trials), rangeD, rangeSigma, rangeTheta, rangeK, computeMethod, barrier, 
+        nonDecisionTime, bias, decay, timeStep, approxStateStep, trialsPerThread, topK, 
+        modelsPerBatch);
+}
+
+
+MLEinfo<aDDM> aDDM::fitModelStreaming(
+    const TrialBatch &trials, 
+    std::vector<float> rangeD, 
+    std::vector<float> rangeSigma, 
+    std::vector<float> rangeTheta, 
+    std::vector<float> rangeK, 
+    std::string computeMethod, 
+    float barrier, 
+    unsigned int nonDecisionTime, 
+    std::vector<float> bias, 
+    std::vector<float> decay, 
+    int timeStep, 
+    float approxStateStep, 
+    int trialsPerThread, 
+    int topK, 
+    int modelsPerBatch) {
+
+    std::unique_ptr<ComputeBackend> backend = getComputeBackend(computeMethod);
+    ParameterGrid grid(
+        {"d", "sigma", "theta", "k", "decay", "bias"}, 
+        {rangeD, rangeSigma, rangeTheta, rangeK, decay, bias}, false);
+    return fitStreamingGrid<aDDM>(
+        std::move(grid), topK, modelsPerBatch, 
+        [&](const std::vector<float> &p) {
+            return aDDM(p[0], p[1], p[2], p[3], barrier, nonDecisionTime, 0, p[4]);
+        }, 
+        [&](const std::vector<aDDM> &models, const std::vector<float> &biases) {
+            return backend->computeGridNLLs(
+                models, trials, biases, trialsPerThread, timeStep, approxStateStep);
+        });
+}
+
+
+MLEinfo<aDDM> aDDM::fitModelAnytime(
+    const std::vector<aDDMTrial> &trials, 
+    std::vector<float> rangeD, 
+    std::vector<float> rangeSigma, 
+    std::vector<float> rangeTheta, 
+    std::vector<float> rangeK, 
+    std::string computeMethod, 
+    float barrier, 
+    unsigned int nonDecisionTime, 
+    std::vector<float> bias, 
+    std::vector<float> decay, 
+    int timeStep, 
+    float approxStateStep, 
+    int trialsPerThread, 
+    AnytimeOptions options) {
+
+    return fitModelAnytime(
+        TrialBatch(trials), rangeD, rangeSigma, rangeTheta, rangeK, computeMethod, barrier, 
+        nonDecisionTime, bias, decay, timeStep, approxStateStep, trialsPerThread, options);
+}
+
+
+MLEinfo<aDDM> aDDM::fitModelAnytime(
+    const TrialBatch &trials, 
+    std::vector<float> rangeD, 
+    std::vector<float> rangeSigma, 
+    std::vector<float> rangeTheta, 
+    std::vector<float> rangeK, 
+    std::string computeMethod, 
+    float barrier, 
+    unsigned int nonDecisionTime, 
+    std::vector<float> bias, 
+    std::vector<float> decay, 
+    int timeStep, 
+    float approxStateStep, 
+    int trialsPerThread, 
+    AnytimeOptions options) {
+
+    std::unique_ptr<ComputeBackend> backend = getComputeBackend(computeMethod);
+    ParameterGrid grid(
+        {"d", "sigma", "theta", "k", "decay", "bias"}, 
+        {rangeD, rangeSigma, rangeTheta, rangeK, decay, bias});
+    return fitAnytimeGrid<aDDM>(
+        std::move(grid), options, 
+        [&](const std::vector<float> &p) {
+            return aDDM(p[0], p[1], p[2], p[3], barrier, nonDecisionTime, 0, p[4]);
+        }, 
+        [&](const std::vector<aDDM> &models, const std::vector<float> &biases) {
+            return backend->computeGridNLLs(
+                models, trials, biases, trialsPerThread, timeStep, approxStateStep, false);
+        });
+}
+
+
+
+MLEinfo<aDDM> aDDM::fitModelOptimize(
+    const std::vector<aDDMTrial> &trials, 
+    std::vector<float> rangeD, 
+    std::vector<float> rangeSigma, 
+    std::vector<float> rangeTheta, 
+    std::vector<float> rangeK, 
+    std::string computeMethod, 
+    float barrier, 
+    unsigned int nonDecisionTime, 
+    std::vector<float> bias, 
+    std::vector<float> decay, 
+    int timeStep, 
+    float approxStateStep, 
+    int trialsPerThread, 
+    std::optional<aDDM> warmStart, 
+    OptimizerOptions options) {
+
+    return fitModelOptimize(
+        TrialBatch(trials), rangeD, rangeSigma, rangeTheta, rangeK, computeMethod, barrier, 
+        nonDecisionTime, bias, decay, timeStep, approxStateStep, trialsPerThread, warmStart, 
+        options);
+}
+
+
+MLEinfo<aDDM> aDDM::fitModelOptimize(
+    const TrialBatch &trials, 
+    std::vector<float> rangeD, 
+    std::vector<float> rangeSigma, 
+    std::vector<float> rangeTheta, 
+    std::vector<float> rangeK, 
+    std::string computeMethod, 
+    float barrier, 
+    unsigned int nonDecisionTime, 
+    std::vector<float> bias, 
+    std::vector<float> decay, 
+    int timeStep, 
+    float approxStateStep, 
+    int trialsPerThread, 
+    std::optional<aDDM> warmStart, 
+    OptimizerOptions options) {
+
+    // Parameters are ordered as (d, sigma, theta, k, bias, decay). 
+    std::vector<std::vector<float>> ranges = {rangeD, rangeSigma, rangeTheta, rangeK, bias, decay};
+    std::vector<double> lower, upper, x0;
+    for (const std::vector<float> &range : ranges) {
+        if (range.empty()) {
+            throw std::invalid_argument("Every parameter range must hold at least one value.");
+        }
+        lower.push_back(*std::min_element(range.begin(), range.end()));
+        upper.push_back(*std::max_element(range.begin(), range.end()));
+        x0.push_back((lower.back() + upper.back()) / 2);
+    }
+    if (warmStart) {
+        x0 = {
+            warmStart->d, warmStart->sigma, warmStart->theta, warmStart->k, 
+            warmStart->bias, warmStart->decay
+        };
+    }
+
+    std::unique_ptr<ComputeBackend> backend = getComputeBackend(computeMethod);
+    std::map<std::vector<float>, double> scores;
+    MLEinfo<aDDM> info;
+    double minNLL = __DBL_MAX__;
+    auto negativeLogLikelihood = [&](const std::vector<double> &x) {
+        aDDM addm = aDDM(x[0], x[1], x[2], x[3], barrier, nonDecisionTime, x[4], x[5]);
+        std::vector<float> key = {addm.d, addm.sigma, addm.theta, addm.k, addm.bias, addm.decay};
+        auto it = scores.find(key);
+        if (it != scores.end()) {
+            return it->second;
+        }
+        double NLL = backend->computeNLL(
+            addm, trials, trialsPerThread, timeStep, approxStateStep).NLL;
+        scores.insert({key, NLL});
+        info.likelihoods.insert({addm, NLL});
+        if (NLL < minNLL) {
+            minNLL = NLL;
+            info.optimal = addm;
+        }
+        return NLL;
+    };
+    OptimizerResult result = nelderMead(negativeLogLikelihood, x0, lower, upper, options);
+    info.converged = result.converged;
+    info.numEvaluations = result.numEvaluations;
+    return info;
+}
+
+
+MLEinfo<aDDM> aDDM::fitModelLBFGSB(
+    const std::vector<aDDMTrial> &trials, 
+    std::vector<float> rangeD, 
+    std::vector<float> rangeSigma, 
+    std::vector<float> rangeTheta, 
+    std::vector<float> rangeK, 
+    float barrier, 
+    unsigned int nonDecisionTime, 
+    float bias, 
+    float decay, 
+    int timeStep, 
+    float approxStateStep, 
+    int numThreads, 
+    std::optional<aDDM> warmStart, 
+    OptimizerOptions options) {
+
+    return fitModelLBFGSB(
+        TrialBatch(trials), rangeD, rangeSigma, rangeTheta, rangeK, barrier, nonDecisionTime, bias, 
+        decay, timeStep, approxStateStep, numThreads, warmStart, options);
+}
+
+
+MLEinfo<aDDM> aDDM::fitModelLBFGSB(
+    const TrialBatch &trials, 
+    std::vector<float> rangeD, 
+    std::vector<float> rangeSigma, 
+    std::vector<float> rangeTheta, 
+    std::vector<float> rangeK, 
+    float barrier, 
+    unsigned int nonDecisionTime, 
+    float bias, 
+    float decay, 
+    int timeStep, 
+    float approxStateStep, 
+    int numThreads, 
+    std::optional<aDDM> warmStart, 
+    OptimizerOptions options) {
+
+    // Parameters are ordered as (d, sigma, theta, k), as in NLLGradient. 
+    std::vector<std::vector<float>> ranges = {rangeD, rangeSigma, rangeTheta, rangeK};
+    std::vector<double> lower, upper, x0;
+    for (const std::vector<float> &range : ranges) {
+        if (range.empty()) {
+            throw std::invalid_argument("Every parameter range must hold at least one value.");
+        }
+        lower.push_back(*std::min_element(range.begin(), range.end()));
+        upper.push_back(*std::max_element(range.begin(), range.end()));
+        x0.push_back((lower.back() + upper.back()) / 2);
+    }
+    if (warmStart) {
+        x0 = {warmStart->d, warmStart->sigma, warmStart->theta, warmStart->k};
+    }
+
+    PropagationOptions propagation;
+    propagation.cache = std::make_shared<PropagationCache>();
+    MLEinfo<aDDM> info;
+    double minNLL = __DBL_MAX__;
+    auto negativeLogLikelihood = [&](const std::vector<double> &x, std::vector<double> &gradient) {
+        aDDM addm = aDDM(x[0], x[1], x[2], x[3], barrier, nonDecisionTime, bias, decay);
+        NLLGradient result = addm.computeCPUNLLGradient(
+            trials, timeStep, approxStateStep, numThreads, propagation);
+        gradient.assign(result.gradient.begin(), result.gradient.begin() + 4);
+        info.likelihoods.insert({addm, result.NLL});
+        if (result.NLL < minNLL) {
+            minNLL = result.NLL;
+            info.optimal = addm;
+        }
+        return result.NLL;
+    };
+    OptimizerResult result = lbfgsb(negativeLogLikelihood, x0, lower, upper, options);
+    info.converged = result.converged;
+    info.numEvaluations = result.numEvaluations;
+    return info;
+}
@@ -1,5 +1,6 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/functional.h>
 #include "cuda_toolbox.h"
 #include <string>
 
@@ -14,11 +15,35 @@ void declareMLEinfo(py::module &m, const std::string &typestr) {
     std::string pyclass_name = std::string("MLEinfo") + typestr; 
     py::class_<Class>(m, pyclass_name.c_str())
         .def_readonly("optimal", &Class::optimal)
-        .def_readonly("likelihoods", &Class::likelihoods);
+        .def_readonly("likelihoods", &Class::likelihoods)
+        .def_readonly("fidelities", &Class::fidelities)
+        .def_readonly("grid", &Class::grid)
+        .def_readonly("marginals", &Class::marginals)
+        .def_readonly("topModels", &Class::topModels)
+        .def_readonly("complete", &Class::complete)
+        .def_readonly("converged", &Class::converged)
+        .def_readonly("numEvaluations", &Class::numEvaluations);
 }
 
 PYBIND11_MODULE(addm_toolbox_cuda, m) {
     m.doc() = "aDDMToolbox developed for CUDA.";
+    py::class_<ParameterGrid>(m, "ParameterGrid")
+        .def(py::init<vector<string>, vector<vector<float>>, bool>(), 
+            Arg("names"), 
+            Arg("axes"), 
+            Arg("storeValues")=true)
+        .def_readonly("names", &ParameterGrid::names)
+        .def_readonly("axes", &ParameterGrid::axes)
+        .def_readonly("values", &ParameterGrid::values)
+        .def("size", &ParameterGrid::size)
+        .def("index", &ParameterGrid::index, 
+            Arg("coordinates"))
+        .def("coordinates", &ParameterGrid::coordinates, 
+            Arg("index"))
+        .def("parameters", &ParameterGrid::parameters, 
+            Arg("index"))
+        .def("find", &ParameterGrid::find, 
+            Arg("parameters"));
     declareMLEinfo<DDM>(m, "DDM"); 
     declareMLEinfo<aDDM>(m, "aDDM");
     py::class_<ProbabilityData>(m, "ProbabilityData")
@@ -28,6 +53,51 @@ PYBIND11_MODULE(addm_toolbox_cuda, m) {
         .def_readonly("likelihood", &ProbabilityData::likelihood)
         .def_readonly("NLL", &ProbabilityData::NLL)
         .def_readonly("trialLikelihoods", &ProbabilityData::trialLikelihoods);
+    py::class_<NLLGradient>(m, "NLLGradient")
+        .def_readonly("NLL", &NLLGradient::NLL)
+        .def_readonly("gradient", &NLLGradient::gradient);
+    py::class_<PropagationOptions>(m, "PropagationOptions")
+        .def(py::init<>())
+        .def_readwrite("tailMass", &PropagationOptions::tailMass)
+        .def_readwrite("skipAhead", &PropagationOptions::skipAhead)
+        .def_readwrite("skipAheadMinSteps", &PropagationOptions::skipAheadMinSteps)
+        .def_readwrite("supportEpsilon", &PropagationOptions::supportEpsilon)
+        .def_readwrite("lockstep", &PropagationOptions::lockstep)
+        .def_readwrite("prefixSharing", &PropagationOptions::prefixSharing);
+    py::enum_<Fidelity>(m, "Fidelity")
+        .value("Coarse", Fidelity::Coarse)
+        .value("Fine", Fidelity::Fine);
+    py::class_<ScreeningOptions>(m, "ScreeningOptions")
+        .def(py::init<>())
+        .def_readwrite("enabled", &ScreeningOptions::enabled)
+        .def_readwrite("timeStep", &ScreeningOptions::timeStep)
+        .def_readwrite("approxStateStep", &ScreeningOptions::approxStateStep)
+        .def_readwrite("topFraction", &ScreeningOptions::topFraction)
+        .def_readwrite("margin", &ScreeningOptions::margin);
+    py::class_<CancellationToken>(m, "CancellationToken")
+        .def(py::init<>())
+        .def("cancel", &CancellationToken::cancel)
+        .def("isCancelled", &CancellationToken::isCancelled);
+    py::class_<FitProgress>(m, "FitProgress")
+        .def_readonly("modelsDone", &FitProgress::modelsDone)
+        .def_readonly("numModels", &FitProgress::numModels)
+        .def_readonly("bestNLL", &FitProgress::bestNLL)
+        .def_readonly("elapsedSeconds", &FitProgress::elapsedSeconds)
+        .def_readonly("etaSeconds", &FitProgress::etaSeconds);
+    py::class_<AnytimeOptions>(m, "AnytimeOptions")
+        .def(py::init<>())
+        .def_readwrite("timeLimit", &AnytimeOptions::timeLimit)
+        .def_readwrite("cancellation", &AnytimeOptions::cancellation)
+        .def_readwrite("progress", &AnytimeOptions::progress)
+        .def_readwrite("modelsPerBatch", &AnytimeOptions::modelsPerBatch);
+    py::class_<OptimizerOptions>(m, "OptimizerOptions")
+        .def(py::init<>())
+        .def_readwrite("xTolerance", &OptimizerOptions::xTolerance)
+        .def_readwrite("fTolerance", &OptimizerOptions::fTolerance)
+        .def_readwrite("maxEvaluations", &OptimizerOptions::maxEvaluations)
+        .def_readwrite("initialStep", &OptimizerOptions::initialStep)
+        .def_readwrite("gTolerance", &OptimizerOptions::gTolerance)
+        .def_readwrite("historySize", &OptimizerOptions::historySize);
     py::class_<FixationData>(m, "FixationData")
         .def(py::init<float, vector<int>, vector<int>, fixDists>(), 
             Arg("probFixLeftFirst"), 
@@ -77,15 +147,146 @@ PYBIND11_MODULE(addm_toolbox_cuda, m) {
             Arg("valueRight"),
             Arg("timeStep")=10, 
             Arg("seed")=-1)
-        .def_static("fitModelMLE", &DDM::fitModelMLE, 
+        .def_static("fitModelMLE", py::overload_cast<
+                const vector<DDMTrial> &, vector<float>, vector<float>, 
+                string, bool, float, unsigned int, vector<float>, vector<float>, int, float, 
+                int, int, int, bool, ScreeningOptions>(&DDM::fitModelMLE), 
             Arg("trials"), 
             Arg("rangeD"), 
             Arg("rangeSigma"), 
+            Arg("computeMethod")="auto", 
             Arg("normalizePosteriors")=false,
             Arg("barrier")=1, 
             Arg("nonDecisionTime")=0,
             Arg("bias")=vector<float>{0}, 
-            Arg("decay")=vector<float>{0});
+            Arg("decay")=vector<float>{0}, 
+            Arg("timeStep")=10, 
+            Arg("approxStateStep")=0.1, 
+            Arg("trialsPerThread")=10, 
+            Arg("refinementLevels")=0, 
+            Arg("refinementNeighborhoods")=1, 
+            Arg("pruning")=false, 
+            Arg("screening")=ScreeningOptions())
+        .def_static("fitModelMLE", py::overload_cast<
+                const TrialBatch &, vector<float>, vector<float>, 
+                string, bool, float, unsigned int, vector<float>, vector<float>, int, float, 
+                int, int, int, bool, ScreeningOptions>(&DDM::fitModelMLE), 
+            Arg("trials"), 
+            Arg("rangeD"), 
+            Arg("rangeSigma"), 
+            Arg("computeMethod")="auto", 
+            Arg("normalizePosteriors")=false,
+            Arg("barrier")=1, 
+            Arg("nonDecisionTime")=0,
+            Arg("bias")=vector<float>{0}, 
+            Arg("decay")=vector<float>{0}, 
+            Arg("timeStep")=10, 
+            Arg("approxStateStep")=0.1, 
+            Arg("trialsPerThread")=10, 
+            Arg("refinementLevels")=0, 
+            Arg("refinementNeighborhoods")=1, 
+            Arg("pruning")=false, 
+            Arg("screening")=ScreeningOptions())
+        .def_static("fitModelStreaming", py::overload_cast<
+                const vector<DDMTrial> &, vector<float>, vector<float>, 
+                string, float, unsigned int, vector<float>, vector<float>, int, float, int, 
+                int, int>(&DDM::fitModelStreaming), 
+            Arg("trials"), 
+            Arg("rangeD"), 
+            Arg("rangeSigma"), 
+            Arg("computeMethod")="auto", 
+            Arg("barrier")=1, 
+            Arg("nonDecisionTime")=0,
+            Arg("bias")=vector<float>{0}, 
+            Arg("decay")=vector<float>{0},
+            Arg("timeStep")=10, 
+            Arg("approxStateStep")=0.1, 
+            Arg("trialsPerThread")=10, 
+            Arg("topK")=10, 
+            Arg("modelsPerBatch")=64)
+        .def_static("fitModelStreaming", py::overload_cast<
+                const TrialBatch &, vector<float>, vector<float>, 
+                string, float, unsigned int, vector<float>, vector<float>, int, float, int, 
+                int, int>(&DDM::fitModelStreaming), 
+            Arg("trials"), 
+            Arg("rangeD"), 
+            Arg("rangeSigma"), 
+            Arg("computeMethod")="auto", 
+            Arg("barrier")=1, 
+            Arg("nonDecisionTime")=0,
+            Arg("bias")=vector<float>{0}, 
+            Arg("decay")=vector<float>{0},
+            Arg("timeStep")=10, 
+            Arg("approxStateStep")=0.1, 
+            Arg("trialsPerThread")=10, 
+            Arg("topK")=10, 
+            Arg("modelsPerBatch")=64)
+        .def_static("fitModelAnytime", py::overload_cast<
+                const vector<DDMTrial> &, vector<float>, vector<float>, 
+                string, float, unsigned int, vector<float>, vector<float>, int, float, int, 
+                AnytimeOptions>(&DDM::fitModelAnytime), 
+            Arg("trials"), 
+            Arg("rangeD"), 
+            Arg("rangeSigma"), 
+            Arg("computeMethod")="auto", 
+            Arg("barrier")=1, 
+            Arg("nonDecisionTime")=0,
+            Arg("bias")=vector<float>{0}, 
+            Arg("decay")=vector<float>{0},
+            Arg("timeStep")=10, 
+            Arg("approxStateStep")=0.1, 
+            Arg("trialsPerThread")=10, 
+            Arg("options")=AnytimeOptions())
+        .def_static("fitModelAnytime", py::overload_cast<
+                const TrialBatch &, vector<float>, vector<float>, 
+                string, float, unsigned int, vector<float>, vector<float>, int, float, int, 
+                AnytimeOptions>(&DDM::fitModelAnytime), 
+            Arg("trials"), 
+            Arg("rangeD"), 
+            Arg("rangeSigma"), 
+            Arg("computeMethod")="auto", 
+            Arg("barrier")=1, 
+            Arg("nonDecisionTime")=0,
+            Arg("bias")=vector<float>{0}, 
+            Arg("decay")=vector<float>{0},
+            Arg("timeStep")=10, 
+            Arg("approxStateStep")=0.1, 
+            Arg("trialsPerThread")=10, 
+            Arg("options")=AnytimeOptions())
+        .def_static("fitModelOptimize", py::overload_cast<
+                const vector<DDMTrial> &, vector<float>, vector<float>, 
+                string, float, unsigned int, vector<float>, vector<float>, int, float, int, 
+                std::optional<DDM>, OptimizerOptions>(&DDM::fitModelOptimize), 
+            Arg("trials"), 
+            Arg("rangeD"), 
+            Arg("rangeSigma"), 
+            Arg("computeMethod")="auto", 
+            Arg("barrier")=1, 
+            Arg("nonDecisionTime")=0,
+            Arg("bias")=vector<float>{0}, 
+            Arg("decay")=vector<float>{0}, 
+            Arg("timeStep")=10, 
+            Arg("approxStateStep")=0.1, 
+            Arg("trialsPerThread")=10, 
+            Arg("warmStart")=py::none(), 
+            Arg("options")=OptimizerOptions())
+        .def_static("fitModelOptimize", py::overload_cast<
+                const TrialBatch &, vector<float>, vector<float>, 
+                string, float, unsigned int, vector<float>, vector<float>, int, float, int, 
+                std::optional<DDM>, OptimizerOptions>(&DDM::fitModelOptimize), 
+            Arg("trials"), 
+            Arg("rangeD"), 
+            Arg("rangeSigma"), 
+            Arg("computeMethod")="auto", 
+            Arg("barrier")=1, 
+            Arg("nonDecisionTime")=0,
+            Arg("bias")=vector<float>{0}, 
+            Arg("decay")=vector<float>{0}, 
+            Arg("timeStep")=10, 
+            Arg("approxStateStep")=0.1, 
+            Arg("trialsPerThread")=10, 
+            Arg("warmStart")=py::none(), 
+            Arg("options")=OptimizerOptions());
     py::class_<aDDMTrial, DDMTrial>(m, "aDDMTrial")
         .def(py::init<unsigned int, int, int, int, vector<int>, vector<int>, vector<float>, float>(), 
             Arg("RT"), 
@@ -128,12 +329,76 @@ PYBIND11_MODULE(addm_toolbox_cuda, m) {
             Arg("fixationDist")=fixDists(), 
             Arg("timeBins")=vector<int>(), 
             Arg("seed")=-1)
-        .def_static("fitModelMLE", &aDDM::fitModelMLE, 
+        .def_static("computeCPUNLLs", py::overload_cast<
+                const vector<aDDM> &, const vector<aDDMTrial> &, int, int, float, int, int, 
+                PropagationOptions>(&aDDM::computeCPUNLLs), 
+            Arg("models"), 
+            Arg("trials"), 
+            Arg("trialsPerThread")=10, 
+            Arg("timeStep")=10, 
+            Arg("approxStateStep")=0.1, 
+            Arg("numThreads")=0, 
+            Arg("modelsPerBlock")=8, 
+            Arg("options")=PropagationOptions())
+        .def_static("computeCPUNLLs", py::overload_cast<
+                const vector<aDDM> &, const TrialBatch &, int, int, float, int, int, 
+                PropagationOptions>(&aDDM::computeCPUNLLs), 
+            Arg("models"), 
+            Arg("trials"), 
+            Arg("trialsPerThread")=10, 
+            Arg("timeStep")=10, 
+            Arg("approxStateStep")=0.1, 
+            Arg("numThreads")=0, 
+            Arg("modelsPerBlock")=8, 
+            Arg("options")=PropagationOptions())
+        .def("computeCPUNLLGradient", py::overload_cast<
+                const vector<aDDMTrial> &, int, float, int, 
+                PropagationOptions>(&aDDM::computeCPUNLLGradient), 
+            Arg("trials"), 
+            Arg("timeStep")=10, 
+            Arg("approxStateStep")=0.1, 
+            Arg("numThreads")=0, 
+            Arg("options")=PropagationOptions())
+        .def("computeCPUNLLGradient", py::overload_cast<
+                const TrialBatch &, int, float, int, 
+                PropagationOptions>(&aDDM::computeCPUNLLGradient), 
+            Arg("trials"), 
+            Arg("timeStep")=10, 
+            Arg("approxStateStep")=0.1, 
+            Arg("numThreads")=0, 
+            Arg("options")=PropagationOptions())
+        .def_static("fitModelMLE", py::overload_cast<
+                const vector<aDDMTrial> &, vector<float>, vector<float>, vector<float>, 
+                vector<float>, string, bool, float, unsigned int, vector<float>, vector<float>, 
+                int, float, int, int, int, bool, ScreeningOptions>(&aDDM::fitModelMLE), 
+            Arg("trials"), 
+            Arg("rangeD"), 
+            Arg("rangeSigma"), 
+            Arg("rangeTheta"),
+            Arg("rangeK")=vector<float>{0},
+            Arg("computeMethod")="auto", 
+            Arg("normalizePosteriors")=false,
+            Arg("barrier")=1, 
+            Arg("nonDecisionTime")=0,
+            Arg("bias")=vector<float>{0}, 
+            Arg("decay")=vector<float>{0},
+            Arg("timeStep")=10, 
+            Arg("approxStateStep")=0.1, 
+            Arg("trialsPerThread")=10, 
+            Arg("refinementLevels")=0, 
+            Arg("refinementNeighborhoods")=1, 
+            Arg("pruning")=false, 
+            Arg("screening")=ScreeningOptions())
+        .def_static("fitModelMLE", py::overload_cast<
+                const TrialBatch &, vector<float>, vector<float>, vector<float>, 
+                vector<float>, string, bool, float, unsigned int, vector<float>, vector<float>, 
+                int, float, int, int, int, bool, ScreeningOptions>(&aDDM::fitModelMLE), 
             Arg("trials"), 
             Arg("rangeD"), 
             Arg("rangeSigma"), 
             Arg("rangeTheta"),
             Arg("rangeK")=vector<float>{0},
+            Arg("computeMethod")="auto", 
             Arg("normalizePosteriors")=false,
             Arg("barrier")=1, 
             Arg("nonDecisionTime")=0,
@@ -141,12 +406,214 @@ PYBIND11_MODULE(addm_toolbox_cuda, m) {
             Arg("decay")=vector<float>{0},
             Arg("timeStep")=10, 
             Arg("approxStateStep")=0.1, 
-            Arg("trialsPerThread")=10); 
+            Arg("trialsPerThread")=10, 
+            Arg("refinementLevels")=0, 
+            Arg("refinementNeighborhoods")=1, 
+            Arg("pruning")=false, 
+            Arg("screening")=ScreeningOptions())
+        .def_static("fitModelStreaming", py::overload_cast<
+                const vector<aDDMTrial> &, vector<float>, vector<float>, vector<float>, 
+                vector<float>, string, float, unsigned int, vector<float>, vector<float>, int, 
+                float, int, int, int>(&aDDM::fitModelStreaming), 
+            Arg("trials"), 
+            Arg("rangeD"), 
+            Arg("rangeSigma"), 
+            Arg("rangeTheta"),
+            Arg("rangeK")=vector<float>{0},
+            Arg("computeMethod")="auto", 
+            Arg("barrier")=1, 
+            Arg("nonDecisionTime")=0,
+            Arg("bias")=vector<float>{0}, 
+            Arg("decay")=vector<float>{0},
+            Arg("timeStep")=10, 
+            Arg("approxStateStep")=0.1, 
+            Arg("trialsPerThread")=10, 
+            Arg("topK")=10, 
+            Arg("modelsPerBatch")=64)
+        .def_static("fitModelStreaming", py::overload_cast<
+                const TrialBatch &, vector<float>, vector<float>, vector<float>, 
+                vector<float>, string, float, unsigned int, vector<float>, vector<float>, int, 
+                float, int, int, int>(&aDDM::fitModelStreaming), 
+            Arg("trials"), 
+            Arg("rangeD"), 
+            Arg("rangeSigma"), 
+            Arg("rangeTheta"),
+            Arg("rangeK")=vector<float>{0},
+            Arg("computeMethod")="auto", 
+            Arg("barrier")=1, 
+            Arg("nonDecisionTime")=0,
+            Arg("bias")=vector<float>{0}, 
+            Arg("decay")=vector<float>{0},
+            Arg("timeStep")=10, 
+            Arg("approxStateStep")=0.1, 
+            Arg("trialsPerThread")=10, 
+            Arg("topK")=10, 
+            Arg("modelsPerBatch")=64)
+        .def_static("fitModelAnytime", py::overload_cast<
+                const vector<aDDMTrial> &, vector<float>, vector<float>, vector<float>, 
+                vector<float>, string, float, unsigned int, vector<float>, vector<float>, int, 
+                float, int, AnytimeOptions>(&aDDM::fitModelAnytime), 
+            Arg("trials"), 
+            Arg("rangeD"), 
+            Arg("rangeSigma"), 
+            Arg("rangeTheta"),
+            Arg("rangeK")=vector<float>{0},
+            Arg("computeMethod")="auto", 
+            Arg("barrier")=1, 
+            Arg("nonDecisionTime")=0,
+            Arg("bias")=vector<float>{0}, 
+            Arg("decay")=vector<float>{0},
+            Arg("timeStep")=10, 
+            Arg("approxStateStep")=0.1, 
+            Arg("trialsPerThread")=10, 
+            Arg("options")=AnytimeOptions())
+        .def_static("fitModelAnytime", py::overload_cast<
+                const TrialBatch &, vector<float>, vector<float>, vector<float>, 
+                vector<float>, string, float, unsigned int, vector<float>, vector<float>, int, 
+                float, int, AnytimeOptions>(&aDDM::fitModelAnytime), 
+            Arg("trials"), 
+            Arg("rangeD"), 
+            Arg("rangeSigma"), 
+            Arg("rangeTheta"),
+            Arg("rangeK")=vector<float>{0},
+            Arg("computeMethod")="auto", 
+            Arg("barrier")=1, 
+            Arg("nonDecisionTime")=0,
+            Arg("bias")=vector<float>{0}, 
+            Arg("decay")=vector<float>{0},
+            Arg("timeStep")=10, 
+            Arg("approxStateStep")=0.1, 
+            Arg("trialsPerThread")=10, 
+            Arg("options")=AnytimeOptions())
+        .def_static("fitModelOptimize", py::overload_cast<
+                const vector<aDDMTrial> &, vector<float>, vector<float>, vector<float>, 
+                vector<float>, string, float, unsigned int, vector<float>, vector<float>, int, 
+                float, int, std::optional<aDDM>, OptimizerOptions>(&aDDM::fitModelOptimize), 
+            Arg("trials"), 
+            Arg("rangeD"), 
+            Arg("rangeSigma"), 
+            Arg("rangeTheta"),
+            Arg("rangeK")=vector<float>{0},
+            Arg("computeMethod")="auto", 
+            Arg("barrier")=1, 
+            Arg("nonDecisionTime")=0,
+            Arg("bias")=vector<float>{0}, 
+            Arg("decay")=vector<float>{0},
+            Arg("timeStep")=10, 
+            Arg("approxStateStep")=0.1, 
+            Arg("trialsPerThread")=10, 
+            Arg("warmStart")=py::none(), 
+            Arg("options")=OptimizerOptions())
+        .def_static("fitModelOptimize", py::overload_cast<
+                const TrialBatch &, vector<float>, vector<float>, vector<float>, 
+                vector<float>, string, float, unsigned int, vector<float>, vector<float>, int, 
+                float, int, std::optional<aDDM>, OptimizerOptions>(&aDDM::fitModelOptimize), 
+            Arg("trials"), 
+            Arg("rangeD"), 
+            Arg("rangeSigma"), 
+            Arg("rangeTheta"),
+            Arg("rangeK")=vector<float>{0},
+            Arg("computeMethod")="auto", 
+            Arg("barrier")=1, 
+            Arg("nonDecisionTime")=0,
+            Arg("bias")=vector<float>{0}, 
+            Arg("decay")=vector<float>{0},
+            Arg("timeStep")=10, 
+            Arg("approxStateStep")=0.1, 
+            Arg("trialsPerThread")=10, 
+            Arg("warmStart")=py::none(), 
+            Arg("options")=OptimizerOptions())
+        .def_static("fitModelLBFGSB", py::overload_cast<
+                const vector<aDDMTrial> &, vector<float>, vector<float>, vector<float>, 
+                vector<float>, float, unsigned int, float, float, int, float, int, 
+                std::optional<aDDM>, OptimizerOptions>(&aDDM::fitModelLBFGSB), 
+            Arg("trials"), 
+            Arg("rangeD"), 
+            Arg("rangeSigma"), 
+            Arg("rangeTheta"),
+            Arg("rangeK")=vector<float>{0},
+            Arg("barrier")=1, 
+            Arg("nonDecisionTime")=0,
+            Arg("bias")=0, 
+            Arg("decay")=0,
+            Arg("timeStep")=10, 
+            Arg("approxStateStep")=0.1, 
+            Arg("numThreads")=0, 
+            Arg("warmStart")=py::none(), 
+            Arg("options")=OptimizerOptions())
+        .def_static("fitModelLBFGSB", py::overload_cast<
+                const TrialBatch &, vector<float>, vector<float>, vector<float>, 
+                vector<float>, float, unsigned int, float, float, int, float, int, 
+                std::optional<aDDM>, OptimizerOptions>(&aDDM::fitModelLBFGSB), 
+            Arg("trials"), 
+            Arg("rangeD"), 
+            Arg("rangeSigma"), 
+            Arg("rangeTheta"),
+            Arg("rangeK")=vector<float>{0},
+            Arg("barrier")=1, 
+            Arg("nonDecisionTime")=0,
+            Arg("bias")=0, 
+            Arg("decay")=0,
+            Arg("timeStep")=10, 
+            Arg("approxStateStep")=0.1, 
+            Arg("numThreads")=0, 
+            Arg("warmStart")=py::none(), 
+            Arg("options")=OptimizerOptions()); 
+    py::class_<TrialStore>(m, "TrialStore")
+        .def(py::init<const string &>(), 
+            Arg("filename"))
+        .def_readonly_static("version", &TrialStore::version)
+        .def("size", &TrialStore::size)
+        .def("numFixations", &TrialStore::numFixations)
+        .def("trial", &TrialStore::trial, 
+            Arg("index"))
+        .def("aDDMTrials", &TrialStore::aDDMTrials)
+        .def("DDMTrials", &TrialStore::DDMTrials)
+        .def("subjectTrials", &TrialStore::subjectTrials)
+        .def_static("save", py::overload_cast<
+                const string &, const std::map<int, vector<aDDMTrial>> &>(&TrialStore::save), 
+            Arg("filename"), 
+            Arg("data"))
+        .def_static("save", py::overload_cast<
+                const string &, const vector<aDDMTrial> &, int>(&TrialStore::save), 
+            Arg("filename"), 
+            Arg("trials"), 
+            Arg("subject")=0)
+        .def_static("save", py::overload_cast<
+                const string &, const vector<DDMTrial> &, int>(&TrialStore::save), 
+            Arg("filename"), 
+            Arg("trials"), 
+            Arg("subject")=0)
+        .def_static("convertCSV", &TrialStore::convertCSV, 
+            Arg("csvFilename"), 
+            Arg("storeFilename"), 
+            Arg("fixDataFilename")="");
+    py::class_<TrialBatch>(m, "TrialBatch")
+        .def(py::init<const vector<aDDMTrial> &>(), 
+            Arg("trials"))
+        .def(py::init<const vector<DDMTrial> &>(), 
+            Arg("trials"))
+        .def(py::init<const TrialStore &>(), 
+            Arg("store"))
+        .def_readonly("RT", &TrialBatch::RT)
+        .def_readonly("choice", &TrialBatch::choice)
+        .def_readonly("valueLeft", &TrialBatch::valueLeft)
+        .def_readonly("valueRight", &TrialBatch::valueRight)
+        .def_readonly("fixOffsets", &TrialBatch::fixOffsets)
+        .def_readonly("fixItem", &TrialBatch::fixItem)
+        .def_readonly("fixTime", &TrialBatch::fixTime)
+        .def("size", &TrialBatch::size)
+        .def("numFixations", &TrialBatch::numFixations)
+        .def("trial", &TrialBatch::trial, 
+            Arg("index"))
+        .def("aDDMTrials", &TrialBatch::aDDMTrials)
+        .def("DDMTrials", &TrialBatch::DDMTrials);
     m.def("loadDataFromSingleCSV", &loadDataFromSingleCSV, 
         Arg("filename"));
     m.def("loadDataFromCSV", &loadDataFromCSV, 
         Arg("expDataFilename"), 
-        Arg("fixDataFilename"));
+        Arg("fixDataFilename"), 
+        Arg("numThreads")=0);
     m.def("getEmpiricalDistributions", &getEmpiricalDistributions, 
         Arg("data"), 
         Arg("timeStep")=10, 
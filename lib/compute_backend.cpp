@@ -0,0 +1,560 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "compute_backend.h"
+#include "util.h"
+
+#ifndef ADDM_CPU_ONLY
+// Defined in cubackend.cu. Returns nullptr if no CUDA device is available.
+std::unique_ptr<ComputeBackend> makeGPUBackend();
+#endif
+
+
+std::vector<ProbabilityData> ComputeBackend::computeNLLs(
+    DDM &ddm, const std::vector<DDMTrial> &trials, const std::vector<float> &biases,
+    int trialsPerThread, int timeStep, float approxStateStep) {
+
+    std::vector<ProbabilityData> data;
+    for (float b : biases) {
+        DDM model = ddm;
+        model.bias = b;
+        data.push_back(computeNLL(model, trials, trialsPerThread, timeStep, approxStateStep));
+    }
+    return data;
+}
+
+
+std::vector<ProbabilityData> ComputeBackend::computeNLLs(
+    aDDM &addm, const std::vector<aDDMTrial> &trials, const std::vector<float> &biases,
+    int trialsPerThread, int timeStep, float approxStateStep) {
+
+    std::vector<ProbabilityData> data;
+    for (float b : biases) {
+        aDDM model = addm;
+        model.bias = b;
+        data.push_back(computeNLL(model, trials, trialsPerThread, timeStep, approxStateStep));
+    }
+    return data;
+}
+
+
+std::vector<std::vector<ProbabilityData>> ComputeBackend::computeGridNLLs(
+    const std::vector<DDM> &models, const std::vector<DDMTrial> &trials, 
+    const std::vector<float> &biases, int trialsPerThread, int timeStep, float approxStateStep, 
+    bool keepTrialLikelihoods) {
+
+    std::vector<std::vector<ProbabilityData>> data;
+    for (DDM model : models) {
+        data.push_back(
+            computeNLLs(model, trials, biases, trialsPerThread, timeStep, approxStateStep));
+        if (!keepTrialLikelihoods) {
+            for (ProbabilityData &biasData : data.back()) {
+                std::vector<double>().swap(biasData.trialLikelihoods);
+            }
+        }
+    }
+    return data;
+}
+
+
+std::vector<std::vector<ProbabilityData>> ComputeBackend::computeGridNLLs(
+    const std::vector<aDDM> &models, const std::vector<aDDMTrial> &trials, 
+    const std::vector<float> &biases, int trialsPerThread, int timeStep, float approxStateStep, 
+    bool keepTrialLikelihoods) {
+
+    std::vector<std::vector<ProbabilityData>> data;
+    for (aDDM model : models) {
+        data.push_back(
+            computeNLLs(model, trials, biases, trialsPerThread, timeStep, approxStateStep));
+        if (!keepTrialLikelihoods) {
+            for (ProbabilityData &biasData : data.back()) {
+                std::vector<double>().swap(biasData.trialLikelihoods);
+            }
+        }
+    }
+    return data;
+}
+
+
+ProbabilityData ComputeBackend::computeNLL(
+    DDM &ddm, const TrialBatch &trials,
+    int trialsPerThread, int timeStep, float approxStateStep) {
+
+    return computeNLL(ddm, trials.DDMTrials(), trialsPerThread, timeStep, approxStateStep);
+}
+
+
+ProbabilityData ComputeBackend::computeNLL(
+    aDDM &addm, const TrialBatch &trials,
+    int trialsPerThread, int timeStep, float approxStateStep) {
+
+    return computeNLL(addm, trials.aDDMTrials(), trialsPerThread, timeStep, approxStateStep);
+}
+
+
+std::vector<std::vector<ProbabilityData>> ComputeBackend::computeGridNLLs(
+    const std::vector<DDM> &models, const TrialBatch &trials, 
+    const std::vector<float> &biases, int trialsPerThread, int timeStep, float approxStateStep, 
+    bool keepTrialLikelihoods) {
+
+    return computeGridNLLs(
+        models, trials.DDMTrials(), biases, trialsPerThread, timeStep, approxStateStep, 
+        keepTrialLikelihoods);
+}
+
+
+std::vector<std::vector<ProbabilityData>> ComputeBackend::computeGridNLLs(
+    const std::vector<aDDM> &models, const TrialBatch &trials, 
+    const std::vector<float> &biases, int trialsPerThread, int timeStep, float approxStateStep, 
+    bool keepTrialLikelihoods) {
+
+    return computeGridNLLs(
+        models, trials.aDDMTrials(), biases, trialsPerThread, timeStep, approxStateStep, 
+        keepTrialLikelihoods);
+}
+
+
+std::vector<std::vector<ProbabilityData>> ComputeBackend::computeBoundedGridNLLs(
+    const std::vector<DDM> &models, const TrialBatch &trials, 
+    const std::vector<float> &biases, int trialsPerThread, int timeStep, float approxStateStep, 
+    double &bound) {
+
+    return computeBoundedGridNLLs(
+        models, trials.DDMTrials(), biases, trialsPerThread, timeStep, approxStateStep, bound);
+}
+
+
+std::vector<std::vector<ProbabilityData>> ComputeBackend::computeBoundedGridNLLs(
+    const std::vector<aDDM> &models, const TrialBatch &trials, 
+    const std::vector<float> &biases, int trialsPerThread, int timeStep, float approxStateStep, 
+    double &bound) {
+
+    return computeBoundedGridNLLs(
+        models, trials.aDDMTrials(), biases, trialsPerThread, timeStep, approxStateStep, bound);
+}
+
+
+/**
+ * @brief Split trials into numChunks contiguous chunks of about equal cost, estimated as the 
+ * number of time steps of each trial. 
+ * 
+ * @param RT Response time of each trial. 
+ * @param chunkCosts Output cost of each chunk. 
+ * @return Vector of numChunks + 1 offsets, where chunk c holds the trials from entry c up to, 
+ * but excluding, entry c + 1. 
+ */
+static std::vector<size_t> splitTrials(
+    const std::vector<int> &RT, int timeStep, int numChunks, std::vector<double> &chunkCosts) {
+
+    size_t numTrials = RT.size();
+    std::vector<double> trialCosts(numTrials);
+    double totalCost = 0;
+    for (size_t i = 0; i < numTrials; i++) {
+        trialCosts[i] = RT[i] / timeStep + 1;
+        totalCost += trialCosts[i];
+    }
+    std::vector<size_t> chunkBegins = {0};
+    chunkCosts.clear();
+    double cost = 0;
+    for (int c = 0; c < numChunks; c++) {
+        double target = totalCost * (c + 1) / numChunks;
+        double chunkCost = 0;
+        size_t i = chunkBegins.back();
+        while (i < numTrials && (c == numChunks - 1 || cost + trialCosts[i] / 2 <= target)) {
+            cost += trialCosts[i];
+            chunkCost += trialCosts[i++];
+        }
+        chunkBegins.push_back(i);
+        chunkCosts.push_back(chunkCost);
+    }
+    return chunkBegins;
+}
+
+
+/**
+ * @brief Sum the likelihoods and NLLs of numTrials trials under numBiases biases, stored as 
+ * likelihoods[i * numBiases + b], in trial order. 
+ * 
+ * @return vector of ProbabilityData, one per bias, without trialLikelihoods. 
+ */
+static std::vector<ProbabilityData> sumLikelihoods(
+    const double *likelihoods, size_t numTrials, int numBiases) {
+
+    std::vector<ProbabilityData> sums(numBiases);
+    for (size_t i = 0; i < numTrials; i++) {
+        for (int b = 0; b < numBiases; b++) {
+            sums[b].likelihood += likelihoods[i * numBiases + b];
+            sums[b].NLL += -log(likelihoods[i * numBiases + b]);
+        }
+    }
+    return sums;
+}
+
+
+/**
+ * @brief Evaluate every model of a grid as a set of (model, trial chunk) tasks scheduled with 
+ * parallelForWeighted. The trials are split into contiguous ranges of about equal cost, 
+ * estimated as the number of time steps of each trial, and each task reads its range in place 
+ * from the batch. Each task reduces its range to per-bias sums in a slot of its own, and the 
+ * sums are then added in chunk order, so the results do not depend on the number of threads. 
+ * 
+ * @param keepTrialLikelihoods Whether each task also writes the likelihoods of its range into 
+ * the trialLikelihoods of the results. 
+ * @param evaluate Callable computing the likelihoods of one model, under every bias, for the 
+ * trials from begin up to end on the calling thread, as evaluate(model, begin, end, likelihoods) 
+ * with likelihoods[(i - begin) * numBiases + b]. 
+ */
+template <class Model, class Evaluate>
+static std::vector<std::vector<ProbabilityData>> evaluateGrid(
+    const std::vector<Model> &models, const TrialBatch &trials, int numBiases, 
+    int timeStep, int numThreads, bool keepTrialLikelihoods, Evaluate evaluate) {
+
+    int numModels = models.size();
+    size_t numTrials = trials.size();
+
+    // At least minGridTasks tasks leave room to steal work on large machines. The chunks only 
+    // depend on the grid, never on numThreads, so that every thread count computes the same sums.
+    const int minGridTasks = 256;
+    int numChunks = (minGridTasks + numModels - 1) / numModels;
+    numChunks = std::max(1, (int) std::min((size_t) numChunks, numTrials));
+    std::vector<double> chunkCosts;
+    std::vector<size_t> chunkBegins = splitTrials(trials.RT, timeStep, numChunks, chunkCosts);
+
+    std::vector<std::vector<ProbabilityData>> grid(
+        numModels, std::vector<ProbabilityData>(numBiases));
+    if (keepTrialLikelihoods) {
+        for (std::vector<ProbabilityData> &biasData : grid) {
+            for (ProbabilityData &data : biasData) {
+                data.trialLikelihoods.resize(numTrials);
+            }
+        }
+    }
+    // chunkSums[(m * numChunks + c) * numBiases + b]
+    std::vector<ProbabilityData> chunkSums((size_t) numModels * numChunks * numBiases);
+    std::vector<double> taskCosts;
+    for (int m = 0; m < numModels; m++) {
+        taskCosts.insert(taskCosts.end(), chunkCosts.begin(), chunkCosts.end());
+    }
+    parallelForWeighted(taskCosts, numThreads, [&](int task) {
+        int m = task / numChunks;
+        int c = task % numChunks;
+        size_t begin = chunkBegins[c];
+        size_t end = chunkBegins[c + 1];
+        std::vector<double> likelihoods((end - begin) * numBiases);
+        evaluate(models[m], begin, end, likelihoods.data());
+        std::vector<ProbabilityData> sums = sumLikelihoods(
+            likelihoods.data(), end - begin, numBiases);
+        std::move(sums.begin(), sums.end(), &chunkSums[(size_t) task * numBiases]);
+        if (keepTrialLikelihoods) {
+            for (int b = 0; b < numBiases; b++) {
+                std::vector<double> &trialLikelihoods = grid[m][b].trialLikelihoods;
+                for (size_t i = begin; i < end; i++) {
+                    trialLikelihoods[i] = likelihoods[(i - begin) * numBiases + b];
+                }
+            }
+        }
+    });
+
+    for (int m = 0; m < numModels; m++) {
+        for (int c = 0; c < numChunks; c++) {
+            const ProbabilityData *sums = &chunkSums[((size_t) m * numChunks + c) * numBiases];
+            for (int b = 0; b < numBiases; b++) {
+                grid[m][b].likelihood += sums[b].likelihood;
+                grid[m][b].NLL += sums[b].NLL;
+            }
+        }
+    }
+    return grid;
+}
+
+
+/**
+ * @brief Evaluate every model of a grid with branch and bound. Each model accumulates the NLLs 
+ * of its trial chunks in order and is dropped once its partial NLL exceeds the shared bound under
+ * every bias. Models that complete lower the bound for the others. Models are scheduled with 
+ * parallelForWeighted, so which models are dropped may depend on the number of threads, but the 
+ * NLLs of the completed models do not. 
+ * 
+ * @param RT Response time of each trial, in the order they are accumulated. 
+ * @param bound Initial bound, updated in place to the smallest NLL found. 
+ * @param evaluate Callable computing the ProbabilityData of one model, under every bias, for the 
+ * trials from begin up to end on the calling thread, as evaluate(model, begin, end). 
+ */
+template <class Model, class Evaluate>
+static std::vector<std::vector<ProbabilityData>> evaluateBoundedGrid(
+    const std::vector<Model> &models, const std::vector<int> &RT, int numBiases, 
+    int timeStep, int numThreads, double &bound, Evaluate evaluate) {
+
+    int numModels = models.size();
+    // Checking the bound after every 1/boundChecks of the work wastes at most that fraction of 
+    // the work of a dropped model. 
+    const int boundChecks = 32;
+    int numChunks = std::max(1, (int) std::min((size_t) boundChecks, RT.size()));
+    std::vector<double> chunkCosts;
+    std::vector<size_t> chunkBegins = splitTrials(RT, timeStep, numChunks, chunkCosts);
+
+    std::atomic<double> sharedBound(bound);
+    std::vector<std::vector<ProbabilityData>> grid(numModels);
+    parallelForWeighted(std::vector<double>(numModels, 1), numThreads, [&](int m) {
+        std::vector<ProbabilityData> sums(numBiases);
+        bool dropped = false;
+        for (int c = 0; c < numChunks && !dropped; c++) {
+            std::vector<ProbabilityData> data = evaluate(
+                models[m], chunkBegins[c], chunkBegins[c + 1]);
+            double minPartialNLL = HUGE_VAL;
+            for (int b = 0; b < numBiases; b++) {
+                sums[b].likelihood += data[b].likelihood;
+                sums[b].NLL += data[b].NLL;
+                minPartialNLL = std::min(minPartialNLL, sums[b].NLL);
+            }
+            dropped = c < numChunks - 1 && minPartialNLL > sharedBound.load();
+        }
+        if (dropped) {
+            for (ProbabilityData &data : sums) {
+                data.NLL = HUGE_VAL;
+            }
+        } else {
+            for (const ProbabilityData &data : sums) {
+                double current = sharedBound.load();
+                while (data.NLL < current && 
+                    !sharedBound.compare_exchange_weak(current, data.NLL)) {
+                }
+            }
+        }
+        grid[m] = std::move(sums);
+    });
+    bound = sharedBound.load();
+    return grid;
+}
+
+
+std::vector<std::vector<ProbabilityData>> ComputeBackend::computeBoundedGridNLLs(
+    const std::vector<DDM> &models, const std::vector<DDMTrial> &trials, 
+    const std::vector<float> &biases, int trialsPerThread, int timeStep, float approxStateStep, 
+    double &bound) {
+
+    std::vector<int> RT;
+    for (const DDMTrial &trial : trials) {
+        RT.push_back(trial.RT);
+    }
+    return evaluateBoundedGrid(
+        models, RT, biases.size(), timeStep, 1, bound, 
+        [&](DDM model, size_t begin, size_t end) {
+            std::vector<DDMTrial> chunk(trials.begin() + begin, trials.begin() + end);
+            return computeNLLs(model, chunk, biases, trialsPerThread, timeStep, approxStateStep);
+        });
+}
+
+
+std::vector<std::vector<ProbabilityData>> ComputeBackend::computeBoundedGridNLLs(
+    const std::vector<aDDM> &models, const std::vector<aDDMTrial> &trials, 
+    const std::vector<float> &biases, int trialsPerThread, int timeStep, float approxStateStep, 
+    double &bound) {
+
+    std::vector<int> RT;
+    for (const aDDMTrial &trial : trials) {
+        RT.push_back(trial.RT);
+    }
+    return evaluateBoundedGrid(
+        models, RT, biases.size(), timeStep, 1, bound, 
+        [&](aDDM model, size_t begin, size_t end) {
+            std::vector<aDDMTrial> chunk(trials.begin() + begin, trials.begin() + end);
+            return computeNLLs(model, chunk, biases, trialsPerThread, timeStep, approxStateStep);
+        });
+}
+
+
+/**
+ * @brief Native C++ engines, optionally restricted to a fixed number of threads. Every model 
+ * evaluated by the same backend shares one PropagationCache, so models of a grid that produce the
+ * same drift mean reuse each other's kernels and crossing CDFs. Grids are evaluated from a 
+ * TrialBatch as (model, trial range) tasks balanced over the threads by their number of time 
+ * steps, with every task reading its range in place; vectors of trials are packed into a batch 
+ * once per call. aDDM trials are propagated with prefix sharing, so trials with common fixation 
+ * prefixes are only propagated once per model. Branch-and-bound grids evaluate one model per task
+ * against a bound shared by every thread.
+ *
+ */
+class CPUBackend: public ComputeBackend {
+    private:
+        int numThreads;
+        PropagationOptions options;
+
+    public:
+        CPUBackend(int numThreads) {
+            this->numThreads = numThreads;
+            this->options.cache = std::make_shared<PropagationCache>();
+            this->options.prefixSharing = true;
+        }
+
+        ProbabilityData computeNLL(
+            DDM &ddm, const std::vector<DDMTrial> &trials,
+            int, int timeStep, float approxStateStep) override {
+            return ddm.computeCPUNLL(trials, timeStep, approxStateStep, numThreads, options);
+        }
+
+        ProbabilityData computeNLL(
+            aDDM &addm, const std::vector<aDDMTrial> &trials,
+            int trialsPerThread, int timeStep, float approxStateStep) override {
+            return addm.computeCPUNLL(
+                trials, trialsPerThread, timeStep, approxStateStep, numThreads, options);
+        }
+
+        ProbabilityData computeNLL(
+            DDM &ddm, const TrialBatch &trials,
+            int, int timeStep, float approxStateStep) override {
+            return ddm.computeCPUNLL(trials, timeStep, approxStateStep, numThreads, options);
+        }
+
+        ProbabilityData computeNLL(
+            aDDM &addm, const TrialBatch &trials,
+            int trialsPerThread, int timeStep, float approxStateStep) override {
+            return addm.computeCPUNLL(
+                trials, trialsPerThread, timeStep, approxStateStep, numThreads, options);
+        }
+
+        std::vector<ProbabilityData> computeNLLs(
+            DDM &ddm, const std::vector<DDMTrial> &trials, const std::vector<float> &biases,
+            int, int timeStep, float approxStateStep) override {
+            return ddm.computeCPUNLL(
+                trials, biases, timeStep, approxStateStep, numThreads, options);
+        }
+
+        std::vector<ProbabilityData> computeNLLs(
+            aDDM &addm, const std::vector<aDDMTrial> &trials, const std::vector<float> &biases,
+            int trialsPerThread, int timeStep, float approxStateStep) override {
+            return addm.computeCPUNLL(
+                trials, biases, trialsPerThread, timeStep, approxStateStep, numThreads, options);
+        }
+
+        std::vector<std::vector<ProbabilityData>> computeGridNLLs(
+            const std::vector<DDM> &models, const std::vector<DDMTrial> &trials, 
+            const std::vector<float> &biases, int trialsPerThread, int timeStep, 
+            float approxStateStep, bool keepTrialLikelihoods) override {
+            return computeGridNLLs(
+                models, TrialBatch(trials), biases, trialsPerThread, timeStep, approxStateStep, 
+                keepTrialLikelihoods);
+        }
+
+        std::vector<std::vector<ProbabilityData>> computeGridNLLs(
+            const std::vector<aDDM> &models, const std::vector<aDDMTrial> &trials, 
+            const std::vector<float> &biases, int trialsPerThread, int timeStep, 
+            float approxStateStep, bool keepTrialLikelihoods) override {
+            return computeGridNLLs(
+                models, TrialBatch(trials), biases, trialsPerThread, timeStep, approxStateStep, 
+                keepTrialLikelihoods);
+        }
+
+        std::vector<std::vector<ProbabilityData>> computeGridNLLs(
+            const std::vector<DDM> &models, const TrialBatch &trials, 
+            const std::vector<float> &biases, int, int timeStep, 
+            float approxStateStep, bool keepTrialLikelihoods) override {
+            return evaluateGrid(
+                models, trials, biases.size(), timeStep, numThreads, keepTrialLikelihoods, 
+                [&](DDM model, size_t begin, size_t end, double *likelihoods) {
+                    model.computeCPULikelihoods(
+                        trials, begin, end, biases, likelihoods, timeStep, approxStateStep, 1, 
+                        options);
+                });
+        }
+
+        std::vector<std::vector<ProbabilityData>> computeGridNLLs(
+            const std::vector<aDDM> &models, const TrialBatch &trials, 
+            const std::vector<float> &biases, int trialsPerThread, int timeStep, 
+            float approxStateStep, bool keepTrialLikelihoods) override {
+            return evaluateGrid(
+                models, trials, biases.size(), timeStep, numThreads, keepTrialLikelihoods, 
+                [&](aDDM model, size_t begin, size_t end, double *likelihoods) {
+                    model.computeCPULikelihoods(
+                        trials, begin, end, biases, likelihoods, trialsPerThread, timeStep, 
+                        approxStateStep, 1, options);
+                });
+        }
+
+        std::vector<std::vector<ProbabilityData>> computeBoundedGridNLLs(
+            const std::vector<DDM> &models, const std::vector<DDMTrial> &trials, 
+            const std::vector<float> &biases, int trialsPerThread, int timeStep, 
+            float approxStateStep, double &bound) override {
+            return computeBoundedGridNLLs(
+                models, TrialBatch(trials), biases, trialsPerThread, timeStep, approxStateStep, 
+                bound);
+        }
+
+        std::vector<std::vector<ProbabilityData>> computeBoundedGridNLLs(
+            const std::vector<aDDM> &models, const std::vector<aDDMTrial> &trials, 
+            const std::vector<float> &biases, int trialsPerThread, int timeStep, 
+            float approxStateStep, double &bound) override {
+            return computeBoundedGridNLLs(
+                models, TrialBatch(trials), biases, trialsPerThread, timeStep, approxStateStep, 
+                bound);
+        }
+
+        std::vector<std::vector<ProbabilityData>> computeBoundedGridNLLs(
+            const std::vector<DDM> &models, const TrialBatch &trials, 
+            const std::vector<float> &biases, int, int timeStep, 
+            float approxStateStep, double &bound) override {
+            return evaluateBoundedGrid(
+                models, trials.RT, biases.size(), timeStep, numThreads, bound, 
+                [&](DDM model, size_t begin, size_t end) {
+                    std::vector<double> likelihoods((end - begin) * biases.size());
+                    model.computeCPULikelihoods(
+                        trials, begin, end, biases, likelihoods.data(), timeStep, 
+                        approxStateStep, 1, options);
+                    return sumLikelihoods(likelihoods.data(), end - begin, biases.size());
+                });
+        }
+
+        std::vector<std::vector<ProbabilityData>> computeBoundedGridNLLs(
+            const std::vector<aDDM> &models, const TrialBatch &trials, 
+            const std::vector<float> &biases, int trialsPerThread, int timeStep, 
+            float approxStateStep, double &bound) override {
+            return evaluateBoundedGrid(
+                models, trials.RT, biases.size(), timeStep, numThreads, bound, 
+                [&](aDDM model, size_t begin, size_t end) {
+                    std::vector<double> likelihoods((end - begin) * biases.size());
+                    model.computeCPULikelihoods(
+                        trials, begin, end, biases, likelihoods.data(), trialsPerThread, 
+                        timeStep, approxStateStep, 1, options);
+                    return sumLikelihoods(likelihoods.data(), end - begin, biases.size());
+                });
+        }
+};
+
+
+std::unique_ptr<ComputeBackend> getComputeBackend(std::string computeMethod) {
+    if (std::find(validComputeMethods.begin(), validComputeMethods.end(), computeMethod) ==
+        validComputeMethods.end()) {
+        std::string methods;
+        for (const std::string &m : validComputeMethods) {
+            methods += (methods.empty() ? "" : ", ") + m;
+        }
+        throw std::invalid_argument(
+            "Unrecognized computeMethod " + computeMethod + ". Valid methods are " + methods + ".");
+    }
+
+    if (computeMethod == "basic") {
+        return std::make_unique<CPUBackend>(1);
+    }
+    if (computeMethod == "thread") {
+        return std::make_unique<CPUBackend>(0);
+    }
+
+#ifndef ADDM_CPU_ONLY
+    std::unique_ptr<ComputeBackend> gpu = makeGPUBackend();
+    if (gpu) {
+        return gpu;
+    }
+    if (computeMethod == "gpu") {
+        throw std::runtime_error("computeMethod gpu requested but no CUDA device is available.");
+    }
+#else
+    if (computeMethod == "gpu") {
+        throw std::invalid_argument(
+            "computeMethod gpu requested but libaddm was built without CUDA support.");
+    }
+#endif
+    return std::make_unique<CPUBackend>(0);
+}
@@ -0,0 +1,969 @@
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "addm.h"
+#include "propagation.h"
+#include "trial_batch.h"
+#include "util.h"
+
+
+void aDDM::advanceFixation(
+    const StateSpace &space, float mean, int numSteps, int &time, 
+    const PropagationOptions &options, std::vector<double> &prStates, 
+    std::vector<double> &prStatesNew, double *probUpCrossing, double *probDownCrossing, 
+    int &supportLo, int &supportHi, int numColumns) {
+
+    if (numSteps <= 0) {
+        return;
+    }
+    PropagationCache &cache = *options.cache;
+    if (decay == 0 && options.skipAhead && numSteps >= options.skipAheadMinSteps) {
+        std::shared_ptr<const SkipAheadOperator> op = cache.getSkipAheadOperator(
+            space, mean, sigma, options.tailMass, barrier, numSteps);
+        if (op) {
+            op->advance(
+                numSteps, prStates, prStatesNew, probUpCrossing, probDownCrossing, 
+                supportLo, supportHi, options.supportEpsilon, numColumns);
+            time += numSteps;
+            return;
+        }
+    }
+
+    std::shared_ptr<const TransitionKernel> kernel = cache.getTransitionKernel(
+        space, mean, sigma, options.tailMass);
+    std::shared_ptr<const CrossingCDFs> cdfs;
+    std::vector<std::shared_ptr<const CrossingCDFs>> decayingCDFs;
+    if (decay == 0) {
+        cdfs = cache.getCrossingCDFs(space, mean, sigma, barrier, -barrier);
+    } else {
+        decayingCDFs = cache.getDecayingCrossingCDFs(
+            space, mean, sigma, barrier, decay, time, numSteps);
+    }
+
+    for (int t = 0; t < numSteps; t++) {
+        float barrierUp = barrier / (1 + (decay * time));
+        float barrierDown = -barrier / (1 + (decay * time));
+        if (decay != 0) {
+            cdfs = decayingCDFs[t];
+        }
+        propagateStep(
+            space, *kernel, cdfs->changeUpCDFs, cdfs->changeDownCDFs,
+            barrierUp, barrierDown, prStates, prStatesNew, probUpCrossing, probDownCrossing, 
+            supportLo, supportHi, options.supportEpsilon, numColumns);
+        time++;
+    }
+}
+
+
+void aDDM::getTrialLikelihoods(
+    int valueLeft, int valueRight, int choice, const int *fixItem, const int *fixTime, 
+    int fixLen, const StateSpace &space, const std::vector<int> &biasStates, int timeStep, 
+    const PropagationOptions &options, double *likelihoods) {
+
+    int numStates = space.numStates;
+    int numColumns = biasStates.size();
+
+    int numTimeSteps = 0;
+    for (int i = 0; i < fixLen; i++) {
+        numTimeSteps += fixTime[i] / timeStep;
+    }
+    numTimeSteps++;
+
+    // One column per initial state, interleaved as prStates[i * numColumns + c]. 
+    std::vector<double> prStates(numStates * numColumns, 0);
+    std::vector<double> prStatesNew(numStates * numColumns);
+    int supportLo = numStates - 1;
+    int supportHi = 0;
+    for (int c = 0; c < numColumns; c++) {
+        prStates[biasStates[c] * numColumns + c] = 1;
+        supportLo = std::min(supportLo, biasStates[c]);
+        supportHi = std::max(supportHi, biasStates[c]);
+    }
+
+    // Only the crossing probabilities of the final time step determine the likelihood.
+    std::vector<double> probUpCrossing(numColumns, 0);
+    std::vector<double> probDownCrossing(numColumns, 0);
+
+    int time = 1;
+    for (int f = 0; f < fixLen; f++) {
+        int fItem = fixItem[f];
+        int fTime = fixTime[f];
+
+        float mean;
+        if (fItem == 1) {
+            mean = d * ((valueLeft + k) - (theta * valueRight));
+        } else if (fItem == 2) {
+            mean = d * ((theta * valueLeft) - (valueRight + k));
+        } else {
+            mean = 0;
+        }
+
+        advanceFixation(
+            space, mean, fTime / timeStep, time, options, prStates, prStatesNew, 
+            probUpCrossing.data(), probDownCrossing.data(), supportLo, supportHi, numColumns);
+    }
+
+    for (int c = 0; c < numColumns; c++) {
+        double likelihood = 0;
+        if (choice == -1) {
+            if (probUpCrossing[c] > 0) {
+                likelihood = probUpCrossing[c];
+            }
+        } else if (choice == 1) {
+            if (probDownCrossing[c] > 0) {
+                likelihood = probDownCrossing[c];
+            }
+        }
+        if (likelihood == 0) {
+            likelihood = pow(10, -20);
+        }
+        likelihoods[c] = likelihood;
+    }
+}
+
+
+void aDDM::getTrialLikelihoods(
+    const TrialBatch &trials, size_t trialNum, const StateSpace &space, 
+    const std::vector<int> &biasStates, int timeStep, const PropagationOptions &options, 
+    double *likelihoods) {
+
+    // The fixations of the trial are read in place from the CSR columns. 
+    size_t offset = trials.fixOffsets[trialNum];
+    getTrialLikelihoods(
+        trials.valueLeft[trialNum], trials.valueRight[trialNum], trials.choice[trialNum], 
+        trials.fixItem.data() + offset, trials.fixTime.data() + offset, 
+        trials.fixOffsets[trialNum + 1] - offset, space, biasStates, timeStep, options, 
+        likelihoods);
+}
+
+
+/**
+ * @brief Split the likelihoods of every trial under every bias, stored as 
+ * likelihoods[trialNum * numBiases + b], into one ProbabilityData per bias. 
+ */
+static std::vector<ProbabilityData> collectProbabilityData(
+    const std::vector<double> &likelihoods, int numTrials, int numBiases) {
+
+    std::vector<ProbabilityData> data;
+    for (int b = 0; b < numBiases; b++) {
+        double NLL = 0;
+        double likelihood = 0;
+        std::vector<double> trialLikelihoods(numTrials);
+        for (int i = 0; i < numTrials; i++) {
+            trialLikelihoods[i] = likelihoods[i * numBiases + b];
+            likelihood += trialLikelihoods[i];
+            NLL += -log(trialLikelihoods[i]);
+        }
+        data.push_back(ProbabilityData(likelihood, NLL));
+        data.back().trialLikelihoods = std::move(trialLikelihoods);
+    }
+    return data;
+}
+
+
+/**
+ * @brief Index of the drift mean used during a fixation on fItem: 1 for the left item, 2 for the 
+ * right item and 0 for any other fixation. 
+ */
+static int meanIndex(int fItem) {
+    return (fItem == 1 || fItem == 2) ? fItem : 0;
+}
+
+
+void aDDM::getLockstepLikelihoods(
+    const TrialBatch &trials, const std::vector<int> &batch, 
+    const StateSpace &space, int biasState, int timeStep, const PropagationOptions &options, 
+    double *likelihoods) {
+
+    // Trials in a batch share their values, so every fixation uses one of three drift means. 
+    int numStates = space.numStates;
+    int valueLeft = trials.valueLeft[batch[0]];
+    int valueRight = trials.valueRight[batch[0]];
+    float means[3] = {
+        0, 
+        d * ((valueLeft + k) - (theta * valueRight)), 
+        d * ((theta * valueLeft) - (valueRight + k))
+    };
+
+    // A lane follows one trial of the batch through its fixations. 
+    struct Lane {
+        int slot;
+        int fixation;
+        int remainingSteps;
+    };
+    // Lanes that currently share a drift mean, with their distributions interleaved as columns.
+    struct Group {
+        std::vector<Lane> lanes;
+        std::vector<double> prStates;
+        std::vector<double> prStatesNew;
+        std::vector<double> probUpCrossing;
+        std::vector<double> probDownCrossing;
+        int supportLo;
+        int supportHi;
+    };
+
+    // Moves a lane to its next fixation with at least one time step. Returns false once the 
+    // trial has no fixations left. 
+    auto fixItem = [&](const Lane &lane) {
+        return trials.fixItem[trials.fixOffsets[batch[lane.slot]] + lane.fixation];
+    };
+    auto nextFixation = [&](Lane &lane) {
+        size_t fixBegin = trials.fixOffsets[batch[lane.slot]];
+        int fixLen = trials.fixOffsets[batch[lane.slot] + 1] - fixBegin;
+        while (++lane.fixation < fixLen) {
+            lane.remainingSteps = trials.fixTime[fixBegin + lane.fixation] / timeStep;
+            if (lane.remainingSteps > 0) {
+                return true;
+            }
+        }
+        return false;
+    };
+    auto finish = [&](int slot, double probUpCrossing, double probDownCrossing) {
+        int choice = trials.choice[batch[slot]];
+        double likelihood = 0;
+        if (choice == -1) {
+            if (probUpCrossing > 0) {
+                likelihood = probUpCrossing;
+            }
+        } else if (choice == 1) {
+            if (probDownCrossing > 0) {
+                likelihood = probDownCrossing;
+            }
+        }
+        if (likelihood == 0) {
+            likelihood = pow(10, -20);
+        }
+        likelihoods[slot] = likelihood;
+    };
+
+    std::vector<std::vector<Lane>> lanes(3);
+    for (int slot = 0; slot < batch.size(); slot++) {
+        Lane lane = {slot, -1, 0};
+        if (nextFixation(lane)) {
+            int g = meanIndex(fixItem(lane));
+            lanes[g].push_back(lane);
+        } else {
+            finish(slot, 0, 0);
+        }
+    }
+
+    // The groups of the next fixation boundary are assembled in next, and the two sets swap 
+    // roles, so lanes and distributions reuse their buffers across boundaries. 
+    Group groups[3];
+    Group next[3];
+    std::vector<std::pair<int, int>> sources[3];
+    for (int g = 0; g < 3; g++) {
+        int B = lanes[g].size();
+        groups[g].lanes = lanes[g];
+        groups[g].prStates.assign(numStates * B, 0);
+        groups[g].prStatesNew.resize(numStates * B);
+        groups[g].supportLo = biasState;
+        groups[g].supportHi = biasState;
+        for (int c = 0; c < B; c++) {
+            groups[g].prStates[biasState * B + c] = 1;
+        }
+    }
+
+    // Without decay the barriers are fixed, so every group propagates with one kernel and one 
+    // set of crossing CDFs throughout. 
+    PropagationCache &cache = *options.cache;
+    std::shared_ptr<const TransitionKernel> kernels[3];
+    std::shared_ptr<const CrossingCDFs> fixedCDFs[3];
+    for (int g = 0; g < 3; g++) {
+        kernels[g] = cache.getTransitionKernel(space, means[g], sigma, options.tailMass);
+        if (decay == 0) {
+            fixedCDFs[g] = cache.getCrossingCDFs(space, means[g], sigma, barrier, -barrier);
+        }
+    }
+    int time = 1;
+    while (!groups[0].lanes.empty() || !groups[1].lanes.empty() || !groups[2].lanes.empty()) {
+        float barrierUp = barrier / (1 + (decay * time));
+        float barrierDown = -barrier / (1 + (decay * time));
+        for (int g = 0; g < 3; g++) {
+            Group &group = groups[g];
+            int B = group.lanes.size();
+            if (B == 0) continue;
+            std::shared_ptr<const CrossingCDFs> cdfs = decay == 0 ? 
+                fixedCDFs[g] : 
+                cache.getCrossingCDFs(space, means[g], sigma, barrierUp, barrierDown);
+            group.probUpCrossing.resize(B);
+            group.probDownCrossing.resize(B);
+            propagateStep(
+                space, *kernels[g], cdfs->changeUpCDFs, cdfs->changeDownCDFs, 
+                barrierUp, barrierDown, group.prStates, group.prStatesNew, 
+                group.probUpCrossing.data(), group.probDownCrossing.data(), 
+                group.supportLo, group.supportHi, options.supportEpsilon, B);
+        }
+        time++;
+
+        // Regroup the lanes whose fixation ended and retire the trials that are done. 
+        bool regroup = false;
+        for (int g = 0; g < 3; g++) {
+            for (Lane &lane : groups[g].lanes) {
+                if (--lane.remainingSteps == 0) {
+                    regroup = true;
+                }
+            }
+        }
+        if (!regroup) continue;
+
+        for (int g = 0; g < 3; g++) {
+            next[g].lanes.clear();
+            sources[g].clear();
+        }
+        for (int g = 0; g < 3; g++) {
+            for (int c = 0; c < groups[g].lanes.size(); c++) {
+                Lane lane = groups[g].lanes[c];
+                int target = g;
+                if (lane.remainingSteps == 0) {
+                    if (!nextFixation(lane)) {
+                        finish(
+                            lane.slot, groups[g].probUpCrossing[c], 
+                            groups[g].probDownCrossing[c]);
+                        continue;
+                    }
+                    target = meanIndex(fixItem(lane));
+                }
+                next[target].lanes.push_back(lane);
+                sources[target].push_back({g, c});
+            }
+        }
+        for (int g = 0; g < 3; g++) {
+            int B = next[g].lanes.size();
+            next[g].prStates.assign(numStates * B, 0);
+            next[g].prStatesNew.resize(numStates * B);
+            next[g].supportLo = numStates - 1;
+            next[g].supportHi = 0;
+            for (int c = 0; c < B; c++) {
+                const Group &source = groups[sources[g][c].first];
+                int sourceB = source.lanes.size();
+                int sourceC = sources[g][c].second;
+                for (int i = source.supportLo; i <= source.supportHi; i++) {
+                    next[g].prStates[i * B + c] = source.prStates[i * sourceB + sourceC];
+                }
+                next[g].supportLo = std::min(next[g].supportLo, source.supportLo);
+                next[g].supportHi = std::max(next[g].supportHi, source.supportHi);
+            }
+        }
+        for (int g = 0; g < 3; g++) {
+            std::swap(groups[g], next[g]);
+        }
+    }
+}
+
+
+void aDDM::getPrefixSharedLikelihoods(
+    const TrialBatch &trials, const std::vector<int> &group, 
+    const StateSpace &space, const std::vector<int> &biasStates, int timeStep, 
+    const PropagationOptions &options, double *likelihoods) {
+
+    // Trials in a group share their values, so every fixation uses one of three drift means. 
+    int numStates = space.numStates;
+    int numColumns = biasStates.size();
+    int valueLeft = trials.valueLeft[group[0]];
+    int valueRight = trials.valueRight[group[0]];
+    float means[3] = {
+        0, 
+        d * ((valueLeft + k) - (theta * valueRight)), 
+        d * ((theta * valueLeft) - (valueRight + k))
+    };
+
+    // A trial only depends on its sequence of drift means, written as runs of (mean, steps). 
+    // The runs of every trial are inserted into a radix trie whose edges are runs; an edge is 
+    // split wherever two trials diverge, so each node has at most one child per drift mean. 
+    struct Node {
+        int mean;
+        int numSteps;
+        int children[3] = {-1, -1, -1};
+        std::vector<int> slots; // Slots of the trials whose last time step is reached here. 
+    };
+    std::vector<Node> nodes(1);
+    nodes[0].mean = 0;
+    nodes[0].numSteps = 0;
+    for (int slot = 0; slot < group.size(); slot++) {
+        size_t fixBegin = trials.fixOffsets[group[slot]];
+        size_t fixEnd = trials.fixOffsets[group[slot] + 1];
+        std::vector<std::pair<int, int>> runs;
+        for (size_t f = fixBegin; f < fixEnd; f++) {
+            int numSteps = trials.fixTime[f] / timeStep;
+            int mean = meanIndex(trials.fixItem[f]);
+            if (numSteps == 0) continue;
+            if (!runs.empty() && runs.back().first == mean) {
+                runs.back().second += numSteps;
+            } else {
+                runs.push_back({mean, numSteps});
+            }
+        }
+
+        int node = 0;
+        for (auto [mean, numSteps] : runs) {
+            while (numSteps > 0) {
+                int child = nodes[node].children[mean];
+                if (child == -1) {
+                    nodes.push_back(Node());
+                    nodes.back().mean = mean;
+                    nodes.back().numSteps = numSteps;
+                    child = nodes.size() - 1;
+                    nodes[node].children[mean] = child;
+                } else if (nodes[child].numSteps > numSteps) {
+                    // The trial leaves the edge part way along, so split it. 
+                    Node split;
+                    split.mean = mean;
+                    split.numSteps = numSteps;
+                    split.children[mean] = child;
+                    nodes[child].numSteps -= numSteps;
+                    nodes.push_back(split);
+                    child = nodes.size() - 1;
+                    nodes[node].children[mean] = child;
+                }
+                numSteps -= nodes[child].numSteps;
+                node = child;
+            }
+        }
+        nodes[node].slots.push_back(slot);
+    }
+
+    // Depth-first traversal. Each pending node carries the state of its parent, so the shared 
+    // prefix of the trials below a branch point is propagated once. 
+    struct Pending {
+        int node;
+        int time;
+        std::vector<double> prStates;
+        int supportLo;
+        int supportHi;
+    };
+    Pending root = {0, 1, std::vector<double>(numStates * numColumns, 0), numStates - 1, 0};
+    for (int c = 0; c < numColumns; c++) {
+        root.prStates[biasStates[c] * numColumns + c] = 1;
+        root.supportLo = std::min(root.supportLo, biasStates[c]);
+        root.supportHi = std::max(root.supportHi, biasStates[c]);
+    }
+    std::vector<Pending> stack;
+    stack.push_back(std::move(root));
+    std::vector<double> prStatesNew(numStates * numColumns);
+    std::vector<double> probUpCrossing(numColumns);
+    std::vector<double> probDownCrossing(numColumns);
+    while (!stack.empty()) {
+        Pending pending = std::move(stack.back());
+        stack.pop_back();
+        const Node &node = nodes[pending.node];
+
+        std::fill(probUpCrossing.begin(), probUpCrossing.end(), 0);
+        std::fill(probDownCrossing.begin(), probDownCrossing.end(), 0);
+        advanceFixation(
+            space, means[node.mean], node.numSteps, pending.time, options, 
+            pending.prStates, prStatesNew, probUpCrossing.data(), probDownCrossing.data(), 
+            pending.supportLo, pending.supportHi, numColumns);
+
+        for (int slot : node.slots) {
+            int choice = trials.choice[group[slot]];
+            for (int c = 0; c < numColumns; c++) {
+                double likelihood = 0;
+                if (choice == -1) {
+                    if (probUpCrossing[c] > 0) {
+                        likelihood = probUpCrossing[c];
+                    }
+                } else if (choice == 1) {
+                    if (probDownCrossing[c] > 0) {
+                        likelihood = probDownCrossing[c];
+                    }
+                }
+                if (likelihood == 0) {
+                    likelihood = pow(10, -20);
+                }
+                likelihoods[slot * numColumns + c] = likelihood;
+            }
+        }
+
+        // Snapshot the state for every child but the last, which takes it over. 
+        int lastChild = -1;
+        for (int m = 0; m < 3; m++) {
+            if (node.children[m] != -1) {
+                lastChild = m;
+            }
+        }
+        for (int m = 0; m < 3; m++) {
+            if (node.children[m] == -1) continue;
+            Pending child = {
+                node.children[m], pending.time, {}, pending.supportLo, pending.supportHi};
+            if (m == lastChild) {
+                child.prStates = std::move(pending.prStates);
+            } else {
+                child.prStates = pending.prStates;
+            }
+            stack.push_back(std::move(child));
+        }
+    }
+}
+
+
+void aDDM::getLaneLikelihoods(
+    const std::vector<aDDM> &block, const TrialBatch &trials, 
+    const std::vector<int> &batch, const StateSpace &space, int timeStep, 
+    const PropagationOptions &options, double *likelihoods) {
+
+    int numStates = space.numStates;
+    int B = block.size();
+    const aDDM &first = block[0];
+    int valueLeft = trials.valueLeft[batch[0]];
+    int valueRight = trials.valueRight[batch[0]];
+    PropagationCache &cache = *options.cache;
+
+    // Trials in a batch share their values, so one LaneKernel per drift mean index serves the 
+    // whole batch. The interleaved crossing CDFs are built on first use, once per drift mean 
+    // index, or once per drift mean index and time step if the barriers decay. 
+    std::vector<float> means(3 * B);
+    LaneKernel kernels[3];
+    std::vector<std::vector<double>> changeUpCDFs;
+    std::vector<std::vector<double>> changeDownCDFs;
+    std::vector<std::shared_ptr<const TransitionKernel>> laneKernels(B);
+    std::vector<const TransitionKernel *> kernelPtrs(B);
+    auto interleavedCDFs = [&](int g, int time, float barrierUp, float barrierDown) {
+        int key = first.decay == 0 ? g : time * 3 + g;
+        if (key >= changeUpCDFs.size()) {
+            changeUpCDFs.resize(key + 1);
+            changeDownCDFs.resize(key + 1);
+        }
+        if (changeUpCDFs[key].empty()) {
+            changeUpCDFs[key].resize(numStates * B);
+            changeDownCDFs[key].resize(numStates * B);
+            for (int c = 0; c < B; c++) {
+                std::shared_ptr<const CrossingCDFs> cdfs = cache.getCrossingCDFs(
+                    space, means[g * B + c], block[c].sigma, barrierUp, barrierDown);
+                for (int i = 0; i < numStates; i++) {
+                    changeUpCDFs[key][i * B + c] = cdfs->changeUpCDFs[i];
+                    changeDownCDFs[key][i * B + c] = cdfs->changeDownCDFs[i];
+                }
+            }
+        }
+        return key;
+    };
+    for (int g = 0; g < 3; g++) {
+        for (int c = 0; c < B; c++) {
+            const aDDM &model = block[c];
+            float mean = 0;
+            if (g == 1) {
+                mean = model.d * ((valueLeft + model.k) - (model.theta * valueRight));
+            } else if (g == 2) {
+                mean = model.d * ((model.theta * valueLeft) - (valueRight + model.k));
+            }
+            means[g * B + c] = mean;
+            laneKernels[c] = cache.getTransitionKernel(space, mean, model.sigma, options.tailMass);
+            kernelPtrs[c] = laneKernels[c].get();
+        }
+        kernels[g] = LaneKernel(kernelPtrs);
+    }
+
+    std::vector<double> prStates(numStates * B);
+    std::vector<double> prStatesNew(numStates * B);
+    std::vector<double> probUpCrossing(B);
+    std::vector<double> probDownCrossing(B);
+    for (int slot = 0; slot < batch.size(); slot++) {
+        int trialNum = batch[slot];
+        std::fill(prStates.begin(), prStates.end(), 0.0);
+        std::fill_n(prStates.begin() + space.biasState * B, B, 1.0);
+        int supportLo = space.biasState;
+        int supportHi = space.biasState;
+        std::fill(probUpCrossing.begin(), probUpCrossing.end(), 0.0);
+        std::fill(probDownCrossing.begin(), probDownCrossing.end(), 0.0);
+
+        int time = 1;
+        for (size_t f = trials.fixOffsets[trialNum]; f < trials.fixOffsets[trialNum + 1]; f++) {
+            int g = meanIndex(trials.fixItem[f]);
+            int numSteps = trials.fixTime[f] / timeStep;
+            for (int t = 0; t < numSteps; t++) {
+                float barrierUp = first.barrier / (1 + (first.decay * time));
+                float barrierDown = -first.barrier / (1 + (first.decay * time));
+                int key = interleavedCDFs(g, time, barrierUp, barrierDown);
+                propagateLanesStep(
+                    space, kernels[g], changeUpCDFs[key], changeDownCDFs[key], 
+                    barrierUp, barrierDown, prStates, prStatesNew, 
+                    probUpCrossing.data(), probDownCrossing.data(), 
+                    supportLo, supportHi, options.supportEpsilon);
+                time++;
+            }
+        }
+
+        int choice = trials.choice[trialNum];
+        for (int c = 0; c < B; c++) {
+            double likelihood = 0;
+            if (choice == -1) {
+                if (probUpCrossing[c] > 0) {
+                    likelihood = probUpCrossing[c];
+                }
+            } else if (choice == 1) {
+                if (probDownCrossing[c] > 0) {
+                    likelihood = probDownCrossing[c];
+                }
+            }
+            if (likelihood == 0) {
+                likelihood = pow(10, -20);
+            }
+            likelihoods[slot * B + c] = likelihood;
+        }
+    }
+}
+
+
+double aDDM::getTrialLikelihood(
+    const aDDMTrial &trial, int timeStep, float approxStateStep, PropagationOptions options) {
+
+    StateSpace space = StateSpace(barrier, approxStateStep, bias);
+    if (!options.cache) {
+        options.cache = std::make_shared<PropagationCache>();
+    }
+    if (trial.fixItem.size() != trial.fixTime.size()) {
+        throw std::invalid_argument(
+            "Every trial must have as many fixation times as fixation items.");
+    }
+    // The fixations are read in place from the trial. 
+    double likelihood;
+    getTrialLikelihoods(
+        trial.valueLeft, trial.valueRight, trial.choice, trial.fixItem.data(), 
+        trial.fixTime.data(), trial.fixItem.size(), space, {space.biasState}, timeStep, options, 
+        &likelihood);
+    return likelihood;
+}
+
+
+void aDDM::getTrialLikelihoodGradient(
+    int valueLeft, int valueRight, int choice, const int *fixItem, const int *fixTime, 
+    int fixLen, const StateSpace &space, int timeStep, const PropagationOptions &options, 
+    double *likelihood) {
+
+    // Column 0 holds the distribution and columns 1 to 4 its derivatives with respect to 
+    // (d, sigma, theta, k). 
+    const int numParams = 4;
+    const int B = numParams + 1;
+    int numStates = space.numStates;
+    std::vector<double> prStates(numStates * B, 0);
+    std::vector<double> prStatesNew(numStates * B);
+    prStates[space.biasState * B] = 1;
+    int supportLo = space.biasState;
+    int supportHi = space.biasState;
+    std::vector<double> probUpCrossing(B, 0);
+    std::vector<double> probDownCrossing(B, 0);
+
+    PropagationCache &cache = *options.cache;
+    const std::vector<double> sigmaSensitivities = {0, 1, 0, 0};
+    int time = 1;
+    float vLeft = valueLeft;
+    float vRight = valueRight;
+    for (int f = 0; f < fixLen; f++) {
+        int fItem = fixItem[f];
+        int numSteps = fixTime[f] / timeStep;
+        if (numSteps <= 0) {
+            continue;
+        }
+        float mean;
+        std::vector<double> meanSensitivities;
+        if (fItem == 1) {
+            mean = d * ((vLeft + k) - (theta * vRight));
+            meanSensitivities = {(vLeft + k) - theta * vRight, 0, -d * vRight, d};
+        } else if (fItem == 2) {
+            mean = d * ((theta * vLeft) - (vRight + k));
+            meanSensitivities = {theta * vLeft - (vRight + k), 0, d * vLeft, -d};
+        } else {
+            mean = 0;
+            meanSensitivities = {0, 0, 0, 0};
+        }
+
+        std::shared_ptr<const TransitionKernel> kernel = cache.getTransitionKernel(
+            space, mean, sigma, options.tailMass);
+        KernelDerivatives kernelDerivatives(space, *kernel, mean, sigma);
+        std::shared_ptr<const CrossingCDFs> cdfs;
+        std::unique_ptr<CrossingCDFDerivatives> cdfDerivatives;
+        if (decay == 0) {
+            cdfs = cache.getCrossingCDFs(space, mean, sigma, barrier, -barrier);
+            cdfDerivatives = std::make_unique<CrossingCDFDerivatives>(
+                space, mean, sigma, barrier, -barrier);
+        }
+        for (int t = 0; t < numSteps; t++) {
+            float barrierUp = barrier / (1 + (decay * time));
+            float barrierDown = -barrier / (1 + (decay * time));
+            if (decay != 0) {
+                cdfs = cache.getCrossingCDFs(space, mean, sigma, barrierUp, barrierDown);
+                cdfDerivatives = std::make_unique<CrossingCDFDerivatives>(
+                    space, mean, sigma, barrierUp, barrierDown);
+            }
+            propagateTangentStep(
+                space, *kernel, kernelDerivatives, *cdfs, *cdfDerivatives, 
+                meanSensitivities, sigmaSensitivities, barrierUp, barrierDown, 
+                prStates, prStatesNew, probUpCrossing.data(), probDownCrossing.data(), 
+                supportLo, supportHi);
+            time++;
+        }
+    }
+
+    const std::vector<double> &crossing = choice == -1 ? probUpCrossing : probDownCrossing;
+    if (choice != -1 && choice != 1) {
+        std::fill_n(likelihood, B, 0.0);
+    } else {
+        std::copy_n(crossing.begin(), B, likelihood);
+    }
+    // Clamped likelihoods do not depend on the parameters. 
+    if (likelihood[0] <= 0) {
+        likelihood[0] = pow(10, -20);
+        std::fill_n(likelihood + 1, numParams, 0.0);
+    }
+}
+
+
+NLLGradient aDDM::computeCPUNLLGradient(
+    const std::vector<aDDMTrial> &trials, int timeStep, float approxStateStep, int numThreads, 
+    PropagationOptions options) {
+
+    return computeCPUNLLGradient(
+        TrialBatch(trials), timeStep, approxStateStep, numThreads, options);
+}
+
+
+NLLGradient aDDM::computeCPUNLLGradient(
+    const TrialBatch &trials, int timeStep, float approxStateStep, int numThreads, 
+    PropagationOptions options) {
+
+    int numTrials = trials.size();
+    StateSpace space = StateSpace(barrier, approxStateStep, bias);
+    if (!options.cache) {
+        options.cache = std::make_shared<PropagationCache>();
+    }
+
+    // likelihoods[trialNum * 5 + c] holds the likelihood (c = 0) and its derivatives. 
+    std::vector<double> likelihoods(numTrials * 5);
+    parallelFor(numTrials, numThreads, [&](int trialNum) {
+        size_t offset = trials.fixOffsets[trialNum];
+        getTrialLikelihoodGradient(
+            trials.valueLeft[trialNum], trials.valueRight[trialNum], trials.choice[trialNum], 
+            trials.fixItem.data() + offset, trials.fixTime.data() + offset, 
+            trials.fixOffsets[trialNum + 1] - offset, space, timeStep, options, 
+            &likelihoods[trialNum * 5]);
+    });
+
+    // d(-log L) = -dL / L, summed in trial order. The last entry is the bias. 
+    NLLGradient result;
+    result.gradient.assign(5, 0);
+    for (int i = 0; i < numTrials; i++) {
+        const double *L = &likelihoods[i * 5];
+        result.NLL += -log(L[0]);
+        for (int c = 1; c < 5; c++) {
+            result.gradient[c - 1] -= L[c] / L[0];
+        }
+    }
+    return result;
+}
+
+
+ProbabilityData aDDM::computeCPUNLL(
+    const std::vector<aDDMTrial> &trials, int trialsPerThread, int timeStep, float approxStateStep, 
+    int numThreads, PropagationOptions options) {
+
+    return computeCPUNLL(
+        TrialBatch(trials), trialsPerThread, timeStep, approxStateStep, numThreads, options);
+}
+
+
+std::vector<ProbabilityData> aDDM::computeCPUNLL(
+    const std::vector<aDDMTrial> &trials, const std::vector<float> &biases, 
+    int trialsPerThread, int timeStep, float approxStateStep, int numThreads, 
+    PropagationOptions options) {
+
+    return computeCPUNLL(
+        TrialBatch(trials), biases, trialsPerThread, timeStep, approxStateStep, numThreads, 
+        options);
+}
+
+
+ProbabilityData aDDM::computeCPUNLL(
+    const TrialBatch &trials, int trialsPerThread, int timeStep, float approxStateStep, 
+    int numThreads, PropagationOptions options) {
+
+    return computeCPUNLL(
+        trials, std::vector<float>{bias}, trialsPerThread, timeStep, approxStateStep, 
+        numThreads, options)[0];
+}
+
+
+std::vector<ProbabilityData> aDDM::computeCPUNLL(
+    const TrialBatch &trials, const std::vector<float> &biases, 
+    int trialsPerThread, int timeStep, float approxStateStep, int numThreads, 
+    PropagationOptions options) {
+
+    int numTrials = trials.size();
+    int numBiases = biases.size();
+    std::vector<double> likelihoods((size_t) numTrials * numBiases);
+    computeCPULikelihoods(
+        trials, 0, numTrials, biases, likelihoods.data(), trialsPerThread, timeStep, 
+        approxStateStep, numThreads, options);
+    return collectProbabilityData(likelihoods, numTrials, numBiases);
+}
+
+
+void aDDM::computeCPULikelihoods(
+    const TrialBatch &trials, size_t begin, size_t end, const std::vector<float> &biases, 
+    double *likelihoods, int trialsPerThread, int timeStep, float approxStateStep, 
+    int numThreads, PropagationOptions options) {
+
+    if (trialsPerThread <= 0) {
+        throw std::invalid_argument("trialsPerThread must be positive.");
+    }
+    if (biases.empty()) {
+        throw std::invalid_argument("biases must not be empty.");
+    }
+    int numTrials = end - begin;
+    int numBiases = biases.size();
+    StateSpace space = StateSpace(barrier, approxStateStep, bias);
+    std::vector<int> biasStates;
+    for (float b : biases) {
+        biasStates.push_back(StateSpace(barrier, approxStateStep, b).biasState);
+    }
+    if (!options.cache) {
+        options.cache = std::make_shared<PropagationCache>();
+    }
+
+    // likelihoods[(trialNum - begin) * numBiases + b]
+    if (options.lockstep) {
+        std::vector<std::vector<int>> batches;
+        // Trials with the same values share their three drift means. Each batch holds up to 
+        // trialsPerThread of them. 
+        std::map<std::pair<int, int>, std::vector<int>> valueGroups;
+        for (size_t i = begin; i < end; i++) {
+            valueGroups[{trials.valueLeft[i], trials.valueRight[i]}].push_back(i);
+        }
+        for (const auto &group : valueGroups) {
+            for (int first = 0; first < group.second.size(); first += trialsPerThread) {
+                int last = std::min((int) group.second.size(), first + trialsPerThread);
+                batches.push_back(std::vector<int>(
+                    group.second.begin() + first, group.second.begin() + last));
+            }
+        }
+        parallelFor(batches.size(), numThreads, [&](int b) {
+            std::vector<double> batchLikelihoods(batches[b].size());
+            for (int bias = 0; bias < numBiases; bias++) {
+                getLockstepLikelihoods(
+                    trials, batches[b], space, biasStates[bias], timeStep, options, 
+                    batchLikelihoods.data());
+                for (int slot = 0; slot < batches[b].size(); slot++) {
+                    likelihoods[(batches[b][slot] - begin) * numBiases + bias] = 
+                        batchLikelihoods[slot];
+                }
+            }
+        });
+        return;
+    }
+
+    if (options.prefixSharing) {
+        // Only trials with the same values can share propagation. 
+        std::map<std::pair<int, int>, std::vector<int>> valueGroups;
+        for (size_t i = begin; i < end; i++) {
+            valueGroups[{trials.valueLeft[i], trials.valueRight[i]}].push_back(i);
+        }
+        std::vector<std::vector<int>> groups;
+        for (auto &group : valueGroups) {
+            groups.push_back(std::move(group.second));
+        }
+        parallelFor(groups.size(), numThreads, [&](int g) {
+            std::vector<double> groupLikelihoods(groups[g].size() * numBiases);
+            getPrefixSharedLikelihoods(
+                trials, groups[g], space, biasStates, timeStep, options, 
+                groupLikelihoods.data());
+            for (int slot = 0; slot < groups[g].size(); slot++) {
+                std::copy_n(
+                    &groupLikelihoods[slot * numBiases], numBiases, 
+                    &likelihoods[(groups[g][slot] - begin) * numBiases]);
+            }
+        });
+        return;
+    }
+
+    // Round up so that a final, partially filled chunk picks up any remaining trials. 
+    int numChunks = (numTrials + trialsPerThread - 1) / trialsPerThread;
+    parallelFor(numChunks, numThreads, [&](int chunk) {
+        int last = std::min(numTrials, (chunk + 1) * trialsPerThread);
+        for (int i = chunk * trialsPerThread; i < last; i++) {
+            getTrialLikelihoods(
+                trials, begin + i, space, biasStates, timeStep, options, 
+                &likelihoods[(size_t) i * numBiases]);
+        }
+    });
+}
+
+std::vector<ProbabilityData> aDDM::computeCPUNLLs(
+    const std::vector<aDDM> &models, const std::vector<aDDMTrial> &trials, 
+    int trialsPerThread, int timeStep, float approxStateStep, int numThreads, 
+    int modelsPerBlock, PropagationOptions options) {
+
+    return computeCPUNLLs(
+        models, TrialBatch(trials), trialsPerThread, timeStep, approxStateStep, numThreads, 
+        modelsPerBlock, options);
+}
+
+
+std::vector<ProbabilityData> aDDM::computeCPUNLLs(
+    const std::vector<aDDM> &models, const TrialBatch &batch, 
+    int trialsPerThread, int timeStep, float approxStateStep, int numThreads, 
+    int modelsPerBlock, PropagationOptions options) {
+
+    if (models.empty()) {
+        throw std::invalid_argument("models must not be empty.");
+    }
+    if (trialsPerThread <= 0) {
+        throw std::invalid_argument("trialsPerThread must be positive.");
+    }
+    if (modelsPerBlock <= 0) {
+        throw std::invalid_argument("modelsPerBlock must be positive.");
+    }
+    for (const aDDM &model : models) {
+        if (model.barrier != models[0].barrier || model.decay != models[0].decay || 
+            model.bias != models[0].bias) {
+            throw std::invalid_argument(
+                "All models must share the same barrier, decay and bias.");
+        }
+    }
+    int numModels = models.size();
+    int numTrials = batch.size();
+    StateSpace space = StateSpace(models[0].barrier, approxStateStep, models[0].bias);
+    if (!options.cache) {
+        options.cache = std::make_shared<PropagationCache>();
+    }
+
+    std::vector<std::vector<aDDM>> blocks;
+    for (int begin = 0; begin < numModels; begin += modelsPerBlock) {
+        int end = std::min(numModels, begin + modelsPerBlock);
+        blocks.push_back(std::vector<aDDM>(models.begin() + begin, models.begin() + end));
+    }
+    // Batches of up to trialsPerThread trials with the same values, as in lockstep mode. 
+    std::vector<std::vector<int>> batches;
+    std::map<std::pair<int, int>, std::vector<int>> valueGroups;
+    for (int i = 0; i < numTrials; i++) {
+        valueGroups[{batch.valueLeft[i], batch.valueRight[i]}].push_back(i);
+    }
+    for (const auto &group : valueGroups) {
+        for (int begin = 0; begin < group.second.size(); begin += trialsPerThread) {
+            int end = std::min((int) group.second.size(), begin + trialsPerThread);
+            batches.push_back(std::vector<int>(
+                group.second.begin() + begin, group.second.begin() + end));
+        }
+    }
+
+    // likelihoods[trialNum * numModels + m]. Each task computes one batch for one block. 
+    std::vector<double> likelihoods(numTrials * numModels);
+    int numBatches = batches.size();
+    parallelFor(blocks.size() * numBatches, numThreads, [&](int task) {
+        int b = task / numBatches;
+        const std::vector<int> &trialNums = batches[task % numBatches];
+        int B = blocks[b].size();
+        std::vector<double> laneLikelihoods(trialNums.size() * B);
+        getLaneLikelihoods(
+            blocks[b], batch, trialNums, space, timeStep, options, laneLikelihoods.data());
+        for (int slot = 0; slot < trialNums.size(); slot++) {
+            std::copy_n(
+                &laneLikelihoods[slot * B], B, 
+                &likelihoods[trialNums[slot] * numModels + b * modelsPerBlock]);
+        }
+    });
+
+    return collectProbabilityData(likelihoods, numTrials, numModels);
+}
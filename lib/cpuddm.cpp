@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "ddm.h"
+#include "propagation.h"
+#include "trial_batch.h"
+#include "util.h"
+
+
+void DDM::getCrossingProbabilities(
+    int valDiff, int numTimeSteps, const StateSpace &space, const std::vector<int> &biasStates, 
+    int timeStep, const PropagationOptions &options, 
+    std::vector<double> &probUpCrossing, std::vector<double> &probDownCrossing) {
+
+    int numStates = space.numStates;
+    int numColumns = biasStates.size();
+    probUpCrossing.assign(std::max(numTimeSteps, 1) * numColumns, 0);
+    probDownCrossing.assign(std::max(numTimeSteps, 1) * numColumns, 0);
+
+    // One column per initial state, interleaved as prStates[i * numColumns + c]. 
+    std::vector<double> prStates(numStates * numColumns, 0);
+    std::vector<double> prStatesNew(numStates * numColumns);
+    int supportLo = numStates - 1;
+    int supportHi = 0;
+    for (int c = 0; c < numColumns; c++) {
+        prStates[biasStates[c] * numColumns + c] = 1;
+        supportLo = std::min(supportLo, biasStates[c]);
+        supportHi = std::max(supportHi, biasStates[c]);
+    }
+
+    PropagationCache &cache = *options.cache;
+    std::shared_ptr<const TransitionKernel> kernel;
+    std::shared_ptr<const CrossingCDFs> cdfs;
+    // With decay, the CDFs of every step from decayingBegin to decayingEnd, which share a drift 
+    // mean, are fetched together. 
+    std::vector<std::shared_ptr<const CrossingCDFs>> decayingCDFs;
+    int decayingBegin = 1;
+    int decayingEnd = 1;
+
+    int numNDTSteps = nonDecisionTime / timeStep;
+    int elapsedNDT = 0;
+    float prevMean = 0;
+    for (int time = 1; time < numTimeSteps; time++) {
+        float mean;
+        if (elapsedNDT < numNDTSteps) {
+            mean = 0;
+            elapsedNDT += 1;
+        } else {
+            mean = d * valDiff;
+        }
+
+        if (mean != prevMean || time == 1) {
+            kernel = cache.getTransitionKernel(space, mean, sigma, options.tailMass);
+        }
+        float barrierUp = barrier / (1 + (decay * time));
+        float barrierDown = -barrier / (1 + (decay * time));
+        if (decay != 0) {
+            if (time == decayingEnd) {
+                decayingBegin = time;
+                decayingEnd = time <= numNDTSteps ? 
+                    std::min(numNDTSteps + 1, numTimeSteps) : numTimeSteps;
+                decayingCDFs = cache.getDecayingCrossingCDFs(
+                    space, mean, sigma, barrier, decay, time, decayingEnd - time);
+            }
+            cdfs = decayingCDFs[time - decayingBegin];
+        } else if (mean != prevMean || time == 1) {
+            cdfs = cache.getCrossingCDFs(space, mean, sigma, barrierUp, barrierDown);
+        }
+
+        propagateStep(
+            space, *kernel, cdfs->changeUpCDFs, cdfs->changeDownCDFs, 
+            barrierUp, barrierDown, prStates, prStatesNew, 
+            &probUpCrossing[time * numColumns], &probDownCrossing[time * numColumns], 
+            supportLo, supportHi, options.supportEpsilon, numColumns);
+
+        prevMean = mean;
+    }
+}
+
+
+/**
+ * @brief Read the likelihood of a trial, given by its RT and choice, off the crossing 
+ * probabilities of its value difference. The crossing probabilities hold numColumns interleaved 
+ * columns, of which column is read. 
+ */
+static double lookupLikelihood(
+    int RT, int choice, int timeStep, 
+    const std::vector<double> &probUpCrossing, const std::vector<double> &probDownCrossing, 
+    int numColumns=1, int column=0) {
+
+    int numTimeSteps = RT / timeStep;
+    int idx = (numTimeSteps - 1) * numColumns + column;
+    double likelihood = 0;
+    if (numTimeSteps > 0) {
+        if (choice == -1) {
+            if (probUpCrossing[idx] > 0) {
+                likelihood = probUpCrossing[idx];
+            }
+        } else if (choice == 1) {
+            if (probDownCrossing[idx] > 0) {
+                likelihood = probDownCrossing[idx];
+            }
+        }
+    }
+    if (likelihood == 0) {
+        likelihood = pow(10, -20);
+    }
+    return likelihood;
+}
+
+
+double DDM::getTrialLikelihood(
+    const DDMTrial &trial, int timeStep, float approxStateStep, PropagationOptions options) {
+
+    StateSpace space = StateSpace(barrier, approxStateStep, bias);
+    if (!options.cache) {
+        options.cache = std::make_shared<PropagationCache>();
+    }
+    std::vector<double> probUpCrossing;
+    std::vector<double> probDownCrossing;
+    getCrossingProbabilities(
+        trial.valueLeft - trial.valueRight, trial.RT / timeStep, space, {space.biasState}, 
+        timeStep, options, probUpCrossing, probDownCrossing);
+    return lookupLikelihood(trial.RT, trial.choice, timeStep, probUpCrossing, probDownCrossing);
+}
+
+
+ProbabilityData DDM::computeCPUNLL(
+    const std::vector<DDMTrial> &trials, int timeStep, float approxStateStep, int numThreads, 
+    PropagationOptions options) {
+
+    return computeCPUNLL(TrialBatch(trials), timeStep, approxStateStep, numThreads, options);
+}
+
+
+std::vector<ProbabilityData> DDM::computeCPUNLL(
+    const std::vector<DDMTrial> &trials, const std::vector<float> &biases, int timeStep, 
+    float approxStateStep, int numThreads, PropagationOptions options) {
+
+    return computeCPUNLL(
+        TrialBatch(trials), biases, timeStep, approxStateStep, numThreads, options);
+}
+
+
+ProbabilityData DDM::computeCPUNLL(
+    const TrialBatch &trials, int timeStep, float approxStateStep, int numThreads, 
+    PropagationOptions options) {
+
+    return computeCPUNLL(
+        trials, std::vector<float>{bias}, timeStep, approxStateStep, numThreads, options)[0];
+}
+
+
+std::vector<ProbabilityData> DDM::computeCPUNLL(
+    const TrialBatch &trials, const std::vector<float> &biases, int timeStep, 
+    float approxStateStep, int numThreads, PropagationOptions options) {
+
+    int numTrials = trials.size();
+    int numBiases = biases.size();
+    // likelihoods[trialNum * numBiases + b]
+    std::vector<double> likelihoods((size_t) numTrials * numBiases);
+    computeCPULikelihoods(
+        trials, 0, numTrials, biases, likelihoods.data(), timeStep, approxStateStep, numThreads, 
+        options);
+
+    std::vector<ProbabilityData> data;
+    for (int b = 0; b < numBiases; b++) {
+        double NLL = 0;
+        double likelihood = 0;
+        std::vector<double> trialLikelihoods(numTrials);
+        for (int i = 0; i < numTrials; i++) {
+            trialLikelihoods[i] = likelihoods[i * numBiases + b];
+            likelihood += trialLikelihoods[i];
+            NLL += -log(trialLikelihoods[i]);
+        }
+        data.push_back(ProbabilityData(likelihood, NLL));
+        data.back().trialLikelihoods = std::move(trialLikelihoods);
+    }
+    return data;
+}
+
+
+void DDM::computeCPULikelihoods(
+    const TrialBatch &trials, size_t begin, size_t end, const std::vector<float> &biases, 
+    double *likelihoods, int timeStep, float approxStateStep, int numThreads, 
+    PropagationOptions options) {
+
+    if (biases.empty()) {
+        throw std::invalid_argument("biases must not be empty.");
+    }
+    int numBiases = biases.size();
+    StateSpace space = StateSpace(barrier, approxStateStep, bias);
+    std::vector<int> biasStates;
+    for (float b : biases) {
+        biasStates.push_back(StateSpace(barrier, approxStateStep, b).biasState);
+    }
+    if (!options.cache) {
+        options.cache = std::make_shared<PropagationCache>();
+    }
+
+    // valDiff -> indices of the trials with that value difference
+    std::map<int, std::vector<int>> groups;
+    for (size_t i = begin; i < end; i++) {
+        groups[trials.valueLeft[i] - trials.valueRight[i]].push_back(i);
+    }
+    std::vector<std::pair<int, std::vector<int>>> groupList(groups.begin(), groups.end());
+
+    // likelihoods[(trialNum - begin) * numBiases + b]
+    parallelFor(groupList.size(), numThreads, [&](int g) {
+        int valDiff = groupList[g].first;
+        const std::vector<int> &members = groupList[g].second;
+        int maxTimeSteps = 0;
+        for (int i : members) {
+            maxTimeSteps = std::max(maxTimeSteps, trials.RT[i] / timeStep);
+        }
+        std::vector<double> probUpCrossing;
+        std::vector<double> probDownCrossing;
+        getCrossingProbabilities(
+            valDiff, maxTimeSteps, space, biasStates, timeStep, options, 
+            probUpCrossing, probDownCrossing);
+        for (int i : members) {
+            for (int b = 0; b < numBiases; b++) {
+                likelihoods[(i - begin) * numBiases + b] = lookupLikelihood(
+                    trials.RT[i], trials.choice[i], timeStep, probUpCrossing, probDownCrossing, 
+                    numBiases, b);
+            }
+        }
+    });
+}
@@ -4,6 +4,7 @@
 #include "addm.h"
 #include "ddm.h"
 #include "cuda_util.cuh"
+#include "trial_batch.h"
 #include "util.h"
 
 
@@ -15,13 +16,12 @@ void getTrialLikelihoodKernel(
     int *choices, 
     int *valLs, 
     int *valRs, 
-    int *FixItemsMatrix, 
-    int *FixTimeMatrix, 
-    int *FixLens, 
+    uint64_t *fixOffsets, 
+    int *fixItems, 
+    int *fixTimes, 
     double *likelihoods, 
     int numTrials, 
     float *states, 
-    int maxFixLen, 
     int biasState, 
     int numStates,
     float stateStep,
@@ -29,38 +29,34 @@ void getTrialLikelihoodKernel(
     float sigma, 
     float theta, 
     float k, 
-    int barrier, 
+    float barrier, 
     int nonDecisionTime, 
     int timeStep, 
     float approxStateStep, 
     float dec,
+    float kernelHalfWidth, 
+    double supportEpsilon, 
     double *prStates, 
     double* prStatesNew) {
 
     int tid = blockIdx.x * blockDim.x + threadIdx.x; 
-    if (tid < numTrials / trialsPerThread) {
-        float *probDistChangeMatrix = new float[numStates * numStates];
+    // Round up so that the last thread picks up any trials left over by the division. 
+    int numThreads = (numTrials + trialsPerThread - 1) / trialsPerThread; 
+    if (tid < numThreads) {
+        float *transitionKernel = new float[2 * numStates - 1];
         float *changeUpCDFs = new float[numStates];
         float *changeDownCDFs = new float[numStates];
-        float *changeMatrix = new float[numStates * numStates];
-        for (int trialNum = tid * trialsPerThread; trialNum < (tid + 1) * trialsPerThread; trialNum++) {
+        int lastTrial = min((tid + 1) * trialsPerThread, numTrials); 
+        for (int trialNum = tid * trialsPerThread; trialNum < lastTrial; trialNum++) {
             
             int choice = choices[trialNum];
             int RT = RTs[trialNum];
             int valLeft = valLs[trialNum];
             int valRight = valRs[trialNum];
-            int fixLen = FixLens[trialNum];
-
-            int *fixItem = new int[fixLen];
-            int *fixTime = new int[fixLen];
-
-            int f_idx = 0; 
-            #pragma unroll 4
-            for (int i = trialNum * maxFixLen; i < trialNum * maxFixLen + fixLen; i++) {
-                fixItem[f_idx] = FixItemsMatrix[i];
-                fixTime[f_idx] = FixTimeMatrix[i];
-                f_idx++; 
-            }
+            // The fixations of the trial are read in place from the CSR columns. 
+            int fixLen = fixOffsets[trialNum + 1] - fixOffsets[trialNum];
+            const int *fixItem = &fixItems[fixOffsets[trialNum]];
+            const int *fixTime = &fixTimes[fixOffsets[trialNum]];
 
             if (debug) {
                 printf("%i %i %i %i\n", choice, RT, valLeft - valRight, fixLen);
@@ -106,13 +102,8 @@ void getTrialLikelihoodKernel(
             }
 
             int time = 1;
-            #pragma unroll 4
-            for (int i = 0; i < numStates; i++) {
-                #pragma unroll 4
-                for (int j = 0; j < numStates; j++) {
-                    changeMatrix[__RC2IDX(i, j, numStates)] = states[i] - states[j];
-                }
-            }
+            int supportLo = biasState; 
+            int supportHi = biasState; 
 
             float *changeUp = new float[numStates * numTimeSteps];
             #pragma unroll 4
@@ -149,22 +140,16 @@ void getTrialLikelihoodKernel(
                     mean = 0; 
                 }
 
-                #pragma unroll 4
-                for (int i = 0; i < numStates; i++) {
-                    #pragma unroll 4
-                    for (int j = 0; j < numStates; j++) {
-                        float x = changeMatrix[__RC2IDX(i, j, numStates)];
-                        probDistChangeMatrix[__RC2IDX(i, j, numStates)] = __pdf(x, mean, sigma);
-                    }
-                }
+                int kernelLo, kernelHi; 
+                __fillTransitionKernel(
+                    transitionKernel, &kernelLo, &kernelHi, numStates, stateStep, 
+                    mean, sigma, kernelHalfWidth);
                 if (debug) {
-                    printf("PDCM\n");
-                    for (int i = 0; i < numStates * numStates; i++) {
-                        printf("%f ", probDistChangeMatrix[i]);
-                        if ((i + 1) % numStates == 0) {
-                            printf("\n");
-                        }
+                    printf("transition kernel [%i, %i]\n", kernelLo, kernelHi);
+                    for (int m = kernelLo; m <= kernelHi; m++) {
+                        printf("%f ", transitionKernel[m - kernelLo]);
                     }
+                    printf("\n");
                 }
 
                 double tempUpCross; 
@@ -183,12 +168,18 @@ void getTrialLikelihoodKernel(
                 }
 
                 for (int t = 0; t < fTime / timeStep; t++) {
+                    // Only states reachable from the support of prStates can receive mass. 
+                    int newLo = max(0, supportLo + kernelLo); 
+                    int newHi = min(numStates - 1, supportHi + kernelHi); 
                     double rowSum; 
                     for (int i = 0; i < numStates; i++) {
-                        rowSum = 0; 
-                        for (int j = 0; j < numStates; j++) {
-                            rowSum += stateStep * probDistChangeMatrix[__RC2IDX(i, j, numStates)] * prStates[__RC2IDX(trialNum, j, numStates)];
+                        if (i < newLo || i > newHi) {
+                            prStatesNew[__RC2IDX(trialNum, i, numStates)] = 0; 
+                            continue; 
                         }
+                        rowSum = stateStep * __applyTransitionKernel(
+                            transitionKernel, kernelLo, kernelHi, 
+                            &prStates[__RC2IDX(trialNum, 0, numStates)], i, numStates);
                         prStatesNew[__RC2IDX(trialNum, i, numStates)] = (states[i] > barrierUp[time] || states[i] < barrierDown[time]) ? 0 : rowSum;
                     }
 
@@ -222,20 +213,21 @@ void getTrialLikelihoodKernel(
                     }
 
                     tempUpCross = 0; 
-                    for (int i = 0; i < numStates; i++) {
+                    for (int i = supportLo; i <= supportHi; i++) {
                         tempUpCross += changeUpCDFs[i] * prStates[__RC2IDX(trialNum, i, numStates)];
                     }     
                     tempDownCross = 0; 
-                    for (int i = 0; i < numStates; i++) {
+                    for (int i = supportLo; i <= supportHi; i++) {
                         tempDownCross += changeDownCDFs[i] * prStates[__RC2IDX(trialNum, i, numStates)];
                     }     
 
                     double sumIn = 0; 
                     double sumCurrent = tempUpCross + tempDownCross; 
 
-                    #pragma unroll 4
-                    for (int i = 0; i < numStates; i++) {
+                    for (int i = supportLo; i <= supportHi; i++) {
                         sumIn += prStates[__RC2IDX(trialNum, i, numStates)];
+                    }
+                    for (int i = newLo; i <= newHi; i++) {
                         sumCurrent += prStatesNew[__RC2IDX(trialNum, i, numStates)];
                     }
                     double normFactor = sumIn / sumCurrent; 
@@ -245,6 +237,12 @@ void getTrialLikelihoodKernel(
                         prStates[__RC2IDX(trialNum, i, numStates)] = prStatesNew[__RC2IDX(trialNum, i, numStates)] * normFactor; 
                     }
 
+                    supportLo = newLo; 
+                    supportHi = newHi; 
+                    __trimSupport(
+                        &prStates[__RC2IDX(trialNum, 0, numStates)], &supportLo, &supportHi, 
+                        supportEpsilon);
+
                     probUpCrossing[time] = tempUpCross * normFactor; 
                     probDownCrossing[time] = tempDownCross * normFactor;
 
@@ -263,8 +261,6 @@ void getTrialLikelihoodKernel(
                 }
             }
 
-            delete[] fixItem; 
-            delete[] fixTime; 
             delete[] barrierUp;
             delete[] barrierDown;
             delete[] probUpCrossing;
@@ -278,8 +274,7 @@ void getTrialLikelihoodKernel(
             likelihoods[trialNum] = likelihood;            
         }
  
-        delete[] changeMatrix; 
-        delete[] probDistChangeMatrix;
+        delete[] transitionKernel;
         delete[] changeUpCDFs;
         delete[] changeDownCDFs;
     }
@@ -290,9 +285,8 @@ void aDDM::callGetTrialLikelihoodKernel(
     int trialsPerThread,
     int numBlocks,
     int threadsPerBlock, 
-    aDDMTrial *trials, 
+    const TrialBatch &trials, 
     double *likelihoods, 
-    int numTrials, 
     float d, 
     float sigma, 
     float theta, 
@@ -304,75 +298,29 @@ void aDDM::callGetTrialLikelihoodKernel(
     float decay
 ) {
     bool debug = false; 
-    
-    int *h_fixLens = new int[numTrials];
-    int maxFixLen = 0; 
-    for (int i = 0; i < numTrials; i++) {
-        aDDMTrial trial = trials[i];
-        assert(trial.fixItem.size() == trial.fixTime.size());
-        int fixLen = trial.fixItem.size();
-        if (fixLen > maxFixLen) {
-            maxFixLen = fixLen;
-        }
-        h_fixLens[i] = fixLen; 
-    }
-
-    if (debug) std::cout << "max fix len " << maxFixLen << std::endl; 
-
-
-    int *h_FIs = new int[numTrials * maxFixLen];
-    int *h_FTs = new int[numTrials * maxFixLen];
-    for (int i = 0; i < numTrials; i++) {
-        for (int j = 0; j < maxFixLen; j++) {
-            aDDMTrial trial = trials[i];
-            if (j < trial.fixItem.size()) {
-                h_FIs[__RC2IDX(i, j, maxFixLen)] = trial.fixItem[j]; 
-                h_FTs[__RC2IDX(i, j, maxFixLen)] = trial.fixTime[j]; 
-            } else {
-                h_FIs[__RC2IDX(i, j, maxFixLen)] = -1; 
-                h_FTs[__RC2IDX(i, j, maxFixLen)] = -1; 
-            }
-        }
-    }
-
-    if (debug) {
-        for (int i = 0; i < numTrials; i++) {
-            std::cout << "[" << h_fixLens[i] << "] ";
-            for (int j = 0; j < maxFixLen; j++) {
-                std::cout << h_FIs[__RC2IDX(i, j, maxFixLen)] << " ";  
-            }
-            std::cout << std::endl;
-        }
-    }
-
-    int *h_VLs = new int[numTrials];
-    int *h_VRs = new int[numTrials];
-    int *h_RTs = new int[numTrials];
-    int *h_choices = new int[numTrials];
-    for (int i = 0; i < numTrials; i++) {
-        aDDMTrial trial = trials[i];
-        h_VLs[i] = trial.valueLeft; 
-        h_VRs[i] = trial.valueRight; 
-        h_RTs[i] = trial.RT;
-        h_choices[i] = trial.choice; 
-    }
+    int numTrials = trials.size();
+    size_t numFixations = trials.numFixations();
 
-    int *d_RTs, *d_choices, *d_VLs, *d_VRs, *d_FIs, *d_FTs, *d_FixLens;
+    // The columns of the batch are uploaded as they are, without padding or repacking. 
+    int *d_RTs, *d_choices, *d_VLs, *d_VRs, *d_FIs, *d_FTs;
+    uint64_t *d_fixOffsets;
     cudaMalloc((void **) &d_RTs, numTrials * sizeof(int));
     cudaMalloc((void **) &d_choices, numTrials * sizeof(int));
     cudaMalloc((void **) &d_VLs, numTrials * sizeof(int));
     cudaMalloc((void **) &d_VRs, numTrials * sizeof(int));
-    cudaMalloc((void **) &d_FIs, numTrials * maxFixLen * sizeof(int));
-    cudaMalloc((void **) &d_FTs, numTrials * maxFixLen * sizeof(int)); 
-    cudaMalloc((void **) &d_FixLens, numTrials * sizeof(int));
-
-    cudaMemcpy(d_RTs, h_RTs, numTrials * sizeof(int), cudaMemcpyHostToDevice);
-    cudaMemcpy(d_choices, h_choices, numTrials * sizeof(int), cudaMemcpyHostToDevice);
-    cudaMemcpy(d_VLs, h_VLs, numTrials * sizeof(int), cudaMemcpyHostToDevice);
-    cudaMemcpy(d_VRs, h_VRs, numTrials * sizeof(int), cudaMemcpyHostToDevice);
-    cudaMemcpy(d_FIs, h_FIs, numTrials * maxFixLen * sizeof(int), cudaMemcpyHostToDevice);
-    cudaMemcpy(d_FTs, h_FTs, numTrials * maxFixLen * sizeof(int), cudaMemcpyHostToDevice);
-    cudaMemcpy(d_FixLens, h_fixLens, numTrials * sizeof(int), cudaMemcpyHostToDevice);
+    cudaMalloc((void **) &d_fixOffsets, (numTrials + 1) * sizeof(uint64_t));
+    cudaMalloc((void **) &d_FIs, numFixations * sizeof(int));
+    cudaMalloc((void **) &d_FTs, numFixations * sizeof(int)); 
+
+    cudaMemcpy(d_RTs, trials.RT.data(), numTrials * sizeof(int), cudaMemcpyHostToDevice);
+    cudaMemcpy(d_choices, trials.choice.data(), numTrials * sizeof(int), cudaMemcpyHostToDevice);
+    cudaMemcpy(d_VLs, trials.valueLeft.data(), numTrials * sizeof(int), cudaMemcpyHostToDevice);
+    cudaMemcpy(d_VRs, trials.valueRight.data(), numTrials * sizeof(int), cudaMemcpyHostToDevice);
+    cudaMemcpy(
+        d_fixOffsets, trials.fixOffsets.data(), (numTrials + 1) * sizeof(uint64_t), 
+        cudaMemcpyHostToDevice);
+    cudaMemcpy(d_FIs, trials.fixItem.data(), numFixations * sizeof(int), cudaMemcpyHostToDevice);
+    cudaMemcpy(d_FTs, trials.fixTime.data(), numFixations * sizeof(int), cudaMemcpyHostToDevice);
 
     int halfNumStateBins = ceil(barrier / approxStateStep); 
     if (debug) printf("half num state bins %i\n", halfNumStateBins);
@@ -411,13 +359,12 @@ void aDDM::callGetTrialLikelihoodKernel(
         d_choices, 
         d_VLs, 
         d_VRs, 
+        d_fixOffsets, 
         d_FIs, 
         d_FTs, 
-        d_FixLens, 
         likelihoods, 
         numTrials, 
         d_states, 
-        maxFixLen,
         biasState, 
         numStates,
         stateStep,
@@ -426,6 +373,8 @@ void aDDM::callGetTrialLikelihoodKernel(
         timeStep, 
         approxStateStep, 
         decay,
+        transitionKernelHalfWidth(sigma, PropagationOptions().tailMass), 
+        PropagationOptions().supportEpsilon, 
         d_prStates, 
         d_prStatesNew
     );
@@ -434,36 +383,34 @@ void aDDM::callGetTrialLikelihoodKernel(
     cudaFree(d_choices);
     cudaFree(d_VLs);
     cudaFree(d_VRs);
+    cudaFree(d_fixOffsets);
     cudaFree(d_FIs);
     cudaFree(d_FTs);
-    cudaFree(d_FixLens);
+    cudaFree(d_states);
     cudaFree(d_prStates);
     cudaFree(d_prStatesNew);
-    delete[] h_RTs;
-    delete[] h_choices; 
-    delete[] h_VLs;
-    delete[] h_VRs;
-    delete[] h_FIs;
-    delete[] h_FTs;
-    delete[] h_fixLens;
+    delete[] states;
+}
+
+
+ProbabilityData aDDM::computeGPUNLL(const std::vector<aDDMTrial> &trials, int trialsPerThread, int timeStep, float approxStateStep) {
+    return computeGPUNLL(TrialBatch(trials), trialsPerThread, timeStep, approxStateStep);
 }
 
 
-ProbabilityData aDDM::computeGPUNLL(std::vector<aDDMTrial> trials, int trialsPerThread, int timeStep, float approxStateStep) {
+ProbabilityData aDDM::computeGPUNLL(const TrialBatch &trials, int trialsPerThread, int timeStep, float approxStateStep) {
     int numTrials = trials.size();
 
-    aDDMTrial* d_trials;
     double *d_likelihoods;
-    cudaMalloc((void **) &d_trials, numTrials * sizeof(aDDMTrial));
     cudaMalloc((void **) &d_likelihoods, numTrials * sizeof(double));
-    cudaMemcpy(d_trials, trials.data(), numTrials * sizeof(aDDMTrial), cudaMemcpyHostToDevice);
 
     int threadsPerBlock = 256; 
-    int numBlocks = 16; 
+    int numThreads = (numTrials + trialsPerThread - 1) / trialsPerThread; 
+    int numBlocks = max(1, (numThreads + threadsPerBlock - 1) / threadsPerBlock); 
 
     aDDM::callGetTrialLikelihoodKernel(
         trialsPerThread, numBlocks, threadsPerBlock,
-        trials.data(), d_likelihoods, numTrials, 
+        trials, d_likelihoods, 
         d, sigma, theta, k, barrier, 
         nonDecisionTime, timeStep, approxStateStep, decay
     );
@@ -471,7 +418,6 @@ ProbabilityData aDDM::computeGPUNLL(std::vector<aDDMTrial> trials, int trialsPer
     std::vector<double> h_likelihoods(numTrials);
     cudaMemcpy(h_likelihoods.data(), d_likelihoods, numTrials * sizeof(double), cudaMemcpyDeviceToHost);
 
-    cudaFree(d_trials);
     cudaFree(d_likelihoods);
 
     double NLL = 0;
@@ -481,6 +427,6 @@ ProbabilityData aDDM::computeGPUNLL(std::vector<aDDMTrial> trials, int trialsPer
         NLL += -log(h_likelihoods[i]);
     }
     ProbabilityData data = ProbabilityData(likelihood, NLL);
-    data.trialLikelihoods = h_likelihoods; 
+    data.trialLikelihoods = std::move(h_likelihoods);
     return data; 
 }
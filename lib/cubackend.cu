@@ -0,0 +1,85 @@
+#include <cuda.h>
+#include <cuda_runtime.h>
+#include <memory>
+#include "compute_backend.h"
+
+
+/**
+ * @brief CUDA engines from cuddm.cu and cuaddm.cu.
+ *
+ */
+class GPUBackend: public ComputeBackend {
+    private:
+        template <typename T>
+        std::vector<std::vector<ProbabilityData>> evaluateBatch(
+            const std::vector<T> &models, const TrialBatch &trials, 
+            const std::vector<float> &biases, int trialsPerThread, int timeStep, 
+            float approxStateStep, bool keepTrialLikelihoods) {
+            std::vector<std::vector<ProbabilityData>> data;
+            for (T model : models) {
+                data.emplace_back();
+                for (float b : biases) {
+                    model.bias = b;
+                    data.back().push_back(
+                        model.computeGPUNLL(trials, trialsPerThread, timeStep, approxStateStep));
+                    if (!keepTrialLikelihoods) {
+                        std::vector<double>().swap(data.back().back().trialLikelihoods);
+                    }
+                }
+            }
+            return data;
+        }
+
+    public:
+        ProbabilityData computeNLL(
+            DDM &ddm, const std::vector<DDMTrial> &trials,
+            int trialsPerThread, int timeStep, float approxStateStep) override {
+            return ddm.computeGPUNLL(trials, trialsPerThread, timeStep, approxStateStep);
+        }
+
+        ProbabilityData computeNLL(
+            aDDM &addm, const std::vector<aDDMTrial> &trials,
+            int trialsPerThread, int timeStep, float approxStateStep) override {
+            return addm.computeGPUNLL(trials, trialsPerThread, timeStep, approxStateStep);
+        }
+
+        ProbabilityData computeNLL(
+            DDM &ddm, const TrialBatch &trials,
+            int trialsPerThread, int timeStep, float approxStateStep) override {
+            return ddm.computeGPUNLL(trials, trialsPerThread, timeStep, approxStateStep);
+        }
+
+        ProbabilityData computeNLL(
+            aDDM &addm, const TrialBatch &trials,
+            int trialsPerThread, int timeStep, float approxStateStep) override {
+            return addm.computeGPUNLL(trials, trialsPerThread, timeStep, approxStateStep);
+        }
+
+        // The batch is uploaded as it is for every model, without copying the trials out. 
+        std::vector<std::vector<ProbabilityData>> computeGridNLLs(
+            const std::vector<DDM> &models, const TrialBatch &trials, 
+            const std::vector<float> &biases, int trialsPerThread, int timeStep, 
+            float approxStateStep, bool keepTrialLikelihoods) override {
+            return evaluateBatch(
+                models, trials, biases, trialsPerThread, timeStep, approxStateStep, 
+                keepTrialLikelihoods);
+        }
+
+        std::vector<std::vector<ProbabilityData>> computeGridNLLs(
+            const std::vector<aDDM> &models, const TrialBatch &trials, 
+            const std::vector<float> &biases, int trialsPerThread, int timeStep, 
+            float approxStateStep, bool keepTrialLikelihoods) override {
+            return evaluateBatch(
+                models, trials, biases, trialsPerThread, timeStep, approxStateStep, 
+                keepTrialLikelihoods);
+        }
+};
+
+
+std::unique_ptr<ComputeBackend> makeGPUBackend() {
+    int numDevices = 0;
+    if (cudaGetDeviceCount(&numDevices) != cudaSuccess || numDevices == 0) {
+        return nullptr;
+    }
+    return std::make_unique<GPUBackend>();
+}
@@ -5,6 +5,7 @@
 #include "ddm.h"
 #include "util.h"
 #include "cuda_util.cuh"
+#include "trial_batch.h"
 
 
 __global__
@@ -22,22 +23,26 @@ void getTrialLikelihoodKernel(
     float stateStep, 
     float d, 
     float sigma, 
-    int barrier, 
+    float barrier, 
     int nonDecisionTime, 
     int timeStep, 
     float approxStateStep, 
-    float dec) {
+    float dec, 
+    float kernelHalfWidth, 
+    double supportEpsilon) {
 
     int tid = blockIdx.x * blockDim.x + threadIdx.x;
-    if (tid < numTrials / trialsPerThread) {
+    // Round up so that the last thread picks up any trials left over by the division. 
+    int numThreads = (numTrials + trialsPerThread - 1) / trialsPerThread; 
+    if (tid < numThreads) {
         double *prStates = new double[numStates];
-        float *changeMatrix = new float[numStates * numStates];
-        float *probDistChangeMatrix = new float[numStates * numStates];
+        float *transitionKernel = new float[2 * numStates - 1];
         double* prStatesNew = new double[numStates];
         float *changeUpCDFs = new float[numStates];
         float *changeDownCDFs = new float[numStates];
 
-        for (int trialNum = tid * trialsPerThread; trialNum < (tid + 1) * trialsPerThread; trialNum++) {
+        int lastTrial = min((tid + 1) * trialsPerThread, numTrials); 
+        for (int trialNum = tid * trialsPerThread; trialNum < lastTrial; trialNum++) {
             int choice = choices[trialNum];
             int RT = RTs[trialNum];
             int valDiff = valDiffs[trialNum];
@@ -71,12 +76,6 @@ void getTrialLikelihoodKernel(
                 }
             }
             
-            for (int i = 0; i < numStates; i++) {
-                for (int j = 0; j < numStates; j++) {
-                    changeMatrix[__RC2IDX(i, j, numStates)] = states[i] - states[j];
-                }
-            }
-
             float *changeUp = new float[numStates * numTimeSteps];
             for (int i = 0; i < numStates; i++) {
                 for (int j = 0; j < numTimeSteps; j++) {
@@ -92,14 +91,6 @@ void getTrialLikelihoodKernel(
             }
 
             if (debug) {
-                printf("change matrix\n");
-                for (int i = 0; i < numStates * numStates; i++) {
-                    printf("%f ", changeMatrix[i]);
-                    if ((i + 1) % numStates == 0) {
-                        printf("\n");
-                    }
-                }
-
                 printf("change up\n");
                 for (int i = 0; i < numStates * numTimeSteps; i++) {
                     printf("%f ", changeUp[i]);
@@ -112,6 +103,10 @@ void getTrialLikelihoodKernel(
 
             int elapsedNDT = 0;
             bool recomputePDCM = true; 
+            int kernelLo = 0; 
+            int kernelHi = 0; 
+            int supportLo = biasState; 
+            int supportHi = biasState; 
             float prevMean = 0; 
             for (int time = 1; time < numTimeSteps; time++) {
 
@@ -134,30 +129,30 @@ void getTrialLikelihoodKernel(
                 }
 
                 if (recomputePDCM || time == 1) {
-                    for (int i = 0; i < numStates; i++) {
-                        for (int j = 0; j < numStates; j++) {
-                            float x = changeMatrix[__RC2IDX(i, j, numStates)];
-                            probDistChangeMatrix[__RC2IDX(i, j, numStates)] = __pdf(x, mean, sigma);
-                        }
-                    }
+                    __fillTransitionKernel(
+                        transitionKernel, &kernelLo, &kernelHi, numStates, stateStep, 
+                        mean, sigma, kernelHalfWidth);
                 }
 
                 if (debug) {
-                    printf("PDCM\n");
-                    for (int i = 0; i < numStates * numStates; i++) {
-                        printf("%f ", probDistChangeMatrix[i]);
-                        if ((i + 1) % numStates == 0) {
-                            printf("\n");
-                        }
+                    printf("transition kernel [%i, %i]\n", kernelLo, kernelHi);
+                    for (int m = kernelLo; m <= kernelHi; m++) {
+                        printf("%f ", transitionKernel[m - kernelLo]);
                     }
+                    printf("\n");
                 }
 
+                // Only states reachable from the support of prStates can receive mass. 
+                int newLo = max(0, supportLo + kernelLo); 
+                int newHi = min(numStates - 1, supportHi + kernelHi); 
                 double rowSum; 
                 for (int i = 0; i < numStates; i++) {
-                    rowSum = 0; 
-                    for (int j = 0; j < numStates; j++) {
-                        rowSum += stateStep * probDistChangeMatrix[__RC2IDX(i, j, numStates)] * prStates[j];
+                    if (i < newLo || i > newHi) {
+                        prStatesNew[i] = 0; 
+                        continue; 
                     }
+                    rowSum = stateStep * __applyTransitionKernel(
+                        transitionKernel, kernelLo, kernelHi, prStates, i, numStates);
                     prStatesNew[i] = (states[i] > barrierUp[time] || states[i] < barrierDown[time]) ? 0 : rowSum;
                 }
 
@@ -167,31 +162,31 @@ void getTrialLikelihoodKernel(
                     }
                 }
 
-                for (int i = 0; i < numStates; i++) {
+                for (int i = supportLo; i <= supportHi; i++) {
                     float x = changeUp[__RC2IDX(i, time, numTimeSteps)];
                     changeUpCDFs[i] = 1 - normcdff((x - mean) / sigma);
                 }
                 if (debug) {
-                    for (int i = 0; i < numStates; i++) {
+                    for (int i = supportLo; i <= supportHi; i++) {
                         printf("changeUpCDFs[%i] = %f\n", i, changeUpCDFs[i]);
                     }
                 }
                 double tempUpCross = 0; 
-                for (int i = 0; i < numStates; i++) {
+                for (int i = supportLo; i <= supportHi; i++) {
                     tempUpCross += changeUpCDFs[i] * prStates[i];
                 }
 
-                for (int i = 0; i < numStates; i++) {
+                for (int i = supportLo; i <= supportHi; i++) {
                     float x = changeDown[__RC2IDX(i, time, numTimeSteps)];
                     changeDownCDFs[i] = normcdff((x - mean) / sigma);
                 }
                 if (debug) {
-                    for (int i = 0; i < numStates; i++) {
+                    for (int i = supportLo; i <= supportHi; i++) {
                         printf("changeDownCDFs[%i] = %f\n", i, changeDownCDFs[i]);
                     }
                 }
                 double tempDownCross = 0; 
-                for (int i = 0; i < numStates; i++) {
+                for (int i = supportLo; i <= supportHi; i++) {
                     tempDownCross += changeDownCDFs[i] * prStates[i];
                 }
 
@@ -200,14 +195,19 @@ void getTrialLikelihoodKernel(
 
                 double sumIn = 0; 
                 double sumCurrent = tempUpCross + tempDownCross; 
-                for (int i = 0; i < numStates; i++) {
+                for (int i = supportLo; i <= supportHi; i++) {
                     sumIn += prStates[i];
+                }
+                for (int i = newLo; i <= newHi; i++) {
                     sumCurrent += prStatesNew[i];
                 }
                 double normFactor = sumIn / sumCurrent; 
                 for (int i = 0; i < numStates; i++) {
                     prStates[i] = prStatesNew[i] * normFactor; 
                 }
+                supportLo = newLo; 
+                supportHi = newHi; 
+                __trimSupport(prStates, &supportLo, &supportHi, supportEpsilon); 
 
                 probUpCrossing[time] = tempUpCross * normFactor; 
                 probDownCrossing[time] = tempDownCross * normFactor;
@@ -240,8 +240,7 @@ void getTrialLikelihoodKernel(
         }
 
         delete[] prStates;
-        delete[] changeMatrix;            
-        delete[] probDistChangeMatrix;
+        delete[] transitionKernel;
         delete[] prStatesNew;
         delete[] changeUpCDFs;
         delete[] changeDownCDFs;
@@ -250,11 +249,12 @@ void getTrialLikelihoodKernel(
 
 void DDM::callGetTrialLikelihoodKernel(
     int trialsPerThread, int numBlocks, int threadsPerBlock, 
-    DDMTrial *trials, double *likelihoods, 
-    int numTrials, float d, float sigma, float barrier, 
+    const TrialBatch &trials, double *likelihoods, 
+    float d, float sigma, float barrier, 
     int nonDecisionTime, int timeStep, float approxStateStep, float dec) {
 
     bool debug = false;  
+    int numTrials = trials.size();
 
     int *d_RTs, *d_choices, *d_VDs;
     cudaMalloc((void**)&d_RTs, numTrials * sizeof(int));
@@ -262,16 +262,12 @@ void DDM::callGetTrialLikelihoodKernel(
     cudaMalloc((void**)&d_VDs, numTrials * sizeof(int));
 
     int *h_VDs = new int[numTrials];
-    int *h_RTs = new int[numTrials];
-    int *h_choices = new int[numTrials];
     for (int i = 0; i < numTrials; i++) {
-        h_VDs[i] = trials[i].valueLeft - trials[i].valueRight;
-        h_RTs[i] = trials[i].RT;
-        h_choices[i] = trials[i].choice;
+        h_VDs[i] = trials.valueLeft[i] - trials.valueRight[i];
     }
 
-    cudaMemcpy(d_RTs, h_RTs, numTrials * sizeof(int), cudaMemcpyHostToDevice);
-    cudaMemcpy(d_choices, h_choices, numTrials * sizeof(int), cudaMemcpyHostToDevice);
+    cudaMemcpy(d_RTs, trials.RT.data(), numTrials * sizeof(int), cudaMemcpyHostToDevice);
+    cudaMemcpy(d_choices, trials.choice.data(), numTrials * sizeof(int), cudaMemcpyHostToDevice);
     cudaMemcpy(d_VDs, h_VDs, numTrials * sizeof(int), cudaMemcpyHostToDevice);
     
     int halfNumStateBins = ceil(barrier / approxStateStep); 
@@ -316,42 +312,44 @@ void DDM::callGetTrialLikelihoodKernel(
         nonDecisionTime,
         timeStep,
         approxStateStep,
-        dec
+        dec,
+        transitionKernelHalfWidth(sigma, PropagationOptions().tailMass), 
+        PropagationOptions().supportEpsilon
     );
 
     cudaFree(d_RTs);
     cudaFree(d_choices);
     cudaFree(d_VDs);
     cudaFree(d_states);
-    delete[] h_RTs;
-    delete[] h_choices;
     delete[] h_VDs;
     delete[] states;
     }
         
 
-ProbabilityData DDM::computeGPUNLL(std::vector<DDMTrial> trials, int trialsPerThread, int timeStep, float approxStateStep) {
+ProbabilityData DDM::computeGPUNLL(const std::vector<DDMTrial> &trials, int trialsPerThread, int timeStep, float approxStateStep) {
+    return computeGPUNLL(TrialBatch(trials), trialsPerThread, timeStep, approxStateStep);
+}
+
+
+ProbabilityData DDM::computeGPUNLL(const TrialBatch &trials, int trialsPerThread, int timeStep, float approxStateStep) {
     int numTrials = trials.size(); 
 
-    DDMTrial *d_trials;
     double *d_likelihoods;
-    cudaMalloc((void**) &d_trials, numTrials * sizeof(DDMTrial));
     cudaMalloc((void**) &d_likelihoods, numTrials * sizeof(double));
-    cudaMemcpy(d_trials, trials.data(), numTrials * sizeof(DDMTrial), cudaMemcpyHostToDevice);
 
     int threadsPerBlock = 256; 
-    int numBlocks = 16;
+    int numThreads = (numTrials + trialsPerThread - 1) / trialsPerThread; 
+    int numBlocks = max(1, (numThreads + threadsPerBlock - 1) / threadsPerBlock);
 
     DDM::callGetTrialLikelihoodKernel(
         trialsPerThread, numBlocks, threadsPerBlock, 
-        trials.data(), d_likelihoods, 
-        numTrials, d, sigma, barrier, 
+        trials, d_likelihoods, 
+        d, sigma, barrier, 
         nonDecisionTime, timeStep, approxStateStep, decay);
 
     std::vector<double> h_likelihoods(numTrials);
     cudaMemcpy(h_likelihoods.data(), d_likelihoods, numTrials * sizeof(double), cudaMemcpyDeviceToHost);
 
-    cudaFree(d_trials);
     cudaFree(d_likelihoods);
 
     double NLL = 0;
@@ -361,6 +359,6 @@ ProbabilityData DDM::computeGPUNLL(std::vector<DDMTrial> trials, int trialsPerTh
         NLL += -log(h_likelihoods[i]);
     }
     ProbabilityData data = ProbabilityData(likelihood, NLL);
-    data.trialLikelihoods = h_likelihoods; 
+    data.trialLikelihoods = std::move(h_likelihoods);
     return data;
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include <iostream>
 #include <chrono> 
 #include <cstddef>
+#include <set>
+#include <cmath>
 #include <string> 
 #include <random>
 #include <fstream>
@@ -10,7 +12,10 @@
 #include <BS_thread_pool.hpp>
 #include "util.h"
 #include "ddm.h"
+#include "compute_backend.h"
+#include "trial_batch.h"
 #include "stats.h"
+#include "streaming_posterior.h"
 
 DDMTrial::DDMTrial(unsigned int RT, int choice, int valueLeft, int valueRight) {
     this->RT = RT;
@@ -34,7 +39,7 @@ DDM::DDM(float d, float sigma, float barrier, unsigned int nonDecisionTime, floa
     this->decay = decay; 
 }
 
-void DDM::exportTrial(DDMTrial dt, std::string filename) {
+void DDM::exportTrial(const DDMTrial &dt, const std::string &filename) {
     std::ofstream o(filename);
     json j;
     j["d"] = d;
@@ -87,22 +92,22 @@ DDMTrial DDM::simulateTrial(int valueLeft, int valueRight, int timeStep, int see
         time += 1;
     }
     DDMTrial trial = DDMTrial(RT, choice, valueLeft, valueRight);
-    trial.RDVs = RDVs;
+    trial.RDVs = std::move(RDVs);
     trial.timeStep = timeStep;
     return trial;
 }
 
-void DDMTrial::writeTrialsToCSV(std::vector<DDMTrial> trials, std::string filename) {
+void DDMTrial::writeTrialsToCSV(const std::vector<DDMTrial> &trials, const std::string &filename) {
     std::ofstream fp;
     fp.open(filename);
     fp << "choice,rt,valueLeft,valueRight\n";
-    for (DDMTrial t : trials) {
+    for (const DDMTrial &t : trials) {
         fp << t.choice << "," << t.RT << "," << t.valueLeft << "," << t.valueRight << "\n";
     }
     fp.close();
 }
 
-std::vector<DDMTrial> DDMTrial::loadTrialsFromCSV(std::string filename) {
+std::vector<DDMTrial> DDMTrial::loadTrialsFromCSV(const std::string &filename) {
     std::vector<DDMTrial> trials; 
     std::ifstream file(filename);
     std::string line;
@@ -133,87 +138,531 @@ std::vector<DDMTrial> DDMTrial::loadTrialsFromCSV(std::string filename) {
 }
 
 MLEinfo<DDM> DDM::fitModelMLE(
-    vector<DDMTrial> trials, 
+    const vector<DDMTrial> &trials, 
     vector<float> rangeD, 
     vector<float> rangeSigma, 
+    string computeMethod, 
     bool normalizePosteriors, 
     float barrier, 
     unsigned int nonDecisionTime, 
     vector<float> bias, 
-    vector<float> decay) {
+    vector<float> decay, 
+    int timeStep, 
+    float approxStateStep, 
+    int trialsPerThread, 
+    int refinementLevels, 
+    int refinementNeighborhoods, 
+    bool pruning, 
+    ScreeningOptions screening) {
 
+    return fitModelMLE(
+        TrialBatch(trials), rangeD, rangeSigma, computeMethod, normalizePosteriors, barrier, 
+        nonDecisionTime, bias, decay, timeStep, approxStateStep, trialsPerThread, 
+        refinementLevels, refinementNeighborhoods, pruning, screening);
+}
+
+
+MLEinfo<DDM> DDM::fitModelMLE(
+    const TrialBatch &trials, 
+    vector<float> rangeD, 
+    vector<float> rangeSigma, 
+    string computeMethod, 
+    bool normalizePosteriors, 
+    float barrier, 
+    unsigned int nonDecisionTime, 
+    vector<float> bias, 
+    vector<float> decay, 
+    int timeStep, 
+    float approxStateStep, 
+    int trialsPerThread, 
+    int refinementLevels, 
+    int refinementNeighborhoods, 
+    bool pruning, 
+    ScreeningOptions screening) {
+
+    if (refinementLevels < 0 || refinementNeighborhoods <= 0) {
+        throw std::invalid_argument(
+            "refinementLevels must be non-negative and refinementNeighborhoods positive.");
+    }
+    if (pruning && normalizePosteriors) {
+        throw std::invalid_argument("pruning requires normalizePosteriors to be false.");
+    }
+    if (screening.enabled && normalizePosteriors) {
+        throw std::invalid_argument("screening requires normalizePosteriors to be false.");
+    }
+    if (screening.enabled && (screening.timeStep <= 0 || screening.approxStateStep <= 0 || 
+        screening.topFraction <= 0 || screening.topFraction > 1 || screening.margin < 0)) {
+        throw std::invalid_argument(
+            "screening requires positive steps, a topFraction in (0, 1] and a non-negative "
+            "margin.");
+    }
     sort(rangeD.begin(), rangeD.end());
     sort(rangeSigma.begin(), rangeSigma.end());
     sort(bias.begin(), bias.end());
     sort(decay.begin(), decay.end());
 
-    std::vector<DDM> potentialModels; 
-    for (float d : rangeD) {
-        for (float sigma : rangeSigma) {
-            for (float b : bias) {
-                for (float dec : decay) {
-                    DDM ddm = DDM(d, sigma, barrier, nonDecisionTime, b, dec);
-                    potentialModels.push_back(ddm);
-                } 
-            }
-        }
-    }
+    std::unique_ptr<ComputeBackend> backend = getComputeBackend(computeMethod);
+    // Pruning evaluates the trials from a copy in bounding order. 
+    TrialBatch boundingOrder; 
 
-    double minNLL = __DBL_MAX__;
-    std::map<DDM, ProbabilityData> allTrialLikelihoods;
-    std::map<DDM, float> posteriors; 
-    double numModels = rangeD.size() * rangeSigma.size() * bias.size() * decay.size(); 
+    // Results of the grid of the ranges, NaN until a point is evaluated and infinity once 
+    // pruning drops it. Bias is the last axis, so the biases of a model are neighbors. 
+    ParameterGrid grid({"d", "sigma", "decay", "bias"}, {rangeD, rangeSigma, decay, bias});
+    int numBiases = grid.axes.back().size();
+    // Whether each grid model, whose biases are the points from m * numBiases on, is only 
+    // evaluated at the coarse resolution. 
+    std::vector<bool> coarse(grid.size() / numBiases, false);
+    // NLL of every model added off the grid by refinement, keyed by (d, sigma, decay, bias). 
+    std::map<std::vector<float>, double> refinedScores; 
 
+    double minNLL = __DBL_MAX__;
     DDM optimal = DDM(); 
-    for (DDM ddm : potentialModels) {
-        ProbabilityData aux = ddm.computeGPUNLL(trials);
-        if (normalizePosteriors) {
-            allTrialLikelihoods.insert({ddm, aux});
-            posteriors.insert({ddm, 1 / numModels});
+    // Models entering the posterior, with their grid index or -1 off the grid, and their 
+    // per-trial log likelihoods, one row per model. 
+    std::vector<DDM> posteriorModels; 
+    std::vector<long> posteriorIndices; 
+    std::vector<double> logLikelihoods; 
+    // Every bias of a model is evaluated together, so only the other parameters are enumerated. 
+    // indices holds the grid index of every (model, bias) point, or -1 off the grid. 
+    auto record = [&](
+        const std::vector<DDM> &potentialModels, const std::vector<float> &biases, 
+        const std::vector<long> &indices, 
+        const std::vector<std::vector<ProbabilityData>> &gridData) {
+        for (int m = 0; m < potentialModels.size(); m++) {
+            const std::vector<ProbabilityData> &biasData = gridData[m];
+            for (int b = 0; b < biases.size(); b++) {
+                DDM ddm = potentialModels[m]; 
+                ddm.bias = biases[b]; 
+                const ProbabilityData &aux = biasData[b]; 
+                long index = indices[m * biases.size() + b];
+                if (index >= 0) {
+                    if (!std::isnan(grid.values[index])) {
+                        continue;
+                    }
+                    grid.values[index] = aux.NLL;
+                } else if (!refinedScores.insert(
+                    {{ddm.d, ddm.sigma, ddm.decay, ddm.bias}, aux.NLL}).second) {
+                    continue;
+                }
+                if (std::isinf(aux.NLL)) {
+                    continue;
+                }
+                if (normalizePosteriors) {
+                    posteriorModels.push_back(ddm);
+                    posteriorIndices.push_back(index);
+                    for (double likelihood : aux.trialLikelihoods) {
+                        logLikelihoods.push_back(log(likelihood));
+                    }
+                }
+                if (aux.NLL < minNLL) {
+                    minNLL = aux.NLL; 
+                    optimal = ddm; 
+                }
+            }
+        }
+    };
+    auto evaluate = [&](
+        const std::vector<DDM> &potentialModels, const std::vector<float> &biases, 
+        const std::vector<long> &indices) {
+        if (pruning) {
+            double bound = minNLL;
+            record(potentialModels, biases, indices, backend->computeBoundedGridNLLs(
+                potentialModels, boundingOrder, biases, trialsPerThread, timeStep, 
+                approxStateStep, bound));
         } else {
-            posteriors.insert({ddm, aux.NLL});
+            record(potentialModels, biases, indices, backend->computeGridNLLs(
+                potentialModels, trials, biases, trialsPerThread, timeStep, approxStateStep, 
+                normalizePosteriors));
         }
-        std::cout << "testing d=" << ddm.d << " sigma=" << ddm.sigma; 
-        if (bias.size() > 1) {
-            std::cout << " bias=" << ddm.bias; 
-        } 
-        if (decay.size() > 1) {
-            std::cout << " decay=" << ddm.decay; 
+    };
+    auto gridModel = [&](size_t point) {
+        std::vector<float> p = grid.parameters(point);
+        return DDM(p[0], p[1], barrier, nonDecisionTime, p[3], p[2]);
+    };
+
+    // Models are built and evaluated a batch at a time, so that only grid.values and the 
+    // indices of the models left to evaluate are held for the whole grid. 
+    const size_t modelsPerBatch = 256;
+    // Index of the first grid point of each model left to evaluate. 
+    std::vector<size_t> points; 
+    for (size_t point = 0; point < grid.size(); point += numBiases) {
+        points.push_back(point);
+    }
+    if (screening.enabled) {
+        // Drift, noise and decay are given per time step, so the coarse models are rescaled to 
+        // describe the same process over the longer coarse time step. 
+        float scale = (float) screening.timeStep / timeStep;
+        // The coarse NLLs are stored in the grid as each batch completes, and cleared again for 
+        // the finalists. 
+        std::vector<double> coarseNLLs;
+        for (size_t begin = 0; begin < points.size(); begin += modelsPerBatch) {
+            size_t end = std::min(points.size(), begin + modelsPerBatch);
+            std::vector<DDM> screenedModels;
+            for (size_t m = begin; m < end; m++) {
+                DDM ddm = gridModel(points[m]);
+                screenedModels.push_back(DDM(
+                    ddm.d * scale, ddm.sigma * sqrt(scale), barrier, nonDecisionTime, 0, 
+                    ddm.decay * scale));
+            }
+            std::vector<std::vector<ProbabilityData>> gridData = backend->computeGridNLLs(
+                screenedModels, trials, grid.axes.back(), trialsPerThread, screening.timeStep, 
+                screening.approxStateStep, false);
+            for (size_t m = begin; m < end; m++) {
+                const std::vector<ProbabilityData> &biasData = gridData[m - begin];
+                for (int b = 0; b < numBiases; b++) {
+                    grid.values[points[m] + b] = biasData[b].NLL;
+                }
+                coarseNLLs.push_back(std::min_element(
+                    biasData.begin(), biasData.end(), 
+                    [](const ProbabilityData &a, const ProbabilityData &b) { 
+                        return a.NLL < b.NLL; 
+                    })->NLL);
+            }
+        }
+        std::vector<int> finalists = selectFinalists(
+            coarseNLLs, screening.topFraction, screening.margin);
+        std::vector<size_t> finePoints;
+        for (int m : finalists) {
+            finePoints.push_back(points[m]);
         }
-        std::cout << " NLL=" << aux.NLL << std::endl; 
-        if (aux.NLL < minNLL) {
-            minNLL = aux.NLL; 
-            optimal = ddm; 
+        // Coarse scores are not comparable with fine ones, so refinement never centers on them. 
+        coarse.assign(points.size(), true);
+        for (int m : finalists) {
+            coarse[m] = false;
+            std::fill_n(grid.values.begin() + points[m], numBiases, NAN);
         }
+        points = finePoints;
     }
-    if (normalizePosteriors) {
-        for (int tn = 0; tn < trials.size(); tn++) {
-            double denominator = 0; 
-            for (const auto &ddmPD : allTrialLikelihoods) {
-                DDM curr = ddmPD.first; 
-                ProbabilityData data = ddmPD.second; 
-                double likelihood = data.trialLikelihoods[tn];
-                denominator += posteriors[curr] * likelihood; 
+    // Evaluate numModels models under every bias of biases, building them with 
+    // append(m, potentialModels, indices) a batch at a time. 
+    auto evaluateBatches = [&](
+        size_t numModels, const std::vector<float> &biases, 
+        const std::function<void(size_t, std::vector<DDM> &, std::vector<long> &)> &append) {
+        std::vector<DDM> potentialModels; 
+        std::vector<long> indices; 
+        for (size_t begin = 0; begin < numModels; begin += modelsPerBatch) {
+            potentialModels.clear();
+            indices.clear();
+            for (size_t m = begin; m < std::min(numModels, begin + modelsPerBatch); m++) {
+                append(m, potentialModels, indices);
             }
-            double sum = 0; 
-            for (const auto &ddmPD : allTrialLikelihoods) {
-                DDM curr = ddmPD.first; 
-                ProbabilityData data = ddmPD.second; 
-                double prior = posteriors[curr];
-                double newLikelihood = data.trialLikelihoods[tn] * prior / denominator; 
-                posteriors[curr] = newLikelihood; 
-                sum += newLikelihood; 
+            evaluate(potentialModels, biases, indices);
+        }
+    };
+    if (pruning) {
+        // The best model of the screening pass, or else the center of the grid, is evaluated in 
+        // full first. Its NLL is the initial bound and its trial likelihoods decide the order in 
+        // which the other models visit the trials. 
+        size_t pilot = screening.enabled ? points[0] : grid.index({
+            (int) grid.axes[0].size() / 2, (int) grid.axes[1].size() / 2, 
+            (int) grid.axes[2].size() / 2, 0});
+        std::vector<DDM> pilotModel = {gridModel(pilot)};
+        std::vector<std::vector<ProbabilityData>> pilotData = backend->computeGridNLLs(
+            pilotModel, trials, grid.axes.back(), trialsPerThread, timeStep, approxStateStep);
+        std::vector<long> pilotIndices; 
+        for (int b = 0; b < numBiases; b++) {
+            pilotIndices.push_back(pilot + b);
+        }
+        record(pilotModel, grid.axes.back(), pilotIndices, pilotData);
+        auto best = std::min_element(
+            pilotData[0].begin(), pilotData[0].end(), 
+            [](const ProbabilityData &a, const ProbabilityData &b) { return a.NLL < b.NLL; });
+        boundingOrder = trials.subset(
+            orderTrialsForBounding(trials.RT, best->trialLikelihoods, timeStep));
+        points.erase(std::find(points.begin(), points.end(), pilot));
+    }
+    evaluateBatches(points.size(), grid.axes.back(), [&](
+        size_t m, std::vector<DDM> &potentialModels, std::vector<long> &indices) {
+        potentialModels.push_back(gridModel(points[m]));
+        for (int b = 0; b < numBiases; b++) {
+            indices.push_back(points[m] + b);
+        }
+    });
+
+    // Coarse-to-fine refinement: evaluate a grid with half the spacing around the best models so
+    // far, skipping the models that were already evaluated. 
+    auto evaluated = [&](const std::vector<float> &key) {
+        long index = grid.find(key);
+        return index >= 0 ? !std::isnan(grid.values[index]) : refinedScores.count(key) > 0;
+    };
+    for (int level = 1; level <= refinementLevels; level++) {
+        // Fine NLLs on the grid are ranked by index and those off it by their position in 
+        // refinedKeys, past the end of the grid. 
+        std::vector<std::pair<double, size_t>> ranked;
+        for (size_t i = 0; i < grid.size(); i++) {
+            if (std::isfinite(grid.values[i]) && !coarse[i / numBiases]) {
+                ranked.push_back({grid.values[i], i});
+            }
+        }
+        std::vector<const std::vector<float> *> refinedKeys;
+        for (const auto &score : refinedScores) {
+            if (std::isfinite(score.second)) {
+                ranked.push_back({score.second, grid.size() + refinedKeys.size()});
+                refinedKeys.push_back(&score.first);
+            }
+        }
+        int numCenters = std::min((int) ranked.size(), refinementNeighborhoods);
+        std::partial_sort(ranked.begin(), ranked.begin() + numCenters, ranked.end());
+
+        std::set<std::vector<float>> refinedModels;
+        std::set<float> refinedBiases;
+        for (int c = 0; c < numCenters; c++) {
+            size_t i = ranked[c].second;
+            std::vector<float> center = i < grid.size() ? 
+                grid.parameters(i) : *refinedKeys[i - grid.size()];
+            for (float d : refineRange(rangeD, center[0], level)) {
+                for (float sigma : refineRange(rangeSigma, center[1], level)) {
+                    for (float dec : refineRange(decay, center[2], level)) {
+                        refinedModels.insert({d, sigma, dec});
+                    }
+                }
             }
-            if (sum != 1) {
-                double normalizer = 1 / sum; 
-                for (auto &p : posteriors) {
-                    p.second *= normalizer; 
-                } 
+            for (float b : refineRange(bias, center[3], level)) {
+                refinedBiases.insert(b);
+            }
+        }
+        std::vector<float> biases(refinedBiases.begin(), refinedBiases.end());
+        std::vector<const std::vector<float> *> pending;
+        for (const std::vector<float> &p : refinedModels) {
+            bool allEvaluated = true;
+            for (float b : biases) {
+                allEvaluated = allEvaluated && evaluated({p[0], p[1], p[2], b});
+            }
+            if (!allEvaluated) {
+                pending.push_back(&p);
+            }
+        }
+        if (pending.empty()) {
+            break;
+        }
+        evaluateBatches(pending.size(), biases, [&](
+            size_t m, std::vector<DDM> &potentialModels, std::vector<long> &indices) {
+            const std::vector<float> &p = *pending[m];
+            potentialModels.push_back(DDM(p[0], p[1], barrier, nonDecisionTime, 0, p[2]));
+            for (float b : biases) {
+                indices.push_back(grid.find({p[0], p[1], p[2], b}));
+            }
+        });
+    }
+
+    if (normalizePosteriors) {
+        // Uniform prior over every evaluated model. 
+        std::vector<double> modelPosteriors = computePosteriors(
+            logLikelihoods, posteriorModels.size());
+        for (int m = 0; m < posteriorModels.size(); m++) {
+            const DDM &curr = posteriorModels[m];
+            if (posteriorIndices[m] >= 0) {
+                grid.values[posteriorIndices[m]] = modelPosteriors[m];
+            } else {
+                refinedScores[{curr.d, curr.sigma, curr.decay, curr.bias}] = modelPosteriors[m];
             }
         }
     }
     MLEinfo<DDM> info;
     info.optimal = optimal; 
-    info.likelihoods = posteriors; 
+    // Models dropped by pruning have no result. likelihoods and fidelities still get one entry 
+    // per evaluated model, so that existing callers keep working, at the cost of one map node 
+    // per grid point. 
+    for (size_t i = 0; i < grid.size(); i++) {
+        if (std::isinf(grid.values[i])) {
+            grid.values[i] = NAN;
+        } else if (!std::isnan(grid.values[i])) {
+            DDM ddm = gridModel(i);
+            info.likelihoods.insert({ddm, grid.values[i]});
+            if (screening.enabled) {
+                info.fidelities.insert(
+                    {ddm, coarse[i / numBiases] ? Fidelity::Coarse : Fidelity::Fine});
+            }
+        }
+    }
+    for (const auto &score : refinedScores) {
+        if (std::isinf(score.second)) {
+            continue;
+        }
+        const std::vector<float> &p = score.first;
+        DDM ddm = DDM(p[0], p[1], barrier, nonDecisionTime, p[3], p[2]);
+        info.likelihoods.insert({ddm, score.second});
+        if (screening.enabled) {
+            info.fidelities.insert({ddm, Fidelity::Fine});
+        }
+    }
+    info.grid = std::move(grid);
     return info;   
 }
+
+
+MLEinfo<DDM> DDM::fitModelStreaming(
+    const vector<DDMTrial> &trials, 
+    vector<float> rangeD, 
+    vector<float> rangeSigma, 
+    string computeMethod, 
+    float barrier, 
+    unsigned int nonDecisionTime, 
+    vector<float> bias, 
+    vector<float> decay, 
+    int timeStep, 
+    float approxStateStep, 
+    int trialsPerThread, 
+    int topK, 
+    int modelsPerBatch) {
+
+    return fitModelStreaming(
+        TrialBatch(trials), rangeD, rangeSigma, computeMethod, barrier, nonDecisionTime, bias, 
+        decay, timeStep, approxStateStep, trialsPerThread, topK, modelsPerBatch);
+}
+
+
+MLEinfo<DDM> DDM::fitModelStreaming(
+    const TrialBatch &trials, 
+    vector<float> rangeD, 
+    vector<float> rangeSigma, 
+    string computeMethod, 
+    float barrier, 
+    unsigned int nonDecisionTime, 
+    vector<float> bias, 
+    vector<float> decay, 
+    int timeStep, 
+    float approxStateStep, 
+    int trialsPerThread, 
+    int topK, 
+    int modelsPerBatch) {
+
+    std::unique_ptr<ComputeBackend> backend = getComputeBackend(computeMethod);
+    ParameterGrid grid({"d", "sigma", "decay", "bias"}, {rangeD, rangeSigma, decay, bias}, false);
+    return fitStreamingGrid<DDM>(
+        std::move(grid), topK, modelsPerBatch, 
+        [&](const std::vector<float> &p) {
+            return DDM(p[0], p[1], barrier, nonDecisionTime, 0, p[2]);
+        }, 
+        [&](const std::vector<DDM> &models, const std::vector<float> &biases) {
+            return backend->computeGridNLLs(
+                models, trials, biases, trialsPerThread, timeStep, approxStateStep);
+        });
+}
+
+
+MLEinfo<DDM> DDM::fitModelAnytime(
+    const vector<DDMTrial> &trials, 
+    vector<float> rangeD, 
+    vector<float> rangeSigma, 
+    string computeMethod, 
+    float barrier, 
+    unsigned int nonDecisionTime, 
+    vector<float> bias, 
+    vector<float> decay, 
+    int timeStep, 
+    float approxStateStep, 
+    int trialsPerThread, 
+    AnytimeOptions options) {
+
+    return fitModelAnytime(
+        TrialBatch(trials), rangeD, rangeSigma, computeMethod, barrier, nonDecisionTime, bias, 
+        decay, timeStep, approxStateStep, trialsPerThread, options);
+}
+
+
+MLEinfo<DDM> DDM::fitModelAnytime(
+    const TrialBatch &trials, 
+    vector<float> rangeD, 
+    vector<float> rangeSigma, 
+    string computeMethod, 
+    float barrier, 
+    unsigned int nonDecisionTime, 
+    vector<float> bias, 
+    vector<float> decay, 
+    int timeStep, 
+    float approxStateStep, 
+    int trialsPerThread, 
+    AnytimeOptions options) {
+
+    std::unique_ptr<ComputeBackend> backend = getComputeBackend(computeMethod);
+    ParameterGrid grid({"d", "sigma", "decay", "bias"}, {rangeD, rangeSigma, decay, bias});
+    return fitAnytimeGrid<DDM>(
+        std::move(grid), options, 
+        [&](const std::vector<float> &p) {
+            return DDM(p[0], p[1], barrier, nonDecisionTime, 0, p[2]);
+        }, 
+        [&](const std::vector<DDM> &models, const std::vector<float> &biases) {
+            return backend->computeGridNLLs(
+                models, trials, biases, trialsPerThread, timeStep, approxStateStep, false);
+        });
+}
+
+
+MLEinfo<DDM> DDM::fitModelOptimize(
+    const vector<DDMTrial> &trials, 
+    vector<float> rangeD, 
+    vector<float> rangeSigma, 
+    string computeMethod, 
+    float barrier, 
+    unsigned int nonDecisionTime, 
+    vector<float> bias, 
+    vector<float> decay, 
+    int timeStep, 
+    float approxStateStep, 
+    int trialsPerThread, 
+    std::optional<DDM> warmStart, 
+    OptimizerOptions options) {
+
+    return fitModelOptimize(
+        TrialBatch(trials), rangeD, rangeSigma, computeMethod, barrier, nonDecisionTime, bias, 
+        decay, timeStep, approxStateStep, trialsPerThread, warmStart, options);
+}
+
+
+MLEinfo<DDM> DDM::fitModelOptimize(
+    const TrialBatch &trials, 
+    vector<float> rangeD, 
+    vector<float> rangeSigma, 
+    string computeMethod, 
+    float barrier, 
+    unsigned int nonDecisionTime, 
+    vector<float> bias, 
+    vector<float> decay, 
+    int timeStep, 
+    float approxStateStep, 
+    int trialsPerThread, 
+    std::optional<DDM> warmStart, 
+    OptimizerOptions options) {
+
+    // Parameters are ordered as (d, sigma, bias, decay). 
+    std::vector<std::vector<float>> ranges = {rangeD, rangeSigma, bias, decay};
+    std::vector<double> lower, upper, x0;
+    for (const std::vector<float> &range : ranges) {
+        if (range.empty()) {
+            throw std::invalid_argument("Every parameter range must hold at least one value.");
+        }
+        lower.push_back(*std::min_element(range.begin(), range.end()));
+        upper.push_back(*std::max_element(range.begin(), range.end()));
+        x0.push_back((lower.back() + upper.back()) / 2);
+    }
+    if (warmStart) {
+        x0 = {warmStart->d, warmStart->sigma, warmStart->bias, warmStart->decay};
+    }
+
+    std::unique_ptr<ComputeBackend> backend = getComputeBackend(computeMethod);
+    std::map<std::vector<float>, double> scores;
+    MLEinfo<DDM> info;
+    double minNLL = __DBL_MAX__;
+    auto negativeLogLikelihood = [&](const std::vector<double> &x) {
+        DDM ddm = DDM(x[0], x[1], barrier, nonDecisionTime, x[2], x[3]);
+        std::vector<float> key = {ddm.d, ddm.sigma, ddm.bias, ddm.decay};
+        auto it = scores.find(key);
+        if (it != scores.end()) {
+            return it->second;
+        }
+        double NLL = backend->computeNLL(
+            ddm, trials, trialsPerThread, timeStep, approxStateStep).NLL;
+        scores.insert({key, NLL});
+        info.likelihoods.insert({ddm, NLL});
+        if (NLL < minNLL) {
+            minNLL = NLL;
+            info.optimal = ddm;
+        }
+        return NLL;
+    };
+    OptimizerResult result = nelderMead(negativeLogLikelihood, x0, lower, upper, options);
+    info.converged = result.converged;
+    info.numEvaluations = result.numEvaluations;
+    return info;
+}
@@ -0,0 +1,38 @@
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mapped_file.h"
+
+
+MappedFile::MappedFile(const std::string &filename) {
+    this->address = nullptr;
+    this->length = 0;
+    this->descriptor = open(filename.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw std::invalid_argument("Unable to open " + filename + ".");
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) != 0) {
+        close(descriptor);
+        throw std::invalid_argument("Unable to read the size of " + filename + ".");
+    }
+    length = status.st_size;
+    if (length > 0) {
+        void *mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (mapping == MAP_FAILED) {
+            close(descriptor);
+            throw std::invalid_argument("Unable to map " + filename + ".");
+        }
+        address = mapping;
+        madvise(address, length, MADV_SEQUENTIAL);
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (address) {
+        munmap(address, length);
+    }
+    close(descriptor);
+}
@@ -0,0 +1,327 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+#include "optimize.h"
+
+OptimizerResult nelderMead(
+    const std::function<double(const std::vector<double> &)> &fn, std::vector<double> x0, 
+    const std::vector<double> &lower, const std::vector<double> &upper, 
+    const OptimizerOptions &options) {
+
+    int numParams = x0.size();
+    if (lower.size() != numParams || upper.size() != numParams) {
+        throw std::invalid_argument("x0, lower and upper must have the same size.");
+    }
+    std::vector<int> free;
+    for (int i = 0; i < numParams; i++) {
+        if (lower[i] > upper[i]) {
+            throw std::invalid_argument("lower bounds must not exceed upper bounds.");
+        }
+        x0[i] = std::min(std::max(x0[i], lower[i]), upper[i]);
+        if (lower[i] < upper[i]) {
+            free.push_back(i);
+        }
+    }
+
+    // The simplex lives in unit coordinates u in [0, 1] for every free parameter. 
+    int n = free.size();
+    OptimizerResult result;
+    result.numEvaluations = 0;
+    auto toPoint = [&](const std::vector<double> &u) {
+        std::vector<double> x = x0;
+        for (int j = 0; j < n; j++) {
+            int i = free[j];
+            x[i] = lower[i] + std::min(std::max(u[j], 0.0), 1.0) * (upper[i] - lower[i]);
+        }
+        return x;
+    };
+    auto evaluate = [&](std::vector<double> &u) {
+        for (double &uj : u) {
+            uj = std::min(std::max(uj, 0.0), 1.0);
+        }
+        result.numEvaluations++;
+        return fn(toPoint(u));
+    };
+
+    std::vector<std::vector<double>> simplex(n + 1, std::vector<double>(n));
+    for (int j = 0; j < n; j++) {
+        int i = free[j];
+        simplex[0][j] = (x0[i] - lower[i]) / (upper[i] - lower[i]);
+    }
+    for (int j = 0; j < n; j++) {
+        simplex[j + 1] = simplex[0];
+        double step = simplex[0][j] + options.initialStep <= 1 ? 
+            options.initialStep : -options.initialStep;
+        simplex[j + 1][j] += step;
+    }
+    std::vector<double> values(n + 1);
+    for (int v = 0; v <= n; v++) {
+        values[v] = evaluate(simplex[v]);
+    }
+
+    std::vector<int> order(n + 1);
+    result.converged = false;
+    while (true) {
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](int a, int b) { return values[a] < values[b]; });
+        int best = order[0];
+        int worst = order[n];
+
+        double spread = values[worst] - values[best];
+        double size = 0;
+        for (int v = 0; v <= n; v++) {
+            for (int j = 0; j < n; j++) {
+                size = std::max(size, std::abs(simplex[v][j] - simplex[best][j]));
+            }
+        }
+        if (spread <= options.fTolerance && size <= options.xTolerance) {
+            result.converged = true;
+            break;
+        }
+        if (result.numEvaluations >= options.maxEvaluations) {
+            break;
+        }
+
+        std::vector<double> centroid(n, 0);
+        for (int v = 0; v < n; v++) {
+            for (int j = 0; j < n; j++) {
+                centroid[j] += simplex[order[v]][j] / n;
+            }
+        }
+        auto along = [&](double t) {
+            std::vector<double> u(n);
+            for (int j = 0; j < n; j++) {
+                u[j] = centroid[j] + t * (simplex[worst][j] - centroid[j]);
+            }
+            return u;
+        };
+
+        std::vector<double> reflected = along(-1);
+        double reflectedValue = evaluate(reflected);
+        if (reflectedValue < values[best]) {
+            std::vector<double> expanded = along(-2);
+            double expandedValue = evaluate(expanded);
+            if (expandedValue < reflectedValue) {
+                simplex[worst] = expanded;
+                values[worst] = expandedValue;
+            } else {
+                simplex[worst] = reflected;
+                values[worst] = reflectedValue;
+            }
+            continue;
+        }
+        if (reflectedValue < values[order[n - 1]]) {
+            simplex[worst] = reflected;
+            values[worst] = reflectedValue;
+            continue;
+        }
+
+        bool outside = reflectedValue < values[worst];
+        std::vector<double> contracted = along(outside ? -0.5 : 0.5);
+        double contractedValue = evaluate(contracted);
+        if (contractedValue < (outside ? reflectedValue : values[worst])) {
+            simplex[worst] = contracted;
+            values[worst] = contractedValue;
+            continue;
+        }
+
+        // Shrink every vertex towards the best one. 
+        for (int v = 0; v <= n; v++) {
+            if (v == best) continue;
+            for (int j = 0; j < n; j++) {
+                simplex[v][j] = simplex[best][j] + 0.5 * (simplex[v][j] - simplex[best][j]);
+            }
+            values[v] = evaluate(simplex[v]);
+        }
+    }
+
+    int best = std::min_element(values.begin(), values.end()) - values.begin();
+    result.x = toPoint(simplex[best]);
+    result.value = values[best];
+    return result;
+}
+
+OptimizerResult lbfgsb(
+    const std::function<double(const std::vector<double> &, std::vector<double> &)> &fn, 
+    std::vector<double> x0, const std::vector<double> &lower, const std::vector<double> &upper, 
+    const OptimizerOptions &options) {
+
+    int numParams = x0.size();
+    if (lower.size() != numParams || upper.size() != numParams) {
+        throw std::invalid_argument("x0, lower and upper must have the same size.");
+    }
+    std::vector<int> free;
+    for (int i = 0; i < numParams; i++) {
+        if (lower[i] > upper[i]) {
+            throw std::invalid_argument("lower bounds must not exceed upper bounds.");
+        }
+        x0[i] = std::min(std::max(x0[i], lower[i]), upper[i]);
+        if (lower[i] < upper[i]) {
+            free.push_back(i);
+        }
+    }
+
+    // As in nelderMead, the search runs in unit coordinates u in [0, 1]. 
+    int n = free.size();
+    OptimizerResult result;
+    result.numEvaluations = 0;
+    std::vector<double> gradient(numParams);
+    auto toPoint = [&](const std::vector<double> &u) {
+        std::vector<double> x = x0;
+        for (int j = 0; j < n; j++) {
+            int i = free[j];
+            x[i] = lower[i] + u[j] * (upper[i] - lower[i]);
+        }
+        return x;
+    };
+    auto evaluate = [&](const std::vector<double> &u, std::vector<double> &g) {
+        result.numEvaluations++;
+        double value = fn(toPoint(u), gradient);
+        for (int j = 0; j < n; j++) {
+            int i = free[j];
+            g[j] = gradient[i] * (upper[i] - lower[i]);
+        }
+        return value;
+    };
+    auto project = [](std::vector<double> &u) {
+        for (double &uj : u) {
+            uj = std::min(std::max(uj, 0.0), 1.0);
+        }
+    };
+    auto dot = [](const std::vector<double> &a, const std::vector<double> &b) {
+        double sum = 0;
+        for (int j = 0; j < a.size(); j++) {
+            sum += a[j] * b[j];
+        }
+        return sum;
+    };
+
+    std::vector<double> u(n);
+    for (int j = 0; j < n; j++) {
+        int i = free[j];
+        u[j] = (x0[i] - lower[i]) / (upper[i] - lower[i]);
+    }
+    std::vector<double> g(n);
+    double value = evaluate(u, g);
+    std::vector<std::vector<double>> steps, gradientSteps;
+    result.converged = false;
+    while (true) {
+        // Parameters at a bound whose gradient points outwards are held fixed for this step. 
+        std::vector<bool> active(n);
+        double projectedGradient = 0;
+        for (int j = 0; j < n; j++) {
+            active[j] = (u[j] <= 0 && g[j] > 0) || (u[j] >= 1 && g[j] < 0);
+            if (!active[j]) {
+                projectedGradient = std::max(projectedGradient, std::abs(g[j]));
+            }
+        }
+        if (projectedGradient <= options.gTolerance) {
+            result.converged = true;
+            break;
+        }
+        if (result.numEvaluations >= options.maxEvaluations) {
+            break;
+        }
+
+        // Two-loop recursion over the free parameters. 
+        std::vector<double> direction(n);
+        for (int j = 0; j < n; j++) {
+            direction[j] = active[j] ? 0 : -g[j];
+        }
+        int m = steps.size();
+        std::vector<double> alpha(m);
+        for (int k = m - 1; k >= 0; k--) {
+            alpha[k] = dot(steps[k], direction) / dot(gradientSteps[k], steps[k]);
+            for (int j = 0; j < n; j++) {
+                direction[j] -= alpha[k] * gradientSteps[k][j];
+            }
+        }
+        if (m > 0) {
+            double scale = dot(steps[m - 1], gradientSteps[m - 1]) / 
+                dot(gradientSteps[m - 1], gradientSteps[m - 1]);
+            for (double &dj : direction) {
+                dj *= scale;
+            }
+        } else {
+            // Without curvature information, the first step moves at most initialStep. 
+            double norm = std::sqrt(dot(direction, direction));
+            for (double &dj : direction) {
+                dj *= options.initialStep / norm;
+            }
+        }
+        for (int k = 0; k < m; k++) {
+            double beta = dot(gradientSteps[k], direction) / dot(gradientSteps[k], steps[k]);
+            for (int j = 0; j < n; j++) {
+                direction[j] += steps[k][j] * (alpha[k] - beta);
+            }
+        }
+        for (int j = 0; j < n; j++) {
+            if (active[j]) {
+                direction[j] = 0;
+            }
+        }
+        if (dot(direction, g) >= 0) {
+            // Not a descent direction; restart from steepest descent. 
+            steps.clear();
+            gradientSteps.clear();
+            for (int j = 0; j < n; j++) {
+                direction[j] = active[j] ? 0 : -g[j];
+            }
+        }
+
+        // Backtracking along the projected path with an Armijo condition. 
+        double t = 1;
+        std::vector<double> uNew(n), gNew(n);
+        double valueNew;
+        bool accepted = false;
+        while (result.numEvaluations < options.maxEvaluations) {
+            for (int j = 0; j < n; j++) {
+                uNew[j] = u[j] + t * direction[j];
+            }
+            project(uNew);
+            valueNew = evaluate(uNew, gNew);
+            double decrease = 0;
+            for (int j = 0; j < n; j++) {
+                decrease += g[j] * (uNew[j] - u[j]);
+            }
+            if (valueNew <= value + 1e-4 * decrease) {
+                accepted = true;
+                break;
+            }
+            t /= 2;
+        }
+        if (!accepted) {
+            break;
+        }
+
+        std::vector<double> step(n), gradientStep(n);
+        double size = 0;
+        for (int j = 0; j < n; j++) {
+            step[j] = uNew[j] - u[j];
+            gradientStep[j] = gNew[j] - g[j];
+            size = std::max(size, std::abs(step[j]));
+        }
+        if (dot(step, gradientStep) > 1e-12 * dot(step, step)) {
+            steps.push_back(step);
+            gradientSteps.push_back(gradientStep);
+            if (steps.size() > options.historySize) {
+                steps.erase(steps.begin());
+                gradientSteps.erase(gradientSteps.begin());
+            }
+        }
+        bool stalled = value - valueNew <= options.fTolerance && size <= options.xTolerance;
+        u = uNew;
+        g = gNew;
+        value = valueNew;
+        if (stalled) {
+            result.converged = true;
+            break;
+        }
+    }
+
+    result.x = toPoint(u);
+    result.value = value;
+    return result;
+}
@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "parameter_grid.h"
+
+
+ParameterGrid::ParameterGrid(
+    std::vector<std::string> names, std::vector<std::vector<float>> axes, bool storeValues) {
+
+    if (names.size() != axes.size()) {
+        throw std::invalid_argument("Every axis of a ParameterGrid needs a name.");
+    }
+    for (std::vector<float> &axis : axes) {
+        if (axis.empty()) {
+            throw std::invalid_argument("Every axis of a ParameterGrid must hold a value.");
+        }
+        std::sort(axis.begin(), axis.end());
+        axis.erase(std::unique(axis.begin(), axis.end()), axis.end());
+    }
+    this->names = names;
+    this->axes = axes;
+    this->strides.resize(axes.size());
+    size_t stride = 1;
+    for (int a = axes.size() - 1; a >= 0; a--) {
+        strides[a] = stride;
+        stride *= axes[a].size();
+    }
+    if (storeValues) {
+        this->values.assign(size(), NAN);
+    }
+}
+
+size_t ParameterGrid::size() const {
+    return axes.empty() ? 0 : strides[0] * axes[0].size();
+}
+
+size_t ParameterGrid::index(const std::vector<int> &coordinates) const {
+    size_t index = 0;
+    for (int a = 0; a < axes.size(); a++) {
+        index += coordinates[a] * strides[a];
+    }
+    return index;
+}
+
+std::vector<int> ParameterGrid::coordinates(size_t index) const {
+    std::vector<int> coordinates(axes.size());
+    for (int a = 0; a < axes.size(); a++) {
+        coordinates[a] = index / strides[a];
+        index %= strides[a];
+    }
+    return coordinates;
+}
+
+std::vector<float> ParameterGrid::parameters(size_t index) const {
+    std::vector<float> parameters(axes.size());
+    for (int a = 0; a < axes.size(); a++) {
+        parameters[a] = axes[a][index / strides[a]];
+        index %= strides[a];
+    }
+    return parameters;
+}
+
+long ParameterGrid::find(const std::vector<float> &parameters) const {
+    if (parameters.size() != axes.size() || axes.empty()) {
+        return -1;
+    }
+    size_t index = 0;
+    for (int a = 0; a < axes.size(); a++) {
+        auto it = std::lower_bound(axes[a].begin(), axes[a].end(), parameters[a]);
+        if (it == axes[a].end() || *it != parameters[a]) {
+            return -1;
+        }
+        index += (it - axes[a].begin()) * strides[a];
+    }
+    return index;
+}
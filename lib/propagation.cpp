@@ -0,0 +1,799 @@
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <mutex>
+#include <vector>
+#include "propagation.h"
+#include "stats.h"
+
+StateSpace::StateSpace(float barrier, float approxStateStep, float bias) {
+    int halfNumStateBins = ceil(barrier / approxStateStep);
+    this->stateStep = barrier / (halfNumStateBins + 0.5);
+    this->numStates = 2 * halfNumStateBins + 1;
+    this->states.resize(numStates);
+
+    float biasStateVal = FLT_MAX;
+    this->biasState = 0;
+    for (int i = 0; i < numStates; i++) {
+        states[i] = -barrier + (stateStep / 2) + (i * stateStep);
+        float r = std::abs(states[i] - bias);
+        if (r < biasStateVal) {
+            biasState = i;
+            biasStateVal = r;
+        }
+    }
+}
+
+double transitionKernelHalfWidth(float sigma, double tailMass) {
+    if (tailMass <= 0) {
+        return DBL_MAX;
+    }
+    return inverseCumulativeDensityFunction(0, sigma, 1 - tailMass / 2);
+}
+
+TransitionKernel::TransitionKernel(
+    const StateSpace &space, float mean, float sigma, double tailMass) {
+
+    int maxOffset = space.numStates - 1;
+    this->lo = -maxOffset;
+    this->hi = maxOffset;
+    if (tailMass > 0) {
+        double halfWidth = transitionKernelHalfWidth(sigma, tailMass);
+        lo = std::max(lo, (int) std::floor((mean - halfWidth) / space.stateStep));
+        hi = std::min(hi, (int) std::ceil((mean + halfWidth) / space.stateStep));
+        if (lo > hi) {
+            // The whole density lies beyond the state grid; keep the nearest offset. 
+            int nearest = std::lround(mean / space.stateStep);
+            lo = hi = std::min(std::max(nearest, -maxOffset), maxOffset);
+        }
+    }
+    this->weights.resize(hi - lo + 1);
+    for (int m = lo; m <= hi; m++) {
+        float x = m * space.stateStep;
+        weights[m - lo] = space.stateStep * probabilityDensityFunction(mean, sigma, x);
+    }
+}
+
+void TransitionKernel::apply(
+    const double *in, double *out, int numStates, int inLo, int inHi, 
+    int &outLo, int &outHi, int numColumns) const {
+
+    outLo = std::max(0, inLo + lo);
+    outHi = std::min(numStates - 1, inHi + hi);
+    if (outLo <= outHi) {
+        std::fill(out + outLo * numColumns, out + (outHi + 1) * numColumns, 0.0);
+    }
+    // Shifting every column by m states shifts the interleaved array by m * numColumns, so each 
+    // offset is one contiguous axpy over all columns. The inner loop is free of bounds checks so 
+    // that it vectorizes. 
+    for (int m = lo; m <= hi; m++) {
+        double w = weights[m - lo];
+        int begin = std::max(outLo, inLo + m) * numColumns;
+        int end = (std::min(outHi, inHi + m) + 1) * numColumns;
+        const double *src = in - m * numColumns;
+        #pragma GCC ivdep
+        for (int i = begin; i < end; i++) {
+            out[i] += w * src[i];
+        }
+    }
+}
+
+void TransitionKernel::applyTranspose(const double *in, double *out, int numStates) const {
+    std::fill(out, out + numStates, 0.0);
+    for (int m = lo; m <= hi; m++) {
+        double w = weights[m - lo];
+        int begin = std::max(0, -m);
+        int end = std::min(numStates, numStates - m);
+        const double *src = in + m;
+        #pragma GCC ivdep
+        for (int j = begin; j < end; j++) {
+            out[j] += w * src[j];
+        }
+    }
+}
+
+LaneKernel::LaneKernel(const std::vector<const TransitionKernel *> &kernels) {
+    this->numLanes = kernels.size();
+    this->lo = kernels[0]->lo;
+    this->hi = kernels[0]->hi;
+    for (const TransitionKernel *kernel : kernels) {
+        lo = std::min(lo, kernel->lo);
+        hi = std::max(hi, kernel->hi);
+    }
+    this->weights.assign((hi - lo + 1) * numLanes, 0);
+    for (int c = 0; c < numLanes; c++) {
+        const TransitionKernel &kernel = *kernels[c];
+        for (int m = kernel.lo; m <= kernel.hi; m++) {
+            weights[(m - lo) * numLanes + c] = kernel.weights[m - kernel.lo];
+        }
+    }
+}
+
+void LaneKernel::apply(
+    const double *in, double *out, int numStates, int inLo, int inHi, 
+    int &outLo, int &outHi) const {
+
+    const int B = numLanes;
+    outLo = std::max(0, inLo + lo);
+    outHi = std::min(numStates - 1, inHi + hi);
+    if (outLo <= outHi) {
+        std::fill(out + outLo * B, out + (outHi + 1) * B, 0.0);
+    }
+    // As in TransitionKernel::apply, but every lane has its own weight for offset m. 
+    for (int m = lo; m <= hi; m++) {
+        const double *w = &weights[(m - lo) * B];
+        int begin = std::max(outLo, inLo + m);
+        int end = std::min(outHi, inHi + m) + 1;
+        for (int i = begin; i < end; i++) {
+            double *row = out + i * B;
+            const double *src = in + (i - m) * B;
+            #pragma GCC ivdep
+            for (int c = 0; c < B; c++) {
+                row[c] += w[c] * src[c];
+            }
+        }
+    }
+}
+
+void computeCrossingCDFs(
+    const StateSpace &space, float mean, float sigma, float barrierUp, float barrierDown,
+    std::vector<double> &changeUpCDFs, std::vector<double> &changeDownCDFs) {
+
+    int numStates = space.numStates;
+    changeUpCDFs.resize(numStates);
+    changeDownCDFs.resize(numStates);
+    for (int i = 0; i < numStates; i++) {
+        changeUpCDFs[i] = 1 - cumulativeDensityFunction(mean, sigma, barrierUp - space.states[i]);
+        changeDownCDFs[i] = cumulativeDensityFunction(mean, sigma, barrierDown - space.states[i]);
+    }
+}
+
+KernelDerivatives::KernelDerivatives(
+    const StateSpace &space, const TransitionKernel &kernel, float mean, float sigma) {
+
+    dMean.lo = dSigma.lo = kernel.lo;
+    dMean.hi = dSigma.hi = kernel.hi;
+    dMean.weights.resize(kernel.weights.size());
+    dSigma.weights.resize(kernel.weights.size());
+    for (int m = kernel.lo; m <= kernel.hi; m++) {
+        // d/dmu pdf = pdf * z / sigma and d/dsigma pdf = pdf * (z^2 - 1) / sigma. 
+        float x = m * space.stateStep;
+        double z = (x - mean) / (double) sigma;
+        double w = kernel.weights[m - kernel.lo];
+        dMean.weights[m - kernel.lo] = w * z / sigma;
+        dSigma.weights[m - kernel.lo] = w * (z * z - 1) / sigma;
+    }
+}
+
+CrossingCDFDerivatives::CrossingCDFDerivatives(
+    const StateSpace &space, float mean, float sigma, float barrierUp, float barrierDown) {
+
+    int numStates = space.numStates;
+    changeUpDMean.resize(numStates);
+    changeUpDSigma.resize(numStates);
+    changeDownDMean.resize(numStates);
+    changeDownDSigma.resize(numStates);
+    for (int i = 0; i < numStates; i++) {
+        // With F = cdf((x - mu) / sigma), dF/dmu = -pdf(x) and dF/dsigma = -pdf(x) * z. 
+        float xUp = barrierUp - space.states[i];
+        float xDown = barrierDown - space.states[i];
+        double pdfUp = probabilityDensityFunction(mean, sigma, xUp);
+        double pdfDown = probabilityDensityFunction(mean, sigma, xDown);
+        changeUpDMean[i] = pdfUp;
+        changeUpDSigma[i] = pdfUp * (xUp - mean) / sigma;
+        changeDownDMean[i] = -pdfDown;
+        changeDownDSigma[i] = -pdfDown * (xDown - mean) / sigma;
+    }
+}
+
+SkipAheadOperator::SkipAheadOperator(
+    const StateSpace &space, const TransitionKernel &kernel, const CrossingCDFs &cdfs, 
+    int maxSteps) {
+
+    this->numStates = space.numStates;
+    this->maxSteps = maxSteps;
+    int N = numStates;
+
+    // M^(2^b) by repeated squaring, starting from the dense form of the kernel. 
+    std::vector<double> power(N * N, 0);
+    for (int i = 0; i < N; i++) {
+        for (int m = std::max(kernel.lo, i - (N - 1)); m <= std::min(kernel.hi, i); m++) {
+            power[i * N + (i - m)] = kernel.weights[m - kernel.lo];
+        }
+    }
+    powers.push_back(power);
+    for (int b = 1; (1 << b) <= maxSteps; b++) {
+        const std::vector<double> &prev = powers.back();
+        std::vector<double> squared(N * N, 0);
+        for (int i = 0; i < N; i++) {
+            for (int l = 0; l < N; l++) {
+                double a = prev[i * N + l];
+                if (a == 0) continue;
+                for (int j = 0; j < N; j++) {
+                    squared[i * N + j] += a * prev[l * N + j];
+                }
+            }
+        }
+        powers.push_back(squared);
+    }
+
+    sumRows.resize((maxSteps + 1) * N);
+    upRows.resize((maxSteps + 1) * N);
+    downRows.resize((maxSteps + 1) * N);
+    std::fill(sumRows.begin(), sumRows.begin() + N, 1.0);
+    std::copy(cdfs.changeUpCDFs.begin(), cdfs.changeUpCDFs.end(), upRows.begin());
+    std::copy(cdfs.changeDownCDFs.begin(), cdfs.changeDownCDFs.end(), downRows.begin());
+    for (int t = 0; t < maxSteps; t++) {
+        kernel.applyTranspose(&sumRows[t * N], &sumRows[(t + 1) * N], N);
+        kernel.applyTranspose(&upRows[t * N], &upRows[(t + 1) * N], N);
+        kernel.applyTranspose(&downRows[t * N], &downRows[(t + 1) * N], N);
+    }
+}
+
+void SkipAheadOperator::advance(
+    int numSteps, std::vector<double> &prStates, std::vector<double> &scratch, 
+    double *probUpCrossing, double *probDownCrossing, 
+    int &supportLo, int &supportHi, double supportEpsilon, int numColumns) const {
+
+    int N = numStates;
+    int B = numColumns;
+    const double *p = prStates.data();
+
+    // With q_t = M^t p, propagateStep keeps mass m_t = sum(p_t) and renormalizes by a factor that
+    // does not depend on the scale of p_t, so m_{t+1} = m_t * S(q_{t+1}) / (S(q_{t+1}) + X(q_t)),
+    // where S sums the states and X sums the crossing probabilities. 
+    std::vector<double> masses(B);
+    for (int c = 0; c < B; c++) {
+        double mass = 0;
+        for (int i = supportLo; i <= supportHi; i++) {
+            mass += p[i * B + c];
+        }
+        for (int t = 0; t < numSteps; t++) {
+            const double *sumRow = &sumRows[(t + 1) * N];
+            const double *upRow = &upRows[t * N];
+            const double *downRow = &downRows[t * N];
+            double sumNext = 0;
+            double up = 0;
+            double down = 0;
+            for (int i = supportLo; i <= supportHi; i++) {
+                sumNext += sumRow[i] * p[i * B + c];
+                up += upRow[i] * p[i * B + c];
+                down += downRow[i] * p[i * B + c];
+            }
+            double normFactor = mass / (sumNext + up + down);
+            if (t == numSteps - 1) {
+                probUpCrossing[c] = up * normFactor;
+                probDownCrossing[c] = down * normFactor;
+            }
+            mass = sumNext * normFactor;
+        }
+        masses[c] = mass;
+    }
+
+    // p_n is M^n p rescaled to the surviving mass. 
+    for (int b = 0; (1 << b) <= numSteps; b++) {
+        if (!(numSteps & (1 << b))) continue;
+        const std::vector<double> &power = powers[b];
+        for (int i = 0; i < N; i++) {
+            const double *row = &power[i * N];
+            for (int c = 0; c < B; c++) {
+                double sum = 0;
+                for (int j = supportLo; j <= supportHi; j++) {
+                    sum += row[j] * prStates[j * B + c];
+                }
+                scratch[i * B + c] = sum;
+            }
+        }
+        std::swap(prStates, scratch);
+        supportLo = 0;
+        supportHi = N - 1;
+    }
+    for (int c = 0; c < B; c++) {
+        double sumFinal = 0;
+        for (int i = 0; i < N; i++) {
+            sumFinal += prStates[i * B + c];
+        }
+        double scale = masses[c] / sumFinal;
+        for (int i = 0; i < N; i++) {
+            prStates[i * B + c] *= scale;
+        }
+    }
+    trimSupport(prStates, supportLo, supportHi, supportEpsilon, numColumns);
+}
+
+size_t SkipAheadOperator::numValues() const {
+    return powers.size() * numStates * numStates + sumRows.size() + upRows.size() + 
+        downRows.size();
+}
+
+PropagationCache::PropagationCache(size_t maxCachedValues) {
+    this->maxCachedValues = maxCachedValues;
+}
+
+std::shared_ptr<const TransitionKernel> PropagationCache::getTransitionKernel(
+    const StateSpace &space, float mean, float sigma, double tailMass) {
+
+    KernelKey key = std::make_tuple(mean, sigma, space.stateStep, space.numStates, tailMass);
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = kernels.find(key);
+        if (it != kernels.end()) {
+            return it->second;
+        }
+    }
+
+    auto kernel = std::make_shared<const TransitionKernel>(space, mean, sigma, tailMass);
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (numCachedValues + kernel->weights.size() > maxCachedValues) {
+        return kernel;
+    }
+    auto inserted = kernels.emplace(key, kernel);
+    if (inserted.second) {
+        numCachedValues += kernel->weights.size();
+    }
+    return inserted.first->second;
+}
+
+std::shared_ptr<const CrossingCDFs> PropagationCache::getCrossingCDFs(
+    const StateSpace &space, float mean, float sigma, float barrierUp, float barrierDown) {
+
+    CDFKey key = std::make_tuple(
+        mean, sigma, space.stateStep, space.numStates, barrierUp, barrierDown);
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = crossingCDFs.find(key);
+        if (it != crossingCDFs.end()) {
+            return it->second;
+        }
+    }
+
+    auto cdfs = std::make_shared<CrossingCDFs>();
+    computeCrossingCDFs(
+        space, mean, sigma, barrierUp, barrierDown, cdfs->changeUpCDFs, cdfs->changeDownCDFs);
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (numCachedValues + 2 * space.numStates > maxCachedValues) {
+        return cdfs;
+    }
+    auto inserted = crossingCDFs.emplace(key, cdfs);
+    if (inserted.second) {
+        numCachedValues += 2 * space.numStates;
+    }
+    return inserted.first->second;
+}
+
+std::vector<std::shared_ptr<const CrossingCDFs>> PropagationCache::getDecayingCrossingCDFs(
+    const StateSpace &space, float mean, float sigma, float barrier, float decay, 
+    int firstTime, int numSteps) {
+
+    std::vector<std::shared_ptr<const CrossingCDFs>> cdfs(std::max(numSteps, 0));
+    std::vector<float> barriersUp(cdfs.size());
+    for (int t = 0; t < cdfs.size(); t++) {
+        barriersUp[t] = barrier / (1 + (decay * (firstTime + t)));
+    }
+    bool complete = true;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        for (int t = 0; t < cdfs.size(); t++) {
+            auto it = crossingCDFs.find(std::make_tuple(
+                mean, sigma, space.stateStep, space.numStates, barriersUp[t], -barriersUp[t]));
+            if (it != crossingCDFs.end()) {
+                cdfs[t] = it->second;
+            } else {
+                complete = false;
+            }
+        }
+    }
+    for (int t = 0; !complete && t < cdfs.size(); t++) {
+        if (!cdfs[t]) {
+            cdfs[t] = getCrossingCDFs(space, mean, sigma, barriersUp[t], -barriersUp[t]);
+        }
+    }
+    return cdfs;
+}
+
+std::shared_ptr<const SkipAheadOperator> PropagationCache::getSkipAheadOperator(
+    const StateSpace &space, float mean, float sigma, double tailMass, float barrier, 
+    int numSteps) {
+
+    KernelKey kernelKey = std::make_tuple(
+        mean, sigma, space.stateStep, space.numStates, tailMass);
+    auto key = std::make_tuple(kernelKey, barrier, -barrier);
+    int maxSteps = numSteps;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = skipAheadOperators.find(key);
+        if (it != skipAheadOperators.end()) {
+            if (it->second->maxSteps >= numSteps) {
+                return it->second;
+            }
+            // Grow geometrically so that the rows are rebuilt a logarithmic number of times. 
+            maxSteps = std::max(numSteps, 2 * it->second->maxSteps);
+        }
+    }
+
+    int N = space.numStates;
+    size_t numValues = (size_t) (std::log2(maxSteps) + 1) * N * N + 3 * (size_t) (maxSteps + 1) * N;
+    if (numValues > maxCachedValues / 2) {
+        return nullptr;
+    }
+
+    std::shared_ptr<const TransitionKernel> kernel = getTransitionKernel(
+        space, mean, sigma, tailMass);
+    std::shared_ptr<const CrossingCDFs> cdfs = getCrossingCDFs(
+        space, mean, sigma, barrier, -barrier);
+    auto op = std::make_shared<const SkipAheadOperator>(space, *kernel, *cdfs, maxSteps);
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    std::shared_ptr<const SkipAheadOperator> &entry = skipAheadOperators[key];
+    if (entry && entry->maxSteps >= op->maxSteps) {
+        return entry;
+    }
+    if (entry) {
+        numCachedValues -= entry->numValues();
+    }
+    entry = op;
+    numCachedValues += op->numValues();
+    if (numCachedValues > maxCachedValues) {
+        // Operators are rarely shared between the models of a grid, so the operators of earlier 
+        // models are flushed to make room. Callers still holding one keep it alive. 
+        for (auto &other : skipAheadOperators) {
+            numCachedValues -= other.second->numValues();
+        }
+        skipAheadOperators.clear();
+        skipAheadOperators[key] = op;
+        numCachedValues += op->numValues();
+    }
+    return op;
+}
+
+size_t PropagationCache::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return numCachedValues;
+}
+
+void PropagationCache::clear() {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    kernels.clear();
+    crossingCDFs.clear();
+    skipAheadOperators.clear();
+    numCachedValues = 0;
+}
+
+/**
+ * @brief Whether every column of state i is at most supportEpsilon. 
+ */
+static bool isNegligible(
+    const std::vector<double> &prStates, int i, double supportEpsilon, int numColumns) {
+
+    for (int c = 0; c < numColumns; c++) {
+        if (prStates[i * numColumns + c] > supportEpsilon) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void trimSupport(
+    std::vector<double> &prStates, int &supportLo, int &supportHi, double supportEpsilon, 
+    int numColumns) {
+
+    while (supportLo <= supportHi && 
+        isNegligible(prStates, supportLo, supportEpsilon, numColumns)) {
+        std::fill_n(prStates.begin() + supportLo * numColumns, numColumns, 0.0);
+        supportLo++;
+    }
+    while (supportHi >= supportLo && 
+        isNegligible(prStates, supportHi, supportEpsilon, numColumns)) {
+        std::fill_n(prStates.begin() + supportHi * numColumns, numColumns, 0.0);
+        supportHi--;
+    }
+}
+
+/**
+ * @brief propagateStep for FixedColumns interleaved columns, or numColumns columns if 
+ * FixedColumns is 0. A compile-time column count lets the single column case keep unit strides. 
+ */
+template <int FixedColumns>
+static void propagateColumns(
+    const StateSpace &space, const TransitionKernel &kernel,
+    const std::vector<double> &changeUpCDFs, const std::vector<double> &changeDownCDFs,
+    float barrierUp, float barrierDown,
+    std::vector<double> &prStates, std::vector<double> &prStatesNew,
+    double *probUpCrossing, double *probDownCrossing, 
+    int &supportLo, int &supportHi, double supportEpsilon, int numColumns) {
+
+    const int B = FixedColumns > 0 ? FixedColumns : numColumns;
+    int newLo, newHi;
+    kernel.apply(
+        prStates.data(), prStatesNew.data(), space.numStates, supportLo, supportHi, 
+        newLo, newHi, B);
+    for (int i = newLo; i <= newHi; i++) {
+        if (space.states[i] > barrierUp || space.states[i] < barrierDown) {
+            std::fill_n(prStatesNew.begin() + i * B, B, 0.0);
+        }
+    }
+
+    int clearLo = std::min(supportLo, newLo);
+    int clearHi = std::max(supportHi, newHi);
+    if constexpr (FixedColumns == 1) {
+        double tempUpCross = 0;
+        double tempDownCross = 0;
+        double sumIn = 0;
+        double sumCurrent = 0;
+        for (int i = supportLo; i <= supportHi; i++) {
+            tempUpCross += changeUpCDFs[i] * prStates[i];
+            tempDownCross += changeDownCDFs[i] * prStates[i];
+            sumIn += prStates[i];
+        }
+        for (int i = newLo; i <= newHi; i++) {
+            sumCurrent += prStatesNew[i];
+        }
+        sumCurrent += tempUpCross + tempDownCross;
+
+        double normFactor = sumIn / sumCurrent;
+        for (int i = clearLo; i <= clearHi; i++) {
+            bool inSupport = i >= newLo && i <= newHi;
+            prStates[i] = inSupport ? prStatesNew[i] * normFactor : 0;
+        }
+        probUpCrossing[0] = tempUpCross * normFactor;
+        probDownCrossing[0] = tempDownCross * normFactor;
+    } else {
+        // Accumulate a whole row of columns at a time so that the inner loops are contiguous. 
+        // Every column still sums its states in the same order as a single column would. 
+        thread_local std::vector<double> sums;
+        sums.assign(4 * B, 0);
+        double *tempUpCross = &sums[0];
+        double *tempDownCross = &sums[B];
+        double *sumIn = &sums[2 * B];
+        double *sumCurrent = &sums[3 * B];
+        for (int i = supportLo; i <= supportHi; i++) {
+            const double *row = &prStates[i * B];
+            double up = changeUpCDFs[i];
+            double down = changeDownCDFs[i];
+            #pragma GCC ivdep
+            for (int c = 0; c < B; c++) {
+                tempUpCross[c] += up * row[c];
+                tempDownCross[c] += down * row[c];
+                sumIn[c] += row[c];
+            }
+        }
+        for (int i = newLo; i <= newHi; i++) {
+            const double *row = &prStatesNew[i * B];
+            #pragma GCC ivdep
+            for (int c = 0; c < B; c++) {
+                sumCurrent[c] += row[c];
+            }
+        }
+        double *normFactor = sumCurrent;
+        for (int c = 0; c < B; c++) {
+            normFactor[c] = sumIn[c] / (sumCurrent[c] + (tempUpCross[c] + tempDownCross[c]));
+            probUpCrossing[c] = tempUpCross[c] * normFactor[c];
+            probDownCrossing[c] = tempDownCross[c] * normFactor[c];
+        }
+        for (int i = clearLo; i <= clearHi; i++) {
+            double *row = &prStates[i * B];
+            if (i < newLo || i > newHi) {
+                std::fill(row, row + B, 0.0);
+                continue;
+            }
+            const double *rowNew = &prStatesNew[i * B];
+            #pragma GCC ivdep
+            for (int c = 0; c < B; c++) {
+                row[c] = rowNew[c] * normFactor[c];
+            }
+        }
+    }
+
+    supportLo = newLo;
+    supportHi = newHi;
+    trimSupport(prStates, supportLo, supportHi, supportEpsilon, numColumns);
+}
+
+void propagateStep(
+    const StateSpace &space, const TransitionKernel &kernel,
+    const std::vector<double> &changeUpCDFs, const std::vector<double> &changeDownCDFs,
+    float barrierUp, float barrierDown,
+    std::vector<double> &prStates, std::vector<double> &prStatesNew,
+    double *probUpCrossing, double *probDownCrossing, 
+    int &supportLo, int &supportHi, double supportEpsilon, int numColumns) {
+
+    if (numColumns == 1) {
+        propagateColumns<1>(
+            space, kernel, changeUpCDFs, changeDownCDFs, barrierUp, barrierDown, 
+            prStates, prStatesNew, probUpCrossing, probDownCrossing, 
+            supportLo, supportHi, supportEpsilon, numColumns);
+    } else {
+        propagateColumns<0>(
+            space, kernel, changeUpCDFs, changeDownCDFs, barrierUp, barrierDown, 
+            prStates, prStatesNew, probUpCrossing, probDownCrossing, 
+            supportLo, supportHi, supportEpsilon, numColumns);
+    }
+}
+
+void propagateLanesStep(
+    const StateSpace &space, const LaneKernel &kernel,
+    const std::vector<double> &changeUpCDFs, const std::vector<double> &changeDownCDFs,
+    float barrierUp, float barrierDown,
+    std::vector<double> &prStates, std::vector<double> &prStatesNew,
+    double *probUpCrossing, double *probDownCrossing, 
+    int &supportLo, int &supportHi, double supportEpsilon) {
+
+    const int B = kernel.numLanes;
+    int newLo, newHi;
+    kernel.apply(
+        prStates.data(), prStatesNew.data(), space.numStates, supportLo, supportHi, 
+        newLo, newHi);
+    for (int i = newLo; i <= newHi; i++) {
+        if (space.states[i] > barrierUp || space.states[i] < barrierDown) {
+            std::fill_n(prStatesNew.begin() + i * B, B, 0.0);
+        }
+    }
+
+    thread_local std::vector<double> sums;
+    sums.assign(4 * B, 0);
+    double *tempUpCross = &sums[0];
+    double *tempDownCross = &sums[B];
+    double *sumIn = &sums[2 * B];
+    double *sumCurrent = &sums[3 * B];
+    for (int i = supportLo; i <= supportHi; i++) {
+        const double *row = &prStates[i * B];
+        const double *up = &changeUpCDFs[i * B];
+        const double *down = &changeDownCDFs[i * B];
+        #pragma GCC ivdep
+        for (int c = 0; c < B; c++) {
+            tempUpCross[c] += up[c] * row[c];
+            tempDownCross[c] += down[c] * row[c];
+            sumIn[c] += row[c];
+        }
+    }
+    for (int i = newLo; i <= newHi; i++) {
+        const double *row = &prStatesNew[i * B];
+        #pragma GCC ivdep
+        for (int c = 0; c < B; c++) {
+            sumCurrent[c] += row[c];
+        }
+    }
+    double *normFactor = sumCurrent;
+    for (int c = 0; c < B; c++) {
+        normFactor[c] = sumIn[c] / (sumCurrent[c] + (tempUpCross[c] + tempDownCross[c]));
+        probUpCrossing[c] = tempUpCross[c] * normFactor[c];
+        probDownCrossing[c] = tempDownCross[c] * normFactor[c];
+    }
+
+    int clearLo = std::min(supportLo, newLo);
+    int clearHi = std::max(supportHi, newHi);
+    for (int i = clearLo; i <= clearHi; i++) {
+        double *row = &prStates[i * B];
+        if (i < newLo || i > newHi) {
+            std::fill(row, row + B, 0.0);
+            continue;
+        }
+        const double *rowNew = &prStatesNew[i * B];
+        #pragma GCC ivdep
+        for (int c = 0; c < B; c++) {
+            row[c] = rowNew[c] * normFactor[c];
+        }
+    }
+
+    supportLo = newLo;
+    supportHi = newHi;
+    trimSupport(prStates, supportLo, supportHi, supportEpsilon, B);
+}
+
+void propagateTangentStep(
+    const StateSpace &space, const TransitionKernel &kernel, 
+    const KernelDerivatives &kernelDerivatives, const CrossingCDFs &cdfs, 
+    const CrossingCDFDerivatives &cdfDerivatives, 
+    const std::vector<double> &meanSensitivities, const std::vector<double> &sigmaSensitivities,
+    float barrierUp, float barrierDown,
+    std::vector<double> &prStates, std::vector<double> &prStatesNew,
+    double *probUpCrossing, double *probDownCrossing, int &supportLo, int &supportHi) {
+
+    int numStates = space.numStates;
+    int P = meanSensitivities.size();
+    int B = P + 1;
+
+    // The kernel moves the distribution and every tangent alike. The tangents also pick up the 
+    // derivative of the kernel applied to the distribution. 
+    int newLo, newHi;
+    kernel.apply(
+        prStates.data(), prStatesNew.data(), numStates, supportLo, supportHi, newLo, newHi, B);
+    thread_local std::vector<double> column, gMean, gSigma;
+    column.assign(numStates, 0);
+    gMean.assign(numStates, 0);
+    gSigma.assign(numStates, 0);
+    for (int i = supportLo; i <= supportHi; i++) {
+        column[i] = prStates[i * B];
+    }
+    int lo, hi;
+    kernelDerivatives.dMean.apply(
+        column.data(), gMean.data(), numStates, supportLo, supportHi, lo, hi);
+    kernelDerivatives.dSigma.apply(
+        column.data(), gSigma.data(), numStates, supportLo, supportHi, lo, hi);
+    for (int i = newLo; i <= newHi; i++) {
+        if (space.states[i] > barrierUp || space.states[i] < barrierDown) {
+            std::fill_n(prStatesNew.begin() + i * B, B, 0.0);
+            continue;
+        }
+        for (int c = 1; c < B; c++) {
+            prStatesNew[i * B + c] += 
+                meanSensitivities[c - 1] * gMean[i] + sigmaSensitivities[c - 1] * gSigma[i];
+        }
+    }
+
+    thread_local std::vector<double> sums;
+    sums.assign(5 * B, 0);
+    double *tempUpCross = &sums[0];
+    double *tempDownCross = &sums[B];
+    double *sumIn = &sums[2 * B];
+    double *sumCurrent = &sums[3 * B];
+    double *dNormFactor = &sums[4 * B];
+    for (int i = supportLo; i <= supportHi; i++) {
+        const double *row = &prStates[i * B];
+        double up = cdfs.changeUpCDFs[i];
+        double down = cdfs.changeDownCDFs[i];
+        for (int c = 0; c < B; c++) {
+            tempUpCross[c] += up * row[c];
+            tempDownCross[c] += down * row[c];
+            sumIn[c] += row[c];
+        }
+        for (int c = 1; c < B; c++) {
+            tempUpCross[c] += row[0] * (
+                meanSensitivities[c - 1] * cdfDerivatives.changeUpDMean[i] + 
+                sigmaSensitivities[c - 1] * cdfDerivatives.changeUpDSigma[i]);
+            tempDownCross[c] += row[0] * (
+                meanSensitivities[c - 1] * cdfDerivatives.changeDownDMean[i] + 
+                sigmaSensitivities[c - 1] * cdfDerivatives.changeDownDSigma[i]);
+        }
+    }
+    for (int i = newLo; i <= newHi; i++) {
+        for (int c = 0; c < B; c++) {
+            sumCurrent[c] += prStatesNew[i * B + c];
+        }
+    }
+    for (int c = 0; c < B; c++) {
+        sumCurrent[c] += tempUpCross[c] + tempDownCross[c];
+    }
+
+    // Quotient rule on normFactor = sumIn / sumCurrent. 
+    double normFactor = sumIn[0] / sumCurrent[0];
+    for (int c = 1; c < B; c++) {
+        dNormFactor[c] = (sumIn[c] - normFactor * sumCurrent[c]) / sumCurrent[0];
+    }
+    probUpCrossing[0] = tempUpCross[0] * normFactor;
+    probDownCrossing[0] = tempDownCross[0] * normFactor;
+    for (int c = 1; c < B; c++) {
+        probUpCrossing[c] = tempUpCross[c] * normFactor + tempUpCross[0] * dNormFactor[c];
+        probDownCrossing[c] = tempDownCross[c] * normFactor + tempDownCross[0] * dNormFactor[c];
+    }
+
+    int clearLo = std::min(supportLo, newLo);
+    int clearHi = std::max(supportHi, newHi);
+    for (int i = clearLo; i <= clearHi; i++) {
+        double *row = &prStates[i * B];
+        if (i < newLo || i > newHi) {
+            std::fill(row, row + B, 0.0);
+            continue;
+        }
+        const double *rowNew = &prStatesNew[i * B];
+        row[0] = rowNew[0] * normFactor;
+        for (int c = 1; c < B; c++) {
+            row[c] = rowNew[c] * normFactor + rowNew[0] * dNormFactor[c];
+        }
+    }
+
+    // Tangents may be negative, so only rows that are zero in every column are dropped. 
+    auto isZero = [&](int i) {
+        return std::all_of(
+            prStates.begin() + i * B, prStates.begin() + (i + 1) * B, 
+            [](double p) { return p == 0; });
+    };
+    supportLo = newLo;
+    supportHi = newHi;
+    while (supportLo <= supportHi && isZero(supportLo)) {
+        supportLo++;
+    }
+    while (supportHi >= supportLo && isZero(supportHi)) {
+        supportHi--;
+    }
+}
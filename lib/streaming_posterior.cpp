@@ -0,0 +1,49 @@
+#include <cmath>
+#include "streaming_posterior.h"
+
+
+StreamingPosterior::StreamingPosterior(const ParameterGrid &grid) {
+    this->grid = ParameterGrid(grid.names, grid.axes, false);
+    this->shift = -INFINITY;
+    this->normalizer = 0;
+    for (const std::vector<float> &axis : grid.axes) {
+        marginalSums.push_back(std::vector<double>(axis.size(), 0));
+    }
+}
+
+void StreamingPosterior::add(size_t index, double logLikelihood) {
+    if (logLikelihood > shift) {
+        double scale = std::isinf(shift) ? 0 : exp(shift - logLikelihood);
+        normalizer *= scale;
+        for (std::vector<double> &sums : marginalSums) {
+            for (double &sum : sums) {
+                sum *= scale;
+            }
+        }
+        shift = logLikelihood;
+    }
+    double weight = exp(logLikelihood - shift);
+    normalizer += weight;
+    std::vector<int> coordinates = grid.coordinates(index);
+    for (int a = 0; a < coordinates.size(); a++) {
+        marginalSums[a][coordinates[a]] += weight;
+    }
+}
+
+double StreamingPosterior::logNormalizer() const {
+    return normalizer > 0 ? shift + log(normalizer) : -INFINITY;
+}
+
+double StreamingPosterior::posterior(double logLikelihood) const {
+    return exp(logLikelihood - logNormalizer());
+}
+
+std::vector<std::vector<double>> StreamingPosterior::marginals() const {
+    std::vector<std::vector<double>> marginals = marginalSums;
+    for (std::vector<double> &axis : marginals) {
+        for (double &marginal : axis) {
+            marginal = normalizer > 0 ? marginal / normalizer : 0;
+        }
+    }
+    return marginals;
+}
@@ -0,0 +1,103 @@
+#include <stdexcept>
+#include "trial_batch.h"
+
+
+TrialBatch::TrialBatch(const vector<DDMTrial> &trials) {
+    RT.reserve(trials.size());
+    choice.reserve(trials.size());
+    valueLeft.reserve(trials.size());
+    valueRight.reserve(trials.size());
+    fixOffsets.assign(trials.size() + 1, 0);
+    for (const DDMTrial &trial : trials) {
+        RT.push_back(trial.RT);
+        choice.push_back(trial.choice);
+        valueLeft.push_back(trial.valueLeft);
+        valueRight.push_back(trial.valueRight);
+    }
+}
+
+TrialBatch::TrialBatch(const vector<aDDMTrial> &trials) {
+    size_t numFixations = 0;
+    for (const aDDMTrial &trial : trials) {
+        if (trial.fixItem.size() != trial.fixTime.size()) {
+            throw std::invalid_argument(
+                "Every trial must have as many fixation times as fixation items.");
+        }
+        numFixations += trial.fixItem.size();
+    }
+    RT.reserve(trials.size());
+    choice.reserve(trials.size());
+    valueLeft.reserve(trials.size());
+    valueRight.reserve(trials.size());
+    fixOffsets.reserve(trials.size() + 1);
+    fixItem.reserve(numFixations);
+    fixTime.reserve(numFixations);
+    for (const aDDMTrial &trial : trials) {
+        RT.push_back(trial.RT);
+        choice.push_back(trial.choice);
+        valueLeft.push_back(trial.valueLeft);
+        valueRight.push_back(trial.valueRight);
+        fixItem.insert(fixItem.end(), trial.fixItem.begin(), trial.fixItem.end());
+        fixTime.insert(fixTime.end(), trial.fixTime.begin(), trial.fixTime.end());
+        fixOffsets.push_back(fixItem.size());
+    }
+}
+
+TrialBatch::TrialBatch(const TrialStore &store) {
+    size_t n = store.size();
+    RT.assign(store.RTs(), store.RTs() + n);
+    choice.assign(store.choices(), store.choices() + n);
+    valueLeft.assign(store.valuesLeft(), store.valuesLeft() + n);
+    valueRight.assign(store.valuesRight(), store.valuesRight() + n);
+    fixOffsets.assign(store.fixOffsets(), store.fixOffsets() + n + 1);
+    fixItem.assign(store.fixItems(), store.fixItems() + store.numFixations());
+    fixTime.assign(store.fixTimes(), store.fixTimes() + store.numFixations());
+}
+
+aDDMTrial TrialBatch::trial(size_t index) const {
+    return aDDMTrial(
+        RT[index], choice[index], valueLeft[index], valueRight[index],
+        vector<int>(fixItem.begin() + fixOffsets[index], fixItem.begin() + fixOffsets[index + 1]),
+        vector<int>(fixTime.begin() + fixOffsets[index], fixTime.begin() + fixOffsets[index + 1]));
+}
+
+vector<aDDMTrial> TrialBatch::aDDMTrials() const {
+    vector<aDDMTrial> trials;
+    trials.reserve(size());
+    for (size_t i = 0; i < size(); i++) {
+        trials.push_back(trial(i));
+    }
+    return trials;
+}
+
+vector<DDMTrial> TrialBatch::DDMTrials() const {
+    vector<DDMTrial> trials;
+    trials.reserve(size());
+    for (size_t i = 0; i < size(); i++) {
+        trials.push_back(DDMTrial(RT[i], choice[i], valueLeft[i], valueRight[i]));
+    }
+    return trials;
+}
+
+TrialBatch TrialBatch::subset(const vector<size_t> &indices) const {
+    TrialBatch batch;
+    batch.RT.reserve(indices.size());
+    batch.choice.reserve(indices.size());
+    batch.valueLeft.reserve(indices.size());
+    batch.valueRight.reserve(indices.size());
+    batch.fixOffsets.reserve(indices.size() + 1);
+    for (size_t i : indices) {
+        batch.RT.push_back(RT[i]);
+        batch.choice.push_back(choice[i]);
+        batch.valueLeft.push_back(valueLeft[i]);
+        batch.valueRight.push_back(valueRight[i]);
+        batch.fixItem.insert(
+            batch.fixItem.end(), 
+            fixItem.begin() + fixOffsets[i], fixItem.begin() + fixOffsets[i + 1]);
+        batch.fixTime.insert(
+            batch.fixTime.end(), 
+            fixTime.begin() + fixOffsets[i], fixTime.begin() + fixOffsets[i + 1]);
+        batch.fixOffsets.push_back(batch.fixItem.size());
+    }
+    return batch;
+}
@@ -0,0 +1,237 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "trial_store.h"
+#include "util.h"
+
+namespace {
+
+const char STORE_MAGIC[8] = {'A', 'D', 'D', 'M', 'T', 'R', 'L', 'S'};
+const uint32_t STORE_BYTE_ORDER = 0x01020304;
+
+/**
+ * @brief Columns of a trial store, assembled in memory before they are written. 
+ * 
+ */
+struct StoreColumns {
+    std::vector<int32_t> subject;
+    std::vector<uint32_t> RT;
+    std::vector<int32_t> choice;
+    std::vector<int32_t> valueLeft;
+    std::vector<int32_t> valueRight;
+    std::vector<uint64_t> fixOffsets = {0};
+    std::vector<int32_t> fixItem;
+    std::vector<int32_t> fixTime;
+
+    void add(int subject, const DDMTrial &trial) {
+        this->subject.push_back(subject);
+        this->RT.push_back(trial.RT);
+        this->choice.push_back(trial.choice);
+        this->valueLeft.push_back(trial.valueLeft);
+        this->valueRight.push_back(trial.valueRight);
+        this->fixOffsets.push_back(fixItem.size());
+    }
+
+    void add(int subject, const aDDMTrial &trial) {
+        fixItem.insert(fixItem.end(), trial.fixItem.begin(), trial.fixItem.end());
+        fixTime.insert(fixTime.end(), trial.fixTime.begin(), trial.fixTime.end());
+        add(subject, static_cast<const DDMTrial &>(trial));
+    }
+};
+
+/**
+ * @brief Write the columns to a store file. The file is written under a unique temporary name 
+ * and renamed once complete, so processes mapping the store never see a partial file and 
+ * concurrent writers never share a temporary file. 
+ * 
+ * @param filename File to store the trials in. 
+ * @param columns Columns of the store. 
+ */
+void writeStore(const std::string &filename, const StoreColumns &columns) {
+    TrialStoreHeader header = {};
+    std::memcpy(header.magic, STORE_MAGIC, sizeof(STORE_MAGIC));
+    header.version = TrialStore::version;
+    header.byteOrder = STORE_BYTE_ORDER;
+    header.numTrials = columns.subject.size();
+    header.numFixations = columns.fixItem.size();
+
+    std::vector<std::pair<const char *, size_t>> data = {
+        {(const char *) columns.subject.data(), columns.subject.size() * sizeof(int32_t)},
+        {(const char *) columns.RT.data(), columns.RT.size() * sizeof(uint32_t)},
+        {(const char *) columns.choice.data(), columns.choice.size() * sizeof(int32_t)},
+        {(const char *) columns.valueLeft.data(), columns.valueLeft.size() * sizeof(int32_t)},
+        {(const char *) columns.valueRight.data(), columns.valueRight.size() * sizeof(int32_t)},
+        {(const char *) columns.fixOffsets.data(), columns.fixOffsets.size() * sizeof(uint64_t)},
+        {(const char *) columns.fixItem.data(), columns.fixItem.size() * sizeof(int32_t)},
+        {(const char *) columns.fixTime.data(), columns.fixTime.size() * sizeof(int32_t)},
+    };
+    uint64_t offset = sizeof(TrialStoreHeader);
+    for (int c = 0; c < data.size(); c++) {
+        offset = (offset + 7) / 8 * 8;
+        header.columns[c] = offset;
+        offset += data[c].second;
+    }
+
+    // mkstemp creates a name no other writer uses, next to the target so rename stays atomic. 
+    std::string temporary = filename + ".XXXXXX";
+    int descriptor = mkstemp(&temporary[0]);
+    if (descriptor < 0) {
+        throw std::invalid_argument("Unable to write " + filename + ".");
+    }
+    fchmod(descriptor, 0644);
+    close(descriptor);
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::remove(temporary.c_str());
+        throw std::invalid_argument("Unable to write " + filename + ".");
+    }
+    file.write((const char *) &header, sizeof(header));
+    const char padding[8] = {};
+    uint64_t position = sizeof(header);
+    for (int c = 0; c < data.size(); c++) {
+        file.write(padding, header.columns[c] - position);
+        file.write(data[c].first, data[c].second);
+        position = header.columns[c] + data[c].second;
+    }
+    file.close();
+    if (!file || std::rename(temporary.c_str(), filename.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw std::invalid_argument("Unable to write " + filename + ".");
+    }
+}
+
+}
+
+
+TrialStore::TrialStore(const std::string &filename) {
+    this->file = std::make_shared<MappedFile>(filename);
+    this->header = reinterpret_cast<const TrialStoreHeader *>(file->data());
+    if (file->size() < sizeof(TrialStoreHeader) ||
+        std::memcmp(header->magic, STORE_MAGIC, sizeof(STORE_MAGIC)) != 0) {
+        throw std::invalid_argument(filename + " is not a trial store.");
+    }
+    if (header->byteOrder != STORE_BYTE_ORDER) {
+        throw std::invalid_argument(filename + " was written with a different byte order.");
+    }
+    if (header->version != version) {
+        throw std::invalid_argument(
+            filename + " has version " + std::to_string(header->version) +
+            ", expected version " + std::to_string(version) + ".");
+    }
+    uint64_t n = header->numTrials, f = header->numFixations;
+    // Every column fits in the file, so counts beyond it are corrupt, and rejecting them first 
+    // keeps the column sizes below from overflowing. 
+    if (n >= file->size() / 8 || f > file->size() / 4) {
+        throw std::invalid_argument(filename + " is truncated or corrupt.");
+    }
+    std::vector<uint64_t> sizes = {
+        4 * n, 4 * n, 4 * n, 4 * n, 4 * n, 8 * (n + 1), 4 * f, 4 * f};
+    for (int c = 0; c < sizes.size(); c++) {
+        if (header->columns[c] % 8 != 0 || header->columns[c] > file->size() ||
+            sizes[c] > file->size() - header->columns[c]) {
+            throw std::invalid_argument(filename + " is truncated or corrupt.");
+        }
+    }
+    // The fixations of a trial are read from offsets[i] to offsets[i + 1] without bounds checks. 
+    const uint64_t *offsets = fixOffsets();
+    if (offsets[0] != 0 || offsets[n] != f) {
+        throw std::invalid_argument(filename + " is truncated or corrupt.");
+    }
+    for (uint64_t i = 0; i < n; i++) {
+        if (offsets[i] > offsets[i + 1]) {
+            throw std::invalid_argument(filename + " has decreasing fixation offsets.");
+        }
+    }
+}
+
+aDDMTrial TrialStore::trial(size_t index) const {
+    const uint64_t *offsets = fixOffsets();
+    return aDDMTrial(
+        RTs()[index], choices()[index], valuesLeft()[index], valuesRight()[index],
+        std::vector<int>(fixItems() + offsets[index], fixItems() + offsets[index + 1]),
+        std::vector<int>(fixTimes() + offsets[index], fixTimes() + offsets[index + 1]));
+}
+
+vector<aDDMTrial> TrialStore::aDDMTrials() const {
+    vector<aDDMTrial> trials;
+    trials.reserve(size());
+    for (size_t i = 0; i < size(); i++) {
+        trials.push_back(trial(i));
+    }
+    return trials;
+}
+
+vector<DDMTrial> TrialStore::DDMTrials() const {
+    vector<DDMTrial> trials;
+    trials.reserve(size());
+    for (size_t i = 0; i < size(); i++) {
+        trials.push_back(DDMTrial(RTs()[i], choices()[i], valuesLeft()[i], valuesRight()[i]));
+    }
+    return trials;
+}
+
+std::map<int, std::vector<aDDMTrial>> TrialStore::subjectTrials() const {
+    std::map<int, std::vector<aDDMTrial>> data;
+    for (size_t i = 0; i < size(); i++) {
+        data[subjects()[i]].push_back(trial(i));
+    }
+    return data;
+}
+
+void TrialStore::save(
+    const std::string &filename, const std::map<int, std::vector<aDDMTrial>> &data) {
+    StoreColumns columns;
+    for (const auto &subject : data) {
+        for (const aDDMTrial &trial : subject.second) {
+            columns.add(subject.first, trial);
+        }
+    }
+    writeStore(filename, columns);
+}
+
+void TrialStore::save(
+    const std::string &filename, const vector<aDDMTrial> &trials, int subject) {
+    StoreColumns columns;
+    for (const aDDMTrial &trial : trials) {
+        columns.add(subject, trial);
+    }
+    writeStore(filename, columns);
+}
+
+void TrialStore::save(
+    const std::string &filename, const vector<DDMTrial> &trials, int subject) {
+    StoreColumns columns;
+    for (const DDMTrial &trial : trials) {
+        columns.add(subject, trial);
+    }
+    writeStore(filename, columns);
+}
+
+void TrialStore::convertCSV(
+    const std::string &csvFilename, const std::string &storeFilename,
+    const std::string &fixDataFilename) {
+
+    std::ifstream csv(csvFilename);
+    if (!csv) {
+        throw std::invalid_argument("Unable to open " + csvFilename + ".");
+    }
+    std::string header;
+    std::getline(csv, header);
+    csv.close();
+    std::string firstColumn = header.substr(0, header.find(','));
+    if (firstColumn == "parcode") {
+        save(storeFilename, loadDataFromCSV(csvFilename, fixDataFilename));
+    } else if (firstColumn == "trial") {
+        save(storeFilename, aDDMTrial::loadTrialsFromCSV(csvFilename));
+    } else if (firstColumn == "choice") {
+        save(storeFilename, DDMTrial::loadTrialsFromCSV(csvFilename));
+    } else {
+        throw std::invalid_argument(
+            "Unknown CSV layout of " + csvFilename + ": the header must start with parcode, "
+            "trial or choice.");
+    }
+}
@@ -1,157 +1,348 @@
 #include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <cassert>
 #include <set>
 #include <cmath> 
 #include <fstream>
 #include <functional>
+#include <tuple>
+#include <unordered_map>
 #include <vector> 
 #include "util.h"
 #include "addm.h"
+#include "mapped_file.h"
 
-vector<string> validComputeMethods = {"basic", "thread"};
+vector<string> validComputeMethods = {"basic", "thread", "gpu", "auto"};
 
-std::map<int, std::vector<aDDMTrial>> loadDataFromSingleCSV(std::string filename) {
+BS::thread_pool &getThreadPool(int numThreads) {
+    static std::mutex mutex;
+    static std::map<int, std::unique_ptr<BS::thread_pool>> pools;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<BS::thread_pool> &pool = pools[numThreads];
+    if (!pool) {
+        pool = std::make_unique<BS::thread_pool>(numThreads);
+    }
+    return *pool;
+}
+
+std::map<int, std::vector<aDDMTrial>> loadDataFromSingleCSV(const std::string &filename) {
     std::map<int, std::vector<aDDMTrial>> data; 
-    std::vector<aDDMTrial> trials = aDDMTrial::loadTrialsFromCSV(filename);
-    data.insert({0, trials});
+    data.insert({0, aDDMTrial::loadTrialsFromCSV(filename)});
     return data; 
 }
 
-std::map<int, std::vector<aDDMTrial>> loadDataFromCSV(
-    std::string expDataFilename, 
-    std::string fixDataFilename) {
+namespace {
 
-    // subjectID -> aDDM Trials
-    std::map<int, std::vector<aDDMTrial>> data;
-    std::map<int, std::vector<expEntry>> IDtoEXP;
-    std::set<int> subjectIDs;
+/**
+ * @brief Integer fields of the rows of a CSV file, parsed from a range of whole lines. 
+ * 
+ */
+struct ParsedLines {
+    std::vector<std::array<int, 6>> rows; /**< Fields of every well-formed row, in file order. */
+    std::vector<std::pair<size_t, std::string>> errors; /**< Line within the range and reason 
+        of every malformed row. */
+    size_t numLines = 0; /**< Number of lines in the range. */
+};
 
+/**
+ * @brief Parse an integer field. A fractional part is accepted and dropped, as std::stoi does, 
+ * so that response times written as 1962.000000 load as 1962. 
+ * 
+ * @param begin First character of the field, without surrounding spaces. 
+ * @param end One past the last character of the field. 
+ * @param value Parsed integer. 
+ * @return true if the whole field is an integer. 
+ */
+bool parseInteger(const char *begin, const char *end, int &value) {
+    if (begin != end && *begin == '+') {
+        begin++;
+    }
+    std::from_chars_result result = std::from_chars(begin, end, value);
+    if (result.ec != std::errc() || result.ptr == begin) {
+        return false;
+    }
+    const char *p = result.ptr;
+    if (p != end && *p == '.') {
+        for (p++; p != end && *p >= '0' && *p <= '9'; p++);
+    }
+    return p == end;
+}
+
+/**
+ * @brief Parse the lines of [begin, end), each holding numFields comma-separated integers. The 
+ * first field is the subject ID, which is hashed when it is not an integer. 
+ * 
+ * @param begin First character of a line. 
+ * @param end One past the newline that ends the last line, or the end of the file. 
+ * @param numFields Number of fields of every row. At most 6. 
+ * @return ParsedLines with the rows and the malformed lines of the range. 
+ */
+ParsedLines parseLines(const char *begin, const char *end, int numFields) {
+    ParsedLines parsed;
     std::hash<std::string> hashFn; 
-    std::ifstream expFile(expDataFilename);
-    std::vector<expEntry> expData;
-    std::string eline;
-    std::getline(expFile, eline);
-    while (std::getline(expFile, eline)) {
-        std::stringstream ss(eline);
-        std::string field;
-        expEntry entry;
-        std::getline(ss, field, ',');        
-        try {
-            entry.parcode = std::stoi(field);
-        } 
-        catch (std::invalid_argument& e) {
-            entry.parcode = hashFn(field);
+    for (const char *line = begin; line < end; parsed.numLines++) {
+        const char *lineEnd = std::find(line, end, '\n');
+        const char *next = lineEnd == end ? end : lineEnd + 1;
+        if (lineEnd != line && *(lineEnd - 1) == '\r') {
+            lineEnd--;
+        }
+        if (lineEnd == line) {
+            line = next;
+            continue;
+        }
+
+        std::array<int, 6> row;
+        int numFound = 0;
+        std::string error;
+        for (const char *field = line; field <= lineEnd && error.empty(); numFound++) {
+            const char *fieldEnd = std::find(field, lineEnd, ',');
+            const char *first = field, *last = fieldEnd;
+            for (; first < last && *first == ' '; first++);
+            for (; last > first && *(last - 1) == ' '; last--);
+            if (numFound < numFields && !parseInteger(first, last, row[numFound])) {
+                if (numFound == 0 && first != last) {
+                    row[0] = hashFn(std::string(first, last));
+                } else {
+                    error = "field " + std::to_string(numFound + 1) + " ('" + 
+                        std::string(first, last) + "') is not an integer";
+                }
+            }
+            field = fieldEnd + 1;
+        }
+        if (error.empty() && numFound != numFields) {
+            error = "expected " + std::to_string(numFields) + " fields, found " + 
+                std::to_string(numFound);
         }
-        std::getline(ss, field, ',');
-        entry.trial = std::stoi(field);
-        std::getline(ss, field, ',');
-        entry.rt = std::stoi(field);
-        std::getline(ss, field, ',');
-        entry.choice = std::stoi(field);
-        std::getline(ss, field, ',');
-        entry.item_left = std::stoi(field);
-        std::getline(ss, field, ',');
-        entry.item_right = std::stoi(field);
-        expData.push_back(entry);
-        if (IDtoEXP.count(entry.parcode)) {
-            IDtoEXP.at(entry.parcode).push_back(entry);
+        if (error.empty()) {
+            parsed.rows.push_back(row);
         } else {
-            IDtoEXP.insert({entry.parcode, {}});
+            parsed.errors.push_back({parsed.numLines, error});
         }
-        subjectIDs.insert(entry.parcode);
+        line = next;
     }
-    expFile.close();
+    return parsed;
+}
+
+/**
+ * @brief Parse a CSV file of integers with a header line. The file is memory mapped and split 
+ * into line-aligned chunks that are parsed in parallel. 
+ * 
+ * @param filename Name of the CSV file. 
+ * @param numFields Number of fields of every row. At most 6. 
+ * @param numThreads Number of threads to use. 0 uses every available core. 
+ * @return std::vector<std::array<int, 6>> with the fields of every row, in file order. 
+ * @throws std::invalid_argument listing the file, line and reason of the malformed rows. 
+ */
+std::vector<std::array<int, 6>> parseIntegerCSV(
+    const std::string &filename, int numFields, int numThreads) {
+
+    MappedFile file(filename);
+    const char *text = file.data();
+    const char *end = text + file.size();
+    const char *body = text ? std::find(text, end, '\n') : end;
+    body = body == end ? end : body + 1;
 
-    for (int subjectID : subjectIDs) {
-        data.insert({subjectID, {}});
-        std::set<int> trialIDs;
-        for (expEntry e : expData) {
-            if (e.parcode == subjectID) {
-                trialIDs.insert(e.trial);
+    // Chunks of about 1 MB, each extended to the end of its last line. 
+    const size_t chunkSize = 1 << 20;
+    std::vector<const char *> bounds = {body};
+    while (bounds.back() < end) {
+        const char *bound = bounds.back() + std::min(chunkSize, (size_t) (end - bounds.back()));
+        bound = std::find(bound, end, '\n');
+        bounds.push_back(bound == end ? end : bound + 1);
+    }
+    int numChunks = bounds.size() - 1;
+    std::vector<ParsedLines> chunks(numChunks);
+    parallelFor(numChunks, numThreads, [&](int c) {
+        chunks[c] = parseLines(bounds[c], bounds[c + 1], numFields);
+    });
+
+    std::vector<std::array<int, 6>> rows;
+    std::string diagnostics;
+    size_t numErrors = 0;
+    size_t firstLine = 2;
+    for (const ParsedLines &chunk : chunks) {
+        rows.insert(rows.end(), chunk.rows.begin(), chunk.rows.end());
+        for (const auto &error : chunk.errors) {
+            if (numErrors++ < 10) {
+                diagnostics += "\n" + filename + ":" + std::to_string(firstLine + error.first) + 
+                    ": " + error.second;
             }
         }
-        std::vector<int> dataTrial;
-        for (int trialID : trialIDs) {
-            for (expEntry e : expData) {
-                if (e.trial == trialID && e.parcode == subjectID) {
-                    data.at(subjectID).push_back(
-                        aDDMTrial(e.rt, e.choice, e.item_left, e.item_right)
-                    );
-                }   
-            }
+        firstLine += chunk.numLines;
+    }
+    if (numErrors) {
+        if (numErrors > 10) {
+            diagnostics += "\n... and " + std::to_string(numErrors - 10) + " more";
         }
+        throw std::invalid_argument(
+            std::to_string(numErrors) + " malformed rows in " + filename + ":" + diagnostics);
     }
+    return rows;
+}
+
+}
+
+std::map<int, std::vector<aDDMTrial>> loadDataFromCSV(
+    const std::string &expDataFilename, 
+    const std::string &fixDataFilename, 
+    int numThreads) {
+
+    std::vector<std::array<int, 6>> expRows = parseIntegerCSV(expDataFilename, 6, numThreads);
+    std::vector<std::array<int, 6>> fixRows = parseIntegerCSV(fixDataFilename, 4, numThreads);
 
-    std::ifstream fixFile(fixDataFilename);
-    std::vector<fixEntry> fixData;
-    subjectIDs.clear();
-    std::string fline;
-    std::getline(fixFile, fline); 
-    
-    while (std::getline(fixFile, fline)) {
-        std::stringstream ss(fline);
-        std::string field;
-        fixEntry entry;
-        try {
-            std::getline(ss, field, ',');
-            entry.parcode = std::stoi(field);
-        } 
-        catch (std::invalid_argument& e) {
-            entry.parcode = hashFn(field); 
+    // Rows of each (subject, trial) pair, grouped in a single pass over each file. 
+    struct TrialRows {
+        int parcode = 0;
+        int trial = 0;
+        std::vector<expEntry> exp = {};
+        std::vector<int> fixItem = {};
+        std::vector<int> fixTime = {};
+    };
+    std::vector<TrialRows> groups;
+    std::unordered_map<uint64_t, size_t> groupIndex;
+    auto key = [](int parcode, int trial) {
+        return ((uint64_t) (uint32_t) parcode << 32) | (uint32_t) trial;
+    };
+    groupIndex.reserve(expRows.size());
+    for (const std::array<int, 6> &row : expRows) {
+        expEntry entry = {row[0], row[1], row[2], row[3], row[4], row[5]};
+        auto inserted = groupIndex.insert({key(entry.parcode, entry.trial), groups.size()});
+        if (inserted.second) {
+            groups.push_back({entry.parcode, entry.trial});
         }
-        
-        subjectIDs.insert(entry.parcode);
-        std::getline(ss, field, ',');
-        entry.trial = std::stoi(field);
-        std::getline(ss, field, ',');
-        entry.fix_item = std::stoi(field);
-        std::getline(ss, field, ',');
-        entry.fix_time = std::stoi(field);
-        fixData.push_back(entry);
-    }
-    fixFile.close();
-
-    for (int subjectID : subjectIDs) {
-        if (!data.count(subjectID)) {
-            continue;
+        groups[inserted.first->second].exp.push_back(entry);
+    }
+    // Fixations of trials without experimental data are ignored. 
+    for (const std::array<int, 6> &row : fixRows) {
+        auto it = groupIndex.find(key(row[0], row[1]));
+        if (it != groupIndex.end()) {
+            groups[it->second].fixItem.push_back(row[2]);
+            groups[it->second].fixTime.push_back(row[3]);
         }
-        std::set<int> trialIDs;
-        std::vector<fixEntry> subjectEntries;
-        for (fixEntry f : fixData) {
-            if (f.parcode == subjectID) {
-                trialIDs.insert(f.trial);
-                subjectEntries.push_back(f);
-            }
+    }
+
+    // Trials of each subject are ordered by trial ID. 
+    std::sort(groups.begin(), groups.end(), [](const TrialRows &a, const TrialRows &b) {
+        return std::tie(a.parcode, a.trial) < std::tie(b.parcode, b.trial);
+    });
+    // subjectID -> aDDM Trials
+    std::map<int, std::vector<aDDMTrial>> data;
+    for (const TrialRows &group : groups) {
+        std::vector<aDDMTrial> &trials = data[group.parcode];
+        for (const expEntry &e : group.exp) {
+            trials.push_back(aDDMTrial(
+                e.rt, e.choice, e.item_left, e.item_right, group.fixItem, group.fixTime));
         }
-        int t = 0;
-        for (int trialID : trialIDs) {
-            std::vector<int> fixItem;
-            std::vector<int> fixTime;
-            for (fixEntry fs : subjectEntries) {
-                if (fs.trial == trialID) {
-                    fixItem.push_back(fs.fix_item);
-                    fixTime.push_back(fs.fix_time);
-                }
+    }
+    return data;
+}
+
+
+std::vector<float> refineRange(const std::vector<float> &range, float center, int level) {
+    if (range.size() < 2) {
+        return {center};
+    }
+    float spacing = (range.back() - range.front()) / (range.size() - 1) / (1 << level);
+    std::vector<float> values;
+    for (float value : {center - spacing, center, center + spacing}) {
+        value = std::min(std::max(value, range.front()), range.back());
+        if (values.empty() || value != values.back()) {
+            values.push_back(value);
+        }
+    }
+    return values;
+}
+
+
+std::vector<double> computePosteriors(
+    const std::vector<double> &logLikelihoods, int numModels, int numThreads) {
+
+    if (numModels == 0) {
+        return {};
+    }
+    size_t numTrials = logLikelihoods.size() / numModels;
+    // Log of the unnormalized posterior of every model, one block of models per task. 
+    const int modelsPerTask = 64;
+    std::vector<double> logPosteriors(numModels);
+    int numTasks = (numModels + modelsPerTask - 1) / modelsPerTask;
+    parallelFor(numTasks, numThreads, [&](int task) {
+        int end = std::min(numModels, (task + 1) * modelsPerTask);
+        for (int m = task * modelsPerTask; m < end; m++) {
+            const double *row = &logLikelihoods[m * numTrials];
+            double sum = 0;
+            for (size_t t = 0; t < numTrials; t++) {
+                sum += row[t];
             }
-            data.at(subjectID).at(t).fixItem = fixItem;
-            data.at(subjectID).at(t).fixTime = fixTime;
-            t++;
+            logPosteriors[m] = sum;
         }
+    });
+
+    double maxLogPosterior = *std::max_element(logPosteriors.begin(), logPosteriors.end());
+    double normalizer = 0;
+    for (double logPosterior : logPosteriors) {
+        normalizer += exp(logPosterior - maxLogPosterior);
     }
-    return data;
+    std::vector<double> posteriors(numModels);
+    for (int m = 0; m < numModels; m++) {
+        posteriors[m] = exp(logPosteriors[m] - maxLogPosterior) / normalizer;
+    }
+    return posteriors;
+}
+
+
+std::vector<int> selectFinalists(
+    const std::vector<double> &coarseNLLs, double topFraction, double margin) {
+
+    int numModels = coarseNLLs.size();
+    std::vector<int> order(numModels);
+    for (int m = 0; m < numModels; m++) {
+        order[m] = m;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return coarseNLLs[a] < coarseNLLs[b];
+    });
+    int numTop = std::max(1, (int) std::ceil(topFraction * numModels));
+    std::vector<int> finalists;
+    for (int r = 0; r < numModels; r++) {
+        if (r < numTop || coarseNLLs[order[r]] <= coarseNLLs[order[0]] + margin) {
+            finalists.push_back(order[r]);
+        }
+    }
+    return finalists;
+}
+
+
+std::vector<size_t> orderTrialsForBounding(
+    const std::vector<int> &RT, const std::vector<double> &referenceLikelihoods, int timeStep) {
+
+    size_t numTrials = RT.size();
+    std::vector<double> rates(numTrials);
+    std::vector<size_t> order(numTrials);
+    for (size_t i = 0; i < numTrials; i++) {
+        rates[i] = -log(referenceLikelihoods[i]) / (RT[i] / timeStep + 1);
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return rates[a] > rates[b];
+    });
+    return order;
 }
 
 
 FixationData getEmpiricalDistributions(
-    std::map<int, std::vector<aDDMTrial>> data, 
+    const std::map<int, std::vector<aDDMTrial>> &data, 
     int timeStep, int maxFixTime,
     int numFixDists, 
-    std::vector<int> valueDiffs,
-    std::vector<int> subjectIDs,
+    const std::vector<int> &valueDiffs,
+    const std::vector<int> &subjectIDs,
     bool useOddTrials, 
     bool useEvenTrials, 
     bool useCisTrials, 
@@ -163,15 +354,16 @@ FixationData getEmpiricalDistributions(
     std::vector<int> transitions;
     std::map<int, std::vector<float>> fixations;
 
-    if (subjectIDs.empty()) {
-        for (auto i : data) {
-            subjectIDs.push_back(i.first);
+    std::vector<int> subjects = subjectIDs;
+    if (subjects.empty()) {
+        for (const auto &i : data) {
+            subjects.push_back(i.first);
         }
     }
 
-    for (int subjectID : subjectIDs) {
+    for (int subjectID : subjects) {
         int trialID = 0;
-        for (aDDMTrial trial : data.at(subjectID)) {
+        for (const aDDMTrial &trial : data.at(subjectID)) {
             if (!useOddTrials && trialID % 2 != 0) {
                 continue;
             }
@@ -245,5 +437,6 @@ FixationData getEmpiricalDistributions(
         }
     }
     float probFixLeftFirst = (float) countLeftFirst / (float) countTotalTrials;
-    return FixationData(probFixLeftFirst, latencies, transitions, fixations);
+    return FixationData(
+        probFixLeftFirst, std::move(latencies), std::move(transitions), std::move(fixations));
 }
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <addm/cuda_toolbox.h>
+
+// Location of the aDDM simulations. 
+const std::string SIMS = "data/addm_sims.csv";
+// Location to write the trials to. 
+const std::string SAVE = "results/addm_alloc_bench.csv";
+
+// Every allocation of the program goes through the replaced operator new and is counted. 
+static std::atomic<long> numAllocs{0};
+static std::atomic<long> numBytes{0};
+
+void *operator new(size_t n) {
+    numAllocs++;
+    numBytes += n;
+    void *p = malloc(n ? n : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+/** 
+ * @brief Print the number of allocations, the bytes allocated and the wall time of a workload. 
+ * 
+ * @param name Label of the workload. 
+ * @param f Workload to run. 
+ */
+template <typename F>
+void measure(const std::string &name, F f) {
+    long allocs = numAllocs;
+    long bytes = numBytes;
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << std::left << std::setw(32) << name <<
+    "allocs " << std::setw(10) << numAllocs - allocs <<
+    "bytes " << std::setw(14) << numBytes - bytes <<
+    elapsed.count() << "s" << std::endl;
+}
+
+/** 
+ * Counts the heap allocations of the simulation, I/O and fitting paths. 
+ * 
+ * Example Usage: 
+ * 
+ * bin/addm_alloc_bench 
+ */
+int main() {
+    std::map<int, std::vector<aDDMTrial>> data = loadDataFromSingleCSV(SIMS);
+    std::vector<aDDMTrial> trials = data.at(0);
+    FixationData fixationData = getEmpiricalDistributions(data);
+
+    measure("getEmpiricalDistributions x10", [&]() {
+        for (int i = 0; i < 10; i++) {
+            getEmpiricalDistributions(data);
+        }
+    });
+    aDDM addm = aDDM(0.005, 0.07, 0.5, 0, 1, 0);
+    measure("simulateTrial x2000", [&]() {
+        for (int i = 0; i < 2000; i++) {
+            addm.simulateTrial(3, 1, fixationData, 10, 3, {}, {}, i);
+        }
+    });
+    measure("writeTrialsToCSV", [&]() {
+        aDDMTrial::writeTrialsToCSV(trials, SAVE);
+    });
+    std::vector<aDDMTrial> subset(trials.begin(), trials.begin() + 200);
+    measure("fitModelMLE 2x2 basic", [&]() {
+        aDDM::fitModelMLE(subset, {0.003, 0.005}, {0.05, 0.07}, {0.5}, {0}, "basic");
+    });
+}
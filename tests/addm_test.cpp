@@ -1,4 +1,6 @@
 #include <addm/cuda_toolbox.h>
+#include <filesystem>
+#include <fstream>
 
 #define CATCH_CONFIG_MAIN
 #include <catch2/catch.hpp>
@@ -7,12 +9,32 @@
 
 const std::string EXP_DATA = "data/expdata.csv";
 const std::string FIX_DATA = "data/fixations.csv"; 
+const std::string ADDM_SIMS = "data/addm_sims.csv";
+const std::string DDM_SIMS = "data/ddm_sims.csv";
 const float ERROR_BOUND = 1.0E-6; 
 
 inline bool within_abs(float f1, float f2, float error) {
     return abs(f1 - f2) < error; 
 }
 
+/**
+ * @brief Load the first numTrials trials of the aDDM simulations. 
+ */
+inline std::vector<aDDMTrial> load_addm_sims(size_t numTrials) {
+    std::vector<aDDMTrial> trials = aDDMTrial::loadTrialsFromCSV(ADDM_SIMS);
+    trials.resize(numTrials);
+    return trials;
+}
+
+/**
+ * @brief Load the first numTrials trials of the DDM simulations. 
+ */
+inline std::vector<DDMTrial> load_ddm_sims(size_t numTrials) {
+    std::vector<DDMTrial> trials = DDMTrial::loadTrialsFromCSV(DDM_SIMS);
+    trials.resize(numTrials);
+    return trials;
+}
+
 
 /**
  * @brief Check that input seeds yield consistent results for aDDM::simulateTrial and the 
@@ -106,3 +128,994 @@ TEST_CASE("aDDM::fitModelMLE gives expected results") {
         } 
     }
 }
+
+/**
+ * @brief Check that aDDM::computeCPUNLL computes every trial, including the trials that do not 
+ * fill a complete chunk, and matches the single trial likelihoods. 
+ * 
+ */
+TEST_CASE("aDDM::computeCPUNLL computes every trial") {
+    std::vector<aDDMTrial> trials = load_addm_sims(103);
+    aDDM addm = aDDM(0.005, 0.07, 0.5);
+
+    ProbabilityData chunked = addm.computeCPUNLL(trials, 10);
+    ProbabilityData single = addm.computeCPUNLL(trials, 1);
+
+    REQUIRE(chunked.trialLikelihoods.size() == trials.size());
+    for (int i = 0; i < trials.size(); i++) {
+        double expected = addm.getTrialLikelihood(trials[i]);
+        REQUIRE(expected > 1e-20);
+        REQUIRE(chunked.trialLikelihoods[i] == expected);
+        REQUIRE(single.trialLikelihoods[i] == expected);
+    }
+    REQUIRE(chunked.NLL == single.NLL);
+}
+
+/**
+ * @brief Check that reading every DDMTrial off one propagation per value difference gives the 
+ * same likelihoods as propagating each trial on its own. 
+ * 
+ */
+TEST_CASE("DDM::computeCPUNLL matches single trial propagation") {
+    std::vector<DDMTrial> trials = load_ddm_sims(200);
+    DDM ddm = DDM(0.005, 0.07, 1, 100);
+
+    ProbabilityData grouped = ddm.computeCPUNLL(trials);
+
+    REQUIRE(grouped.trialLikelihoods.size() == trials.size());
+    for (int i = 0; i < trials.size(); i++) {
+        REQUIRE(grouped.trialLikelihoods[i] == ddm.getTrialLikelihood(trials[i]));
+    }
+}
+
+/**
+ * @brief Check that truncating the tails of the banded transition kernel leaves the trial 
+ * likelihoods of the full operator unchanged. 
+ * 
+ */
+TEST_CASE("Banded transition kernel matches the full operator") {
+    std::vector<aDDMTrial> trials = load_addm_sims(50);
+    aDDM addm = aDDM(0.005, 0.07, 0.5);
+    PropagationOptions full;
+    full.tailMass = 0;
+
+    ProbabilityData banded = addm.computeCPUNLL(trials, 10, 10, 0.05);
+    ProbabilityData dense = addm.computeCPUNLL(trials, 10, 10, 0.05, 0, full);
+
+    for (int i = 0; i < trials.size(); i++) {
+        REQUIRE(within_abs(
+            banded.trialLikelihoods[i], dense.trialLikelihoods[i], ERROR_BOUND));
+    }
+    REQUIRE(banded.NLL == Approx(dense.NLL).epsilon(1e-9));
+}
+
+/**
+ * @brief Check that advancing long fixations with a SkipAheadOperator gives the same likelihoods 
+ * as stepping through them. 
+ * 
+ */
+TEST_CASE("aDDM skip-ahead propagation matches stepping") {
+    std::vector<aDDMTrial> trials = load_addm_sims(50);
+    aDDM addm = aDDM(0.005, 0.07, 0.5);
+    PropagationOptions stepped;
+    stepped.skipAhead = false;
+    PropagationOptions skipped;
+    skipped.skipAheadMinSteps = 1;
+
+    ProbabilityData expected = addm.computeCPUNLL(trials, 10, 10, 0.1, 0, stepped);
+    ProbabilityData actual = addm.computeCPUNLL(trials, 10, 10, 0.1, 0, skipped);
+
+    for (int i = 0; i < trials.size(); i++) {
+        REQUIRE(actual.trialLikelihoods[i] == Approx(expected.trialLikelihoods[i]).epsilon(1e-9));
+    }
+}
+
+/**
+ * @brief Check that propagating a grid of biases together gives the same likelihoods as 
+ * propagating each bias on its own. 
+ * 
+ */
+TEST_CASE("computeCPUNLL over a bias grid matches single biases") {
+    std::vector<float> biases = {-0.2, 0, 0.15};
+
+    std::vector<aDDMTrial> trials = load_addm_sims(50);
+    aDDM addm = aDDM(0.005, 0.07, 0.5);
+    std::vector<ProbabilityData> grid = addm.computeCPUNLL(trials, biases);
+
+    std::vector<DDMTrial> ddmTrials = load_ddm_sims(100);
+    DDM ddm = DDM(0.005, 0.07, 1, 100);
+    std::vector<ProbabilityData> ddmGrid = ddm.computeCPUNLL(ddmTrials, biases);
+
+    REQUIRE(grid.size() == biases.size());
+    REQUIRE(ddmGrid.size() == biases.size());
+    for (int b = 0; b < biases.size(); b++) {
+        addm.bias = biases[b];
+        ProbabilityData single = addm.computeCPUNLL(trials);
+        REQUIRE(grid[b].NLL == Approx(single.NLL).epsilon(1e-12));
+
+        ddm.bias = biases[b];
+        ProbabilityData ddmSingle = ddm.computeCPUNLL(ddmTrials);
+        REQUIRE(ddmGrid[b].NLL == Approx(ddmSingle.NLL).epsilon(1e-12));
+    }
+}
+
+/**
+ * @brief Check that lockstep propagation of batched aDDMTrials gives the same likelihoods as 
+ * stepping through each trial on its own. 
+ * 
+ */
+TEST_CASE("aDDM lockstep propagation matches single trials") {
+    std::vector<aDDMTrial> trials = load_addm_sims(200);
+    aDDM addm = aDDM(0.005, 0.07, 0.5, 0, 1, 0, 0, 0.01);
+    PropagationOptions stepped;
+    stepped.skipAhead = false;
+    PropagationOptions lockstep;
+    lockstep.lockstep = true;
+
+    ProbabilityData expected = addm.computeCPUNLL(trials, 10, 10, 0.1, 0, stepped);
+    ProbabilityData actual = addm.computeCPUNLL(trials, 16, 10, 0.1, 0, lockstep);
+
+    for (int i = 0; i < trials.size(); i++) {
+        REQUIRE(actual.trialLikelihoods[i] == Approx(expected.trialLikelihoods[i]).epsilon(1e-12));
+    }
+}
+
+/**
+ * @brief Check that sharing the common fixation prefixes of aDDMTrials in a trie gives the same 
+ * likelihoods as propagating each trial on its own, for several biases at once. 
+ * 
+ */
+TEST_CASE("aDDM prefix sharing matches single trials") {
+    std::vector<aDDMTrial> trials = load_addm_sims(200);
+    aDDM addm = aDDM(0.005, 0.07, 0.5, 0, 1, 0, 0, 0);
+    std::vector<float> biases = {-0.2, 0, 0.3};
+    PropagationOptions shared;
+    shared.prefixSharing = true;
+
+    std::vector<ProbabilityData> expected = addm.computeCPUNLL(trials, biases, 10, 10, 0.1);
+    std::vector<ProbabilityData> actual = addm.computeCPUNLL(
+        trials, biases, 10, 10, 0.1, 0, shared);
+
+    for (int b = 0; b < biases.size(); b++) {
+        for (int i = 0; i < trials.size(); i++) {
+            REQUIRE(actual[b].trialLikelihoods[i] == 
+                Approx(expected[b].trialLikelihoods[i]).epsilon(1e-12));
+        }
+    }
+}
+
+/**
+ * @brief Check that advancing a block of aDDMs in vector lanes gives the same likelihoods as 
+ * computing each model on its own. 
+ * 
+ */
+TEST_CASE("aDDM model lanes match single models") {
+    std::vector<aDDMTrial> trials = load_addm_sims(100);
+    std::vector<aDDM> models;
+    for (float d : {0.003, 0.005, 0.007}) {
+        for (float theta : {0.3, 0.5, 0.8}) {
+            models.push_back(aDDM(d, d == 0.005f ? 0.05 : 0.07, theta, 0.1, 1, 0, 0, 0.001));
+        }
+    }
+    PropagationOptions stepped;
+    stepped.skipAhead = false;
+
+    std::vector<ProbabilityData> actual = aDDM::computeCPUNLLs(models, trials, 10, 10, 0.1, 0, 4);
+    for (int m = 0; m < models.size(); m++) {
+        ProbabilityData expected = models[m].computeCPUNLL(trials, 10, 10, 0.1, 0, stepped);
+        for (int i = 0; i < trials.size(); i++) {
+            REQUIRE(actual[m].trialLikelihoods[i] == 
+                Approx(expected.trialLikelihoods[i]).epsilon(1e-12));
+        }
+    }
+}
+
+/**
+ * @brief Check that the parallel loops reuse one pool per thread count, visit every iteration
+ * once, run nested loops without deadlocking and rethrow the exceptions of their iterations.
+ *
+ */
+TEST_CASE("Parallel loops share a persistent pool") {
+    REQUIRE(&getThreadPool(4) == &getThreadPool(4));
+    REQUIRE(&getThreadPool(4) != &getThreadPool(2));
+
+    std::vector<int> counts(1000, 0);
+    parallelFor(counts.size(), 4, [&](int i) {
+        parallelFor(10, 4, [&](int) { counts[i]++; });
+    });
+    for (int count : counts) {
+        REQUIRE(count == 10);
+    }
+    std::vector<int> weighted(100, 0);
+    parallelForWeighted(std::vector<double>(weighted.size(), 1), 4, [&](int i) {
+        weighted[i]++;
+    });
+    for (int count : weighted) {
+        REQUIRE(count == 1);
+    }
+    REQUIRE_THROWS_AS(parallelFor(100, 4, [](int i) {
+        if (i == 50) {
+            throw std::invalid_argument("Iteration 50 failed.");
+        }
+    }), std::invalid_argument);
+}
+
+/**
+ * @brief Check that the grid search scheduler computes the same NLLs as evaluating each model on
+ * its own, with every thread count, and that it only returns trial likelihoods on request. 
+ * 
+ */
+TEST_CASE("Grid NLLs do not depend on the number of threads") {
+    std::vector<aDDMTrial> trials = load_addm_sims(200);
+    std::vector<aDDM> models;
+    for (float d : {0.003, 0.005, 0.007}) {
+        for (float theta : {0.3, 0.5, 0.8}) {
+            models.push_back(aDDM(d, 0.07, theta));
+        }
+    }
+    std::vector<float> biases = {0, 0.2};
+
+    std::vector<std::vector<ProbabilityData>> basic = 
+        getComputeBackend("basic")->computeGridNLLs(models, trials, biases, 10, 10, 0.1);
+    std::vector<std::vector<ProbabilityData>> threaded = 
+        getComputeBackend("thread")->computeGridNLLs(models, trials, biases, 10, 10, 0.1);
+    std::vector<std::vector<ProbabilityData>> sums = 
+        getComputeBackend("thread")->computeGridNLLs(models, trials, biases, 10, 10, 0.1, false);
+    for (int m = 0; m < models.size(); m++) {
+        std::vector<ProbabilityData> expected = models[m].computeCPUNLL(trials, biases);
+        for (int b = 0; b < biases.size(); b++) {
+            REQUIRE(basic[m][b].NLL == threaded[m][b].NLL);
+            REQUIRE(sums[m][b].NLL == threaded[m][b].NLL);
+            REQUIRE(sums[m][b].trialLikelihoods.empty());
+            REQUIRE(threaded[m][b].trialLikelihoods.size() == trials.size());
+            REQUIRE(basic[m][b].NLL == Approx(expected[b].NLL).epsilon(1e-12));
+        }
+    }
+}
+
+/**
+ * @brief Check that coarse-to-fine refinement of the grid in aDDM::fitModelMLE evaluates models 
+ * between the coarse values and never does worse than the coarse grid. 
+ * 
+ */
+TEST_CASE("aDDM::fitModelMLE refines the grid around the optimum") {
+    std::vector<aDDMTrial> trials = load_addm_sims(200);
+    std::vector<float> rangeD = {0.001, 0.009};
+    std::vector<float> rangeSigma = {0.03, 0.11};
+    std::vector<float> rangeTheta = {0.1, 0.9};
+
+    MLEinfo<aDDM> coarse = aDDM::fitModelMLE(
+        trials, rangeD, rangeSigma, rangeTheta, {0}, "basic");
+    MLEinfo<aDDM> refined = aDDM::fitModelMLE(
+        trials, rangeD, rangeSigma, rangeTheta, {0}, "basic", false, 1, 0, {0}, {0}, 
+        10, 0.1, 10, 3);
+
+    REQUIRE(refined.likelihoods.size() > coarse.likelihoods.size());
+    double coarseNLL = coarse.optimal.computeCPUNLL(trials).NLL;
+    double refinedNLL = refined.optimal.computeCPUNLL(trials).NLL;
+    REQUIRE(refinedNLL <= coarseNLL);
+    // Three levels divide the spacing of every range by 8. 
+    float spacing = (rangeD[1] - rangeD[0]) / 8;
+    float steps = (refined.optimal.d - rangeD[0]) / spacing;
+    REQUIRE(steps == Approx(std::round(steps)).margin(1e-3));
+}
+
+/**
+ * @brief Check that the bounded simplex finds a model at least as good as a coarse grid, stays 
+ * within the bounds, and converges in fewer evaluations when warm started at its own optimum. A 
+ * search stopped at maxEvaluations reports that it did not converge. 
+ * 
+ */
+TEST_CASE("aDDM::fitModelOptimize improves on a coarse grid") {
+    std::vector<aDDMTrial> trials = load_addm_sims(200);
+    std::vector<float> rangeD = {0.001, 0.009};
+    std::vector<float> rangeSigma = {0.03, 0.11};
+    std::vector<float> rangeTheta = {0.1, 0.9};
+
+    MLEinfo<aDDM> grid = aDDM::fitModelMLE(trials, rangeD, rangeSigma, rangeTheta, {0}, "basic");
+    MLEinfo<aDDM> cold = aDDM::fitModelOptimize(
+        trials, rangeD, rangeSigma, rangeTheta, {0}, "basic");
+    double gridNLL = grid.optimal.computeCPUNLL(trials).NLL;
+    double coldNLL = cold.optimal.computeCPUNLL(trials).NLL;
+    REQUIRE(coldNLL <= gridNLL);
+    REQUIRE(cold.optimal.d >= rangeD[0]);
+    REQUIRE(cold.optimal.d <= rangeD[1]);
+    REQUIRE(cold.optimal.theta >= rangeTheta[0]);
+    REQUIRE(cold.optimal.theta <= rangeTheta[1]);
+
+    OptimizerOptions local;
+    local.initialStep = 0.02;
+    MLEinfo<aDDM> warm = aDDM::fitModelOptimize(
+        trials, rangeD, rangeSigma, rangeTheta, {0}, "basic", 1, 0, {0}, {0}, 10, 0.1, 10, 
+        cold.optimal, local);
+    double warmNLL = warm.optimal.computeCPUNLL(trials).NLL;
+    REQUIRE(warmNLL <= coldNLL);
+    REQUIRE(warm.likelihoods.size() < cold.likelihoods.size());
+    REQUIRE(cold.converged);
+    REQUIRE(warm.converged);
+    REQUIRE(cold.numEvaluations >= cold.likelihoods.size());
+    REQUIRE(warm.numEvaluations < cold.numEvaluations);
+
+    OptimizerOptions capped;
+    capped.maxEvaluations = 5;
+    MLEinfo<aDDM> stopped = aDDM::fitModelOptimize(
+        trials, rangeD, rangeSigma, rangeTheta, {0}, "basic", 1, 0, {0}, {0}, 10, 0.1, 10, 
+        std::nullopt, capped);
+    REQUIRE(!stopped.converged);
+    REQUIRE(stopped.numEvaluations < cold.numEvaluations);
+}
+
+/**
+ * @brief Check that the analytic gradient of the aDDM NLL matches central finite differences in d, 
+ * sigma, theta and k, with and without decay, and that its NLL matches computeCPUNLL. 
+ * 
+ */
+TEST_CASE("aDDM NLL gradient matches finite differences") {
+    std::vector<aDDMTrial> trials = load_addm_sims(50);
+    std::vector<float> x = {0.005, 0.07, 0.5, 0.01};
+    for (float decay : {0.0f, 0.001f}) {
+        aDDM addm = aDDM(x[0], x[1], x[2], x[3], 1, 0, 0, decay);
+        NLLGradient result = addm.computeCPUNLLGradient(trials);
+        REQUIRE(result.NLL == Approx(addm.computeCPUNLL(trials, 10, 10, 0.1, 1).NLL));
+        REQUIRE(result.gradient.size() == 5);
+        REQUIRE(result.gradient[4] == 0);
+        for (int p = 0; p < 4; p++) {
+            std::vector<float> up = x, down = x;
+            up[p] += x[p] * 1e-3;
+            down[p] -= x[p] * 1e-3;
+            double NLLUp = aDDM(up[0], up[1], up[2], up[3], 1, 0, 0, decay)
+                .computeCPUNLLGradient(trials).NLL;
+            double NLLDown = aDDM(down[0], down[1], down[2], down[3], 1, 0, 0, decay)
+                .computeCPUNLLGradient(trials).NLL;
+            double difference = (NLLUp - NLLDown) / (up[p] - down[p]);
+            REQUIRE(result.gradient[p] == Approx(difference).epsilon(1e-3).margin(1e-2));
+        }
+    }
+}
+
+/**
+ * @brief Check that L-BFGS-B reaches the NLL of the bounded simplex with fewer evaluations and 
+ * stays within the bounds. 
+ * 
+ */
+TEST_CASE("aDDM::fitModelLBFGSB matches the simplex with fewer evaluations") {
+    std::vector<aDDMTrial> trials = load_addm_sims(200);
+    std::vector<float> rangeD = {0.001, 0.009};
+    std::vector<float> rangeSigma = {0.03, 0.11};
+    std::vector<float> rangeTheta = {0.1, 0.9};
+
+    MLEinfo<aDDM> simplex = aDDM::fitModelOptimize(
+        trials, rangeD, rangeSigma, rangeTheta, {0}, "basic");
+    MLEinfo<aDDM> lbfgsb = aDDM::fitModelLBFGSB(trials, rangeD, rangeSigma, rangeTheta);
+    double simplexNLL = simplex.optimal.computeCPUNLL(trials).NLL;
+    double lbfgsbNLL = lbfgsb.optimal.computeCPUNLL(trials).NLL;
+    REQUIRE(lbfgsbNLL <= simplexNLL + 1e-2);
+    REQUIRE(lbfgsb.numEvaluations > 0);
+    REQUIRE(lbfgsb.numEvaluations < simplex.numEvaluations);
+    REQUIRE(lbfgsb.numEvaluations >= (int) lbfgsb.likelihoods.size());
+    REQUIRE(lbfgsb.optimal.theta >= rangeTheta[0]);
+    REQUIRE(lbfgsb.optimal.theta <= rangeTheta[1]);
+}
+
+/**
+ * @brief Check that pruning finds the optimum of the full grid search, skips some models, keeps 
+ * the NLLs of the models it completes, and cannot be combined with normalized posteriors. 
+ * 
+ */
+TEST_CASE("aDDM::fitModelMLE pruning keeps the optimum") {
+    std::vector<aDDMTrial> trials = load_addm_sims(200);
+    std::vector<float> rangeD = {0.002, 0.005, 0.008, 0.011};
+    std::vector<float> rangeSigma = {0.02, 0.07, 0.12, 0.17};
+    std::vector<float> rangeTheta = {0.1, 0.5, 0.9};
+
+    MLEinfo<aDDM> full = aDDM::fitModelMLE(
+        trials, rangeD, rangeSigma, rangeTheta, {0}, "thread", false, 1, 0, {0, 0.1});
+    MLEinfo<aDDM> pruned = aDDM::fitModelMLE(
+        trials, rangeD, rangeSigma, rangeTheta, {0}, "thread", false, 1, 0, {0, 0.1}, 
+        {0}, 10, 0.1, 10, 0, 1, true);
+    REQUIRE(pruned.optimal.d == full.optimal.d);
+    REQUIRE(pruned.optimal.sigma == full.optimal.sigma);
+    REQUIRE(pruned.optimal.theta == full.optimal.theta);
+    REQUIRE(pruned.optimal.bias == full.optimal.bias);
+    REQUIRE(pruned.likelihoods.size() < full.likelihoods.size());
+    for (const auto &entry : pruned.likelihoods) {
+        REQUIRE(entry.second == Approx(full.likelihoods.at(entry.first)).epsilon(1e-5));
+    }
+
+    REQUIRE_THROWS_AS(
+        aDDM::fitModelMLE(
+            trials, rangeD, rangeSigma, rangeTheta, {0}, "thread", true, 1, 0, {0}, 
+            {0}, 10, 0.1, 10, 0, 1, true), 
+        std::invalid_argument);
+}
+
+/**
+ * @brief Pruning visits the trials from a copy in bounding order, so the trials passed to 
+ * fitModelMLE keep their order and the optimum is the one found without pruning. 
+ * 
+ */
+TEST_CASE("aDDM::fitModelMLE pruning reorders a bounding copy of the trials") {
+    std::vector<aDDMTrial> trials = load_addm_sims(200);
+    const std::vector<aDDMTrial> original = trials;
+    TrialBatch batch(trials);
+    const std::vector<int> originalRT = batch.RT;
+    std::vector<float> rangeD = {0.002, 0.005, 0.008};
+    std::vector<float> rangeSigma = {0.02, 0.07, 0.12};
+    std::vector<float> rangeTheta = {0.1, 0.5, 0.9};
+
+    MLEinfo<aDDM> full = aDDM::fitModelMLE(
+        trials, rangeD, rangeSigma, rangeTheta, {0}, "thread");
+    MLEinfo<aDDM> pruned = aDDM::fitModelMLE(
+        trials, rangeD, rangeSigma, rangeTheta, {0}, "thread", false, 1, 0, {0}, 
+        {0}, 10, 0.1, 10, 0, 1, true);
+    MLEinfo<aDDM> prunedBatch = aDDM::fitModelMLE(
+        batch, rangeD, rangeSigma, rangeTheta, {0}, "thread", false, 1, 0, {0}, 
+        {0}, 10, 0.1, 10, 0, 1, true);
+    for (int i = 0; i < trials.size(); i++) {
+        REQUIRE(trials[i].RT == original[i].RT);
+        REQUIRE(trials[i].choice == original[i].choice);
+        REQUIRE(trials[i].fixItem == original[i].fixItem);
+        REQUIRE(trials[i].fixTime == original[i].fixTime);
+    }
+    REQUIRE(batch.RT == originalRT);
+    for (const MLEinfo<aDDM> &info : {pruned, prunedBatch}) {
+        REQUIRE(info.optimal.d == full.optimal.d);
+        REQUIRE(info.optimal.sigma == full.optimal.sigma);
+        REQUIRE(info.optimal.theta == full.optimal.theta);
+        REQUIRE(info.likelihoods.at(info.optimal) ==
+            Approx(full.likelihoods.at(full.optimal)).epsilon(1e-5));
+    }
+}
+
+/**
+ * @brief Check that a screened grid search finds the optimum of the full one and scores the top 
+ * fraction of the grid at the full resolution, marking every other model as coarse. 
+ * 
+ */
+TEST_CASE("aDDM::fitModelMLE screening keeps fine scores for the best models") {
+    std::vector<aDDMTrial> trials = load_addm_sims(200);
+    std::vector<float> rangeD = {0.002, 0.005, 0.008, 0.011};
+    std::vector<float> rangeSigma = {0.02, 0.07, 0.12, 0.17};
+    std::vector<float> rangeTheta = {0.1, 0.5, 0.9};
+
+    MLEinfo<aDDM> full = aDDM::fitModelMLE(
+        trials, rangeD, rangeSigma, rangeTheta, {0}, "thread");
+    ScreeningOptions screening;
+    screening.enabled = true;
+    screening.topFraction = 0.2;
+    MLEinfo<aDDM> screened = aDDM::fitModelMLE(
+        trials, rangeD, rangeSigma, rangeTheta, {0}, "thread", false, 1, 0, {0}, {0}, 
+        10, 0.1, 10, 0, 1, false, screening);
+    REQUIRE(screened.optimal.d == full.optimal.d);
+    REQUIRE(screened.optimal.sigma == full.optimal.sigma);
+    REQUIRE(screened.optimal.theta == full.optimal.theta);
+    REQUIRE(screened.likelihoods.size() == full.likelihoods.size());
+    REQUIRE(screened.fidelities.size() == full.likelihoods.size());
+
+    int numFine = 0;
+    for (const auto &entry : screened.fidelities) {
+        if (entry.second == Fidelity::Fine) {
+            numFine++;
+            REQUIRE(screened.likelihoods.at(entry.first) == 
+                Approx(full.likelihoods.at(entry.first)).epsilon(1e-5));
+        }
+    }
+    REQUIRE(numFine == 10);
+    REQUIRE(screened.fidelities.at(screened.optimal) == Fidelity::Fine);
+}
+
+/**
+ * @brief Check that a grid with more models than fitModelMLE builds at once is evaluated batch by
+ * batch with the same NLLs, optimum, pruning and screening as evaluating each model on its own.
+ *
+ */
+TEST_CASE("DDM::fitModelMLE evaluates grids larger than a batch") {
+    std::vector<DDMTrial> trials = load_ddm_sims(100);
+    std::vector<float> rangeD, rangeSigma;
+    for (int i = 1; i <= 20; i++) {
+        rangeD.push_back(0.001 * i);
+    }
+    for (int i = 2; i <= 16; i++) {
+        rangeSigma.push_back(0.01 * i);
+    }
+
+    MLEinfo<DDM> full = DDM::fitModelMLE(trials, rangeD, rangeSigma, "thread");
+    REQUIRE(full.grid.size() == 300);
+    REQUIRE(full.likelihoods.size() == 300);
+    for (size_t i = 0; i < full.grid.size(); i += 37) {
+        std::vector<float> p = full.grid.parameters(i);
+        DDM ddm = DDM(p[0], p[1], 1, 0, p[3], p[2]);
+        REQUIRE(full.grid.values[i] == Approx(ddm.computeCPUNLL(trials).NLL).epsilon(1e-5));
+    }
+
+    MLEinfo<DDM> pruned = DDM::fitModelMLE(
+        trials, rangeD, rangeSigma, "thread", false, 1, 0, {0}, {0}, 10, 0.1, 10, 0, 1, true);
+    REQUIRE(pruned.optimal == full.optimal);
+    REQUIRE(pruned.likelihoods.size() < full.likelihoods.size());
+
+    ScreeningOptions screening;
+    screening.enabled = true;
+    screening.topFraction = 0.05;
+    MLEinfo<DDM> screened = DDM::fitModelMLE(
+        trials, rangeD, rangeSigma, "thread", false, 1, 0, {0}, {0}, 10, 0.1, 10, 0, 1, false,
+        screening);
+    int numFine = 0;
+    for (const auto &entry : screened.fidelities) {
+        numFine += entry.second == Fidelity::Fine;
+    }
+    REQUIRE(screened.fidelities.size() == 300);
+    REQUIRE(numFine == 15);
+    REQUIRE(screened.optimal == full.optimal);
+}
+
+/**
+ * @brief Check that normalized posteriors sum to one and follow the ratios of the likelihoods, and 
+ * that the log-space normalization does not underflow. 
+ * 
+ */
+TEST_CASE("aDDM::fitModelMLE posteriors follow the NLLs") {
+    std::vector<aDDMTrial> trials = load_addm_sims(100);
+    std::vector<float> rangeD = {0.004, 0.005, 0.006};
+    std::vector<float> rangeSigma = {0.06, 0.07, 0.08};
+    std::vector<float> rangeTheta = {0.4, 0.5, 0.6};
+
+    MLEinfo<aDDM> NLLs = aDDM::fitModelMLE(
+        trials, rangeD, rangeSigma, rangeTheta, {0}, "thread", false);
+    MLEinfo<aDDM> posteriors = aDDM::fitModelMLE(
+        trials, rangeD, rangeSigma, rangeTheta, {0}, "thread", true);
+    REQUIRE(posteriors.likelihoods.size() == NLLs.likelihoods.size());
+    double sum = 0;
+    double optimalNLL = NLLs.likelihoods.at(NLLs.optimal);
+    double optimalPosterior = posteriors.likelihoods.at(NLLs.optimal);
+    for (const auto &entry : posteriors.likelihoods) {
+        sum += entry.second;
+        double ratio = exp(optimalNLL - NLLs.likelihoods.at(entry.first));
+        REQUIRE(entry.second / optimalPosterior == Approx(ratio).epsilon(1e-3).margin(1e-6));
+    }
+    REQUIRE(sum == Approx(1).epsilon(1e-5));
+
+    // Log-space normalization does not underflow when every likelihood is tiny. 
+    std::vector<double> posterior = computePosteriors({-2000, -2001, -2001, -2000}, 2);
+    REQUIRE(posterior[0] == Approx(0.5));
+    REQUIRE(posterior[1] == Approx(0.5));
+}
+
+/**
+ * @brief Check that ParameterGrid sorts its axes and converts between indices, coordinates and 
+ * parameters, and that a grid search stores its NLLs in the grid. 
+ * 
+ */
+TEST_CASE("ParameterGrid maps indices to parameters") {
+    ParameterGrid grid({"d", "sigma", "bias"}, {{0.002, 0.001, 0.002}, {0.05}, {0.1, 0, -0.1}});
+    REQUIRE(grid.size() == 6);
+    REQUIRE(grid.axes[0] == std::vector<float>{0.001, 0.002});
+    for (size_t i = 0; i < grid.size(); i++) {
+        REQUIRE(grid.index(grid.coordinates(i)) == i);
+        REQUIRE(grid.find(grid.parameters(i)) == (long) i);
+        REQUIRE(std::isnan(grid.values[i]));
+    }
+    REQUIRE(grid.parameters(4) == std::vector<float>{0.002, 0.05, 0});
+    REQUIRE(grid.find({0.003, 0.05, 0}) == -1);
+
+    // Models that differ only in k are distinct keys. 
+    std::map<aDDM, float> scores;
+    scores[aDDM(0.005, 0.07, 0.5, 0)] = 1;
+    scores[aDDM(0.005, 0.07, 0.5, 0.1)] = 2;
+    REQUIRE(scores.size() == 2);
+
+    std::vector<aDDMTrial> trials = load_addm_sims(50);
+    MLEinfo<aDDM> info = aDDM::fitModelMLE(
+        trials, {0.004, 0.006}, {0.07}, {0.5}, {0, 0.1}, "basic");
+    REQUIRE(info.grid.size() == 4);
+    REQUIRE(info.likelihoods.size() == 4);
+    for (size_t i = 0; i < info.grid.size(); i++) {
+        std::vector<float> p = info.grid.parameters(i);
+        aDDM addm = aDDM(p[0], p[1], p[2], p[3], 1, 0, p[5], p[4]);
+        REQUIRE(info.grid.values[i] == Approx(info.likelihoods.at(addm)));
+    }
+}
+
+/**
+ * @brief Check that the streaming fit finds the optimum of the dense posteriors and matches its 
+ * top models and marginals without storing the grid. 
+ * 
+ */
+TEST_CASE("aDDM::fitModelStreaming matches the dense posteriors") {
+    std::vector<aDDMTrial> trials = load_addm_sims(100);
+    std::vector<float> rangeD = {0.004, 0.005, 0.006};
+    std::vector<float> rangeSigma = {0.06, 0.07, 0.08};
+    std::vector<float> rangeTheta = {0.4, 0.5, 0.6};
+    std::vector<float> bias = {-0.05, 0};
+
+    MLEinfo<aDDM> dense = aDDM::fitModelMLE(
+        trials, rangeD, rangeSigma, rangeTheta, {0}, "thread", true, 1, 0, bias);
+    MLEinfo<aDDM> streamed = aDDM::fitModelStreaming(
+        trials, rangeD, rangeSigma, rangeTheta, {0}, "thread", 1, 0, bias, {0}, 
+        10, 0.1, 10, 3, 4);
+    REQUIRE(streamed.optimal == dense.optimal);
+    REQUIRE(streamed.likelihoods.size() == 3);
+    REQUIRE(streamed.topModels.size() == 3);
+    REQUIRE(streamed.grid.values.empty());
+    for (const auto &entry : streamed.likelihoods) {
+        REQUIRE(entry.second == Approx(dense.likelihoods.at(entry.first)).margin(1e-6));
+        REQUIRE(streamed.topModels.at(entry.first).trialLikelihoods.size() == trials.size());
+    }
+
+    // Marginals sum the dense posteriors over the other parameters. 
+    REQUIRE(streamed.marginals.size() == 6);
+    for (int i = 0; i < rangeD.size(); i++) {
+        double marginal = 0;
+        for (const auto &entry : dense.likelihoods) {
+            marginal += entry.first.d == rangeD[i] ? entry.second : 0;
+        }
+        REQUIRE(streamed.marginals[0][i] == Approx(marginal).margin(1e-6));
+    }
+}
+
+/**
+ * @brief Check that an anytime fit evaluates the whole grid when it is not stopped, reports its 
+ * progress, and keeps the best model so far when cancelled. 
+ * 
+ */
+TEST_CASE("aDDM::fitModelAnytime stops early with the best model so far") {
+    std::vector<aDDMTrial> trials = load_addm_sims(100);
+    std::vector<float> rangeD = {0.003, 0.004, 0.005, 0.006, 0.007};
+    std::vector<float> rangeSigma = {0.06, 0.07, 0.08};
+    std::vector<float> rangeTheta = {0.4, 0.5, 0.6};
+
+    MLEinfo<aDDM> grid = aDDM::fitModelMLE(
+        trials, rangeD, rangeSigma, rangeTheta, {0}, "thread");
+    AnytimeOptions options;
+    options.modelsPerBatch = 4;
+    std::vector<FitProgress> reports;
+    options.progress = [&](const FitProgress &progress) { reports.push_back(progress); };
+    MLEinfo<aDDM> full = aDDM::fitModelAnytime(
+        trials, rangeD, rangeSigma, rangeTheta, {0}, "thread", 1, 0, {0}, {0}, 10, 0.1, 10, 
+        options);
+    REQUIRE(full.complete);
+    REQUIRE(full.optimal == grid.optimal);
+    REQUIRE(full.likelihoods.size() == grid.likelihoods.size());
+    REQUIRE(reports.back().modelsDone == 45);
+    REQUIRE(reports.back().etaSeconds == 0);
+    REQUIRE(reports.back().bestNLL == Approx(grid.likelihoods.at(grid.optimal)));
+
+    // Cancelling after the third batch keeps the twelve models evaluated so far. 
+    options.progress = [&](const FitProgress &progress) {
+        if (progress.modelsDone == 12) {
+            options.cancellation.cancel();
+        }
+    };
+    MLEinfo<aDDM> partial = aDDM::fitModelAnytime(
+        trials, rangeD, rangeSigma, rangeTheta, {0}, "thread", 1, 0, {0}, {0}, 10, 0.1, 10, 
+        options);
+    REQUIRE(!partial.complete);
+    REQUIRE(partial.likelihoods.size() == 12);
+    for (const auto &entry : partial.likelihoods) {
+        REQUIRE(partial.likelihoods.at(partial.optimal) <= entry.second);
+    }
+}
+
+/**
+ * @brief Check that loadDataFromCSV groups unordered rows by subject and trial, accepts CRLF line 
+ * endings and decimal RTs, and reports every malformed row. 
+ * 
+ */
+TEST_CASE("loadDataFromCSV groups rows by subject and trial") {
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::string expFilename = (directory / "addm_test_expdata.csv").string();
+    std::string fixFilename = (directory / "addm_test_fixations.csv").string();
+    std::ofstream(expFilename) << 
+        "parcode,trial,rt,choice,valueLeft,valueRight\n"
+        "1,2,900.000000,1,3,0\r\n"
+        "0,1,1962.000000,-1,15,0\n"
+        "1,0,700,-1,0,3\n"
+        "0,0,2899,1,-10,-15";
+    std::ofstream(fixFilename) << 
+        "parcode,trial,fix_item,fix_time\n"
+        "1,2,1,300\n"
+        "0,0,2,200\n"
+        "1,2,2,600\n"
+        "5,0,1,100\n";
+
+    std::map<int, std::vector<aDDMTrial>> data = loadDataFromCSV(expFilename, fixFilename, 2);
+    REQUIRE(data.size() == 2);
+    REQUIRE(data.at(0).size() == 2);
+    REQUIRE(data.at(0)[0].RT == 2899);
+    REQUIRE(data.at(0)[0].fixItem == std::vector<int>{2});
+    REQUIRE(data.at(0)[1].RT == 1962);
+    REQUIRE(data.at(0)[1].fixItem.empty());
+    REQUIRE(data.at(1)[1].valueLeft == 3);
+    REQUIRE(data.at(1)[1].fixItem == std::vector<int>{1, 2});
+    REQUIRE(data.at(1)[1].fixTime == std::vector<int>{300, 600});
+
+    // Malformed rows are reported with their line instead of aborting the parse. 
+    std::ofstream(fixFilename) << 
+        "parcode,trial,fix_item,fix_time\n"
+        "0,0,2,200\n"
+        "0,0,x,200\n"
+        "0,0,2\n";
+    try {
+        loadDataFromCSV(expFilename, fixFilename);
+        FAIL("malformed rows were accepted");
+    } catch (const std::invalid_argument &e) {
+        std::string message = e.what();
+        REQUIRE(message.find("2 malformed rows") != std::string::npos);
+        REQUIRE(message.find(fixFilename + ":3: field 3 ('x') is not an integer") != 
+            std::string::npos);
+        REQUIRE(message.find(fixFilename + ":4: expected 4 fields, found 3") != 
+            std::string::npos);
+    }
+    std::filesystem::remove(expFilename);
+    std::filesystem::remove(fixFilename);
+}
+
+/**
+ * @brief Check that trials converted to a TrialStore read back unchanged for both CSV layouts, and 
+ * that files that are not trial stores are rejected. 
+ * 
+ */
+TEST_CASE("TrialStore round-trips trials through a mapped file") {
+    std::vector<aDDMTrial> trials = aDDMTrial::loadTrialsFromCSV(ADDM_SIMS);
+    std::string filename = (std::filesystem::temp_directory_path() / "addm_test.trials").string();
+    TrialStore::convertCSV(ADDM_SIMS, filename);
+    TrialStore store(filename);
+    REQUIRE(store.size() == trials.size());
+    REQUIRE(store.fixOffsets()[store.size()] == store.numFixations());
+    std::vector<aDDMTrial> loaded = store.aDDMTrials();
+    for (size_t i = 0; i < trials.size(); i++) {
+        REQUIRE(loaded[i].RT == trials[i].RT);
+        REQUIRE(loaded[i].choice == trials[i].choice);
+        REQUIRE(loaded[i].valueLeft == trials[i].valueLeft);
+        REQUIRE(loaded[i].valueRight == trials[i].valueRight);
+        REQUIRE(loaded[i].fixItem == trials[i].fixItem);
+        REQUIRE(loaded[i].fixTime == trials[i].fixTime);
+    }
+    REQUIRE(store.subjectTrials().at(0).size() == trials.size());
+
+    // The DDM layout has no fixations, and foreign files are rejected. 
+    TrialStore::convertCSV(DDM_SIMS, filename);
+    TrialStore ddmStore(filename);
+    REQUIRE(ddmStore.size() == DDMTrial::loadTrialsFromCSV(DDM_SIMS).size());
+    REQUIRE(ddmStore.numFixations() == 0);
+    REQUIRE(store.size() == trials.size());
+    REQUIRE_THROWS_AS(TrialStore(ADDM_SIMS), std::invalid_argument);
+    std::filesystem::remove(filename);
+}
+
+/**
+ * @brief Check that stores whose counts overflow the column sizes, or whose fixation offsets 
+ * decrease, are rejected instead of read out of bounds. 
+ * 
+ */
+TEST_CASE("TrialStore rejects corrupt counts and offsets") {
+    std::vector<aDDMTrial> trials = load_addm_sims(10);
+    std::string filename = 
+        (std::filesystem::temp_directory_path() / "addm_corrupt.trials").string();
+    auto corrupt = [&](auto edit) {
+        TrialStore::save(filename, trials);
+        std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+        TrialStoreHeader header;
+        file.read((char *) &header, sizeof(header));
+        edit(file, header);
+        file.seekp(0);
+        file.write((const char *) &header, sizeof(header));
+        file.close();
+        REQUIRE_THROWS_AS(TrialStore(filename), std::invalid_argument);
+    };
+
+    // 4 * numTrials and 8 * (numTrials + 1) wrap around to small sizes. 
+    corrupt([](std::fstream &, TrialStoreHeader &header) { header.numTrials = 1ull << 62; });
+    corrupt([](std::fstream &, TrialStoreHeader &header) { header.numFixations = 1ull << 62; });
+    corrupt([](std::fstream &file, TrialStoreHeader &header) {
+        uint64_t offsets[2] = {header.numFixations, 0};
+        file.seekp(header.columns[5] + 8);
+        file.write((const char *) offsets, sizeof(offsets));
+    });
+    std::filesystem::remove(filename);
+}
+
+/**
+ * @brief Check that a TrialBatch unpacks to the same trials, gives the same NLL and grid search 
+ * optimum as the vector of trials, and rejects trials with mismatched fixations. 
+ * 
+ */
+TEST_CASE("TrialBatch packs fixations and matches the vector likelihoods") {
+    std::vector<aDDMTrial> trials = load_addm_sims(200);
+    TrialBatch batch(trials);
+    REQUIRE(batch.size() == trials.size());
+    REQUIRE(batch.fixOffsets.size() == trials.size() + 1);
+    REQUIRE(batch.fixOffsets.back() == batch.numFixations());
+    std::vector<aDDMTrial> unpacked = batch.aDDMTrials();
+    for (size_t i = 0; i < trials.size(); i++) {
+        REQUIRE(unpacked[i].RT == trials[i].RT);
+        REQUIRE(unpacked[i].choice == trials[i].choice);
+        REQUIRE(unpacked[i].fixItem == trials[i].fixItem);
+        REQUIRE(unpacked[i].fixTime == trials[i].fixTime);
+    }
+
+    std::unique_ptr<ComputeBackend> backend = getComputeBackend("basic");
+    aDDM addm(0.005, 0.07, 0.5, 0, 1, 0, 0.1);
+    REQUIRE(backend->computeNLL(addm, batch, 10, 10, 0.1).NLL == 
+        Approx(backend->computeNLL(addm, trials, 10, 10, 0.1).NLL));
+    MLEinfo<aDDM> fromBatch = aDDM::fitModelMLE(
+        batch, {0.003, 0.005}, {0.05, 0.07}, {0.5}, {0}, "basic");
+    MLEinfo<aDDM> fromVector = aDDM::fitModelMLE(
+        trials, {0.003, 0.005}, {0.05, 0.07}, {0.5}, {0}, "basic");
+    REQUIRE(fromBatch.optimal.d == fromVector.optimal.d);
+    REQUIRE(fromBatch.optimal.sigma == fromVector.optimal.sigma);
+
+    aDDMTrial mismatched = trials[0];
+    mismatched.fixTime.pop_back();
+    REQUIRE_THROWS_AS(TrialBatch(std::vector<aDDMTrial>{mismatched}), std::invalid_argument);
+    REQUIRE_THROWS_AS(addm.getTrialLikelihood(mismatched), std::invalid_argument);
+}
+
+/**
+ * @brief Check that the CPU engines compute a range of a TrialBatch in place with the same 
+ * likelihoods as the whole batch, for both models. Prefix sharing splits the trials of a range 
+ * differently, so aDDM likelihoods only agree up to rounding. 
+ * 
+ */
+TEST_CASE("TrialBatch ranges match the whole batch on the CPU") {
+    std::vector<aDDMTrial> trials = load_addm_sims(100);
+    TrialBatch batch(trials);
+    std::vector<float> biases = {0, 0.1};
+    size_t begin = 30;
+    size_t end = 70;
+
+    aDDM addm(0.005, 0.07, 0.5);
+    PropagationOptions options;
+    options.prefixSharing = true;
+    std::vector<ProbabilityData> whole = addm.computeCPUNLL(batch, biases, 10, 10, 0.1, 1, options);
+    std::vector<double> range((end - begin) * biases.size());
+    addm.computeCPULikelihoods(batch, begin, end, biases, range.data(), 10, 10, 0.1, 1, options);
+    DDM ddm(0.005, 0.07);
+    std::vector<ProbabilityData> ddmWhole = ddm.computeCPUNLL(batch, biases);
+    std::vector<double> ddmRange((end - begin) * biases.size());
+    ddm.computeCPULikelihoods(batch, begin, end, biases, ddmRange.data(), 10, 0.1, 1, options);
+    for (size_t i = begin; i < end; i++) {
+        for (int b = 0; b < biases.size(); b++) {
+            REQUIRE(range[(i - begin) * biases.size() + b] == 
+                Approx(whole[b].trialLikelihoods[i]).epsilon(1e-12));
+            REQUIRE(ddmRange[(i - begin) * biases.size() + b] == ddmWhole[b].trialLikelihoods[i]);
+        }
+    }
+}
+
+/**
+ * @brief Check that the TrialBatch overloads of the gradient, model lanes, streaming, anytime and 
+ * optimizer fits give the same results as their vector overloads. 
+ * 
+ */
+TEST_CASE("TrialBatch overloads match the vector engines and fits") {
+    std::vector<aDDMTrial> trials = load_addm_sims(100);
+    TrialBatch batch(trials);
+
+    aDDM addm(0.005, 0.07, 0.5);
+    NLLGradient fromBatch = addm.computeCPUNLLGradient(batch);
+    NLLGradient fromVector = addm.computeCPUNLLGradient(trials);
+    REQUIRE(fromBatch.NLL == fromVector.NLL);
+    REQUIRE(fromBatch.gradient == fromVector.gradient);
+
+    std::vector<aDDM> models = {aDDM(0.004, 0.07, 0.5), aDDM(0.005, 0.08, 0.6, 0.1)};
+    std::vector<ProbabilityData> lanes = aDDM::computeCPUNLLs(models, batch);
+    std::vector<ProbabilityData> vectorLanes = aDDM::computeCPUNLLs(models, trials);
+    for (int m = 0; m < models.size(); m++) {
+        REQUIRE(lanes[m].trialLikelihoods == vectorLanes[m].trialLikelihoods);
+    }
+
+    MLEinfo<aDDM> streamed = aDDM::fitModelStreaming(
+        batch, {0.004, 0.005}, {0.07, 0.08}, {0.5}, {0}, "thread");
+    MLEinfo<aDDM> vectorStreamed = aDDM::fitModelStreaming(
+        trials, {0.004, 0.005}, {0.07, 0.08}, {0.5}, {0}, "thread");
+    REQUIRE(streamed.optimal == vectorStreamed.optimal);
+    MLEinfo<DDM> anytime = DDM::fitModelAnytime(batch, {0.004, 0.005}, {0.07, 0.08}, "thread");
+    MLEinfo<DDM> vectorAnytime = DDM::fitModelAnytime(
+        batch.DDMTrials(), {0.004, 0.005}, {0.07, 0.08}, "thread");
+    REQUIRE(anytime.optimal == vectorAnytime.optimal);
+
+    OptimizerOptions capped;
+    capped.maxEvaluations = 20;
+    MLEinfo<aDDM> simplex = aDDM::fitModelOptimize(
+        batch, {0.001, 0.009}, {0.03, 0.11}, {0.1, 0.9}, {0}, "basic", 1, 0, {0}, {0}, 10, 0.1, 
+        10, std::nullopt, capped);
+    MLEinfo<aDDM> vectorSimplex = aDDM::fitModelOptimize(
+        trials, {0.001, 0.009}, {0.03, 0.11}, {0.1, 0.9}, {0}, "basic", 1, 0, {0}, {0}, 10, 0.1, 
+        10, std::nullopt, capped);
+    REQUIRE(simplex.optimal == vectorSimplex.optimal);
+    REQUIRE(simplex.numEvaluations == vectorSimplex.numEvaluations);
+    MLEinfo<aDDM> lbfgsb = aDDM::fitModelLBFGSB(
+        batch, {0.001, 0.009}, {0.03, 0.11}, {0.1, 0.9}, {0}, 1, 0, 0, 0, 10, 0.1, 0, 
+        std::nullopt, capped);
+    MLEinfo<aDDM> vectorLBFGSB = aDDM::fitModelLBFGSB(
+        trials, {0.001, 0.009}, {0.03, 0.11}, {0.1, 0.9}, {0}, 1, 0, 0, 0, 10, 0.1, 0, 
+        std::nullopt, capped);
+    REQUIRE(lbfgsb.optimal == vectorLBFGSB.optimal);
+    MLEinfo<DDM> ddmSimplex = DDM::fitModelOptimize(
+        batch, {0.001, 0.009}, {0.03, 0.11}, "basic", 1, 0, {0}, {0}, 10, 0.1, 10, 
+        std::nullopt, capped);
+    MLEinfo<DDM> vectorDDMSimplex = DDM::fitModelOptimize(
+        batch.DDMTrials(), {0.001, 0.009}, {0.03, 0.11}, "basic", 1, 0, {0}, {0}, 10, 0.1, 10, 
+        std::nullopt, capped);
+    REQUIRE(ddmSimplex.optimal == vectorDDMSimplex.optimal);
+}
+
+/**
+ * @brief Check that the default support window agrees with propagating the full support within 
+ * its error bound of numTimeSteps * numStates * supportEpsilon per trial, for both models. 
+ * 
+ */
+TEST_CASE("Support window matches the full support within its bound") {
+    std::vector<aDDMTrial> trials = load_addm_sims(100);
+    std::vector<DDMTrial> ddmTrials = load_ddm_sims(100);
+    PropagationOptions windowed;
+    PropagationOptions full;
+    full.supportEpsilon = 0;
+    REQUIRE(windowed.supportEpsilon > 0);
+    int timeStep = 10;
+    float approxStateStep = 0.01;
+    int numStates = 2 / approxStateStep + 1;
+
+    aDDM addm(0.005, 0.07, 0.5);
+    ProbabilityData addmWindowed = addm.computeCPUNLL(
+        trials, 10, timeStep, approxStateStep, 0, windowed);
+    ProbabilityData addmFull = addm.computeCPUNLL(trials, 10, timeStep, approxStateStep, 0, full);
+    for (int i = 0; i < trials.size(); i++) {
+        double bound = (double) trials[i].RT / timeStep * numStates * windowed.supportEpsilon;
+        REQUIRE(std::abs(addmWindowed.trialLikelihoods[i] - addmFull.trialLikelihoods[i]) <= bound);
+    }
+    REQUIRE(addmWindowed.NLL == Approx(addmFull.NLL).epsilon(1e-9));
+
+    DDM ddm(0.005, 0.07);
+    ProbabilityData ddmWindowed = ddm.computeCPUNLL(
+        ddmTrials, timeStep, approxStateStep, 0, windowed);
+    ProbabilityData ddmFull = ddm.computeCPUNLL(ddmTrials, timeStep, approxStateStep, 0, full);
+    for (int i = 0; i < ddmTrials.size(); i++) {
+        double bound = (double) ddmTrials[i].RT / timeStep * numStates * windowed.supportEpsilon;
+        REQUIRE(std::abs(ddmWindowed.trialLikelihoods[i] - ddmFull.trialLikelihoods[i]) <= bound);
+    }
+    REQUIRE(ddmWindowed.NLL == Approx(ddmFull.NLL).epsilon(1e-9));
+}
+
+/**
+ * @brief Check that likelihoods computed from a PropagationCache shared across trials, models 
+ * and repeated calls, including the time-indexed crossing CDFs of decaying barriers, match the 
+ * likelihoods computed with a fresh cache per call. 
+ * 
+ */
+TEST_CASE("Shared PropagationCache matches uncached likelihoods") {
+    std::vector<aDDMTrial> trials = load_addm_sims(50);
+    std::vector<DDMTrial> ddmTrials = load_ddm_sims(50);
+    std::vector<aDDM> models = {
+        aDDM(0.005, 0.07, 0.5), 
+        aDDM(0.005, 0.07, 0.5, 0, 1, 0, 0, 0.01), 
+        aDDM(0.006, 0.07, 0.3, 0, 1, 0, 0, 0.01)};
+    std::vector<DDM> ddmModels = {
+        DDM(0.005, 0.07), 
+        DDM(0.005, 0.07, 1, 100, 0, 0.01), 
+        DDM(0.006, 0.07, 1, 0, 0, 0.01)};
+    PropagationOptions uncached;
+    PropagationOptions shared;
+    shared.cache = std::make_shared<PropagationCache>();
+
+    size_t cachedValues = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        for (aDDM addm : models) {
+            ProbabilityData expected = addm.computeCPUNLL(trials, 10, 10, 0.1, 1, uncached);
+            ProbabilityData actual = addm.computeCPUNLL(trials, 10, 10, 0.1, 1, shared);
+            REQUIRE(actual.trialLikelihoods == expected.trialLikelihoods);
+        }
+        for (DDM ddm : ddmModels) {
+            ProbabilityData expected = ddm.computeCPUNLL(ddmTrials, 10, 0.1, 1, uncached);
+            ProbabilityData actual = ddm.computeCPUNLL(ddmTrials, 10, 0.1, 1, shared);
+            REQUIRE(actual.trialLikelihoods == expected.trialLikelihoods);
+        }
+        // The second pass only hits the entries stored by the first. 
+        if (pass == 0) {
+            cachedValues = shared.cache->size();
+            REQUIRE(cachedValues > 0);
+        } else {
+            REQUIRE(shared.cache->size() == cachedValues);
+        }
+    }
+}